@@ -28,8 +28,10 @@ ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 DEALINGS IN THE SOFTWARE.
 */
 #include "Fixed.h"
+#include "FixedTrig.h"
+#include <cstdlib>
 
-Fixed32::Fixed32( const Fixed16& x )
+Fixed32::Fixed( const Fixed16& x )
     : v(x.Raw())
 {
     v <<= 16;
@@ -56,6 +58,37 @@ Fixed32 operator*(const Fixed32& a, const Fixed32& b ) {
     return Fixed32::FromRaw((a.Raw() >> 16) * (b.Raw() >> 16));
 }
 
+#ifdef FIXED_OVERFLOW_COUNTERS
+FIXED_THREAD_LOCAL fixed_overflow_counters fixed_overflow_count = { 0, 0 };
+#endif
+
+FIXED_THREAD_LOCAL f_uint32 fixed_rounding_state = 2463534242u;
+
+void fixed_seed_rounding(f_uint32 seed)
+{
+    fixed_rounding_state = (seed == 0) ? 2463534242u : seed;
+}
+
+static void (*fixed_overflow_handler)() = 0;
+
+void fixed_set_overflow_handler(void (*handler)())
+{
+    fixed_overflow_handler = handler;
+}
+
+void fixed_overflow_trap()
+{
+#ifdef IOSTREAMS
+    cout << "Fixed OVERFLOW trapped" << endl;
+    throw -1;
+#else
+    if (fixed_overflow_handler)
+        fixed_overflow_handler();
+    else
+        abort();
+#endif
+}
+
 
 Fixed32 reciprocal(const Fixed32& x)
 {
@@ -86,14 +119,6 @@ std::ostream& operator<<(std::ostream& os, const Fixed32& v)
     os << "Fixed32::" << f;
     return os;
 }
-std::ostream& operator<<(std::ostream& os, const Fixed16& v)
-{
-    int32_t x = v.Raw();
-    double f = (x >> 16) + ( ((double) (x & 0xFFFF)) / 65536.0);
-    
-    os << f;
-    return os;
-}
 
 void Fixed32::testharness()
 {
@@ -133,10 +158,41 @@ void Fixed32::testharness()
 }
 
 
-void Fixed16::testharness()
+/* The errors of reciprocal(x), reciprocal(-x) and invsqrt(x) against the correctly rounded results, in LSB */
+static void sweep_errors(f_int32 raw, double& worst_r, double& worst_i)
+{
+    Fixed16 x = Fixed16::FromRaw(raw);
+    double r = 4294967296.0 / double(raw);
+    if (r > 2147483647.0)
+        r = 2147483647.0;    // reciprocal() saturates
+    double er = std::fabs(reciprocal(x).Raw() - r);
+    double en = std::fabs(reciprocal(-x).Raw() + r);
+    double ei = std::fabs(invsqrt(x).Raw() - 65536.0 / std::sqrt(raw / 65536.0));
+    if (er > worst_r) worst_r = er;
+    if (en > worst_r) worst_r = en;
+    if (ei > worst_i) worst_i = ei;
+}
+
+template <> void Fixed16::testharness()
 {
     cout << "Fixed16 testharness" << endl;
 
+    /* These are checked when the testharness is compiled */
+    static_assert(Fixed16::one().Raw() == 0x10000, "one()");
+    static_assert(Fixed16::PI().Raw() == 205887, "PI()");
+    static_assert(Fixed16::PI_OVER_2().Raw() == 102944, "PI_OVER_2()");
+    static_assert(Fixed16::PI_3OVER_2().Raw() == 308831, "PI_3OVER_2()");
+    static_assert(Fixed16(-3) + Fixed16(5) == Fixed16(2), "a + b");
+    static_assert(Fixed16(-3) - Fixed16(5) == Fixed16(-8), "a - b");
+    static_assert((Fixed16(-3) << 2) == Fixed16(-12), "a << 2");
+    static_assert((Fixed16(-12) >> 2) == Fixed16(-3), "a >> 2");
+    static_assert(Fixed16::PI_OVER_2() < Fixed16::PI() && Fixed16::PI() <= Fixed16::PI_3OVER_2(), "comparisons");
+    static_assert(abs(-Fixed16::PI()) == Fixed16::PI(), "abs()");
+#if !defined(NO_64BIT_MULTIPLY) && defined(FIXED16_DEFAULT_ROUNDING)
+    static_assert(Fixed16::FromFixed32(Fixed16(-6) * Fixed16(3)) == Fixed16(-18), "a * b");
+    static_assert(Fixed16(Fixed16::one() * (Fixed16::one() >> 1)) == (Fixed16::one() >> 1), "Fixed16(a * b)");
+#endif
+
     Fixed16 tol(Fixed32(0.001));    // accuracy
 
     Fixed16 a(6);
@@ -147,25 +203,208 @@ void Fixed16::testharness()
     test_result("a * b",Fixed16(a * b), Fixed16(18));
     test_result("a / b",(a / b), Fixed16(2), tol);
 
+    /* 3 PRECISION() * 0.25, three times, is 2.25 PRECISION(). Truncating each product would give 0 */
+    {
+        Fixed16 e = Fixed16::FromRaw(3);
+        Fixed16 h = Fixed16::one() >> 2;
+        Fixed32 acc;
+        Fixed16::mac(acc, e, h);
+        Fixed16::mac(acc, e, h);
+        Fixed16::mac(acc, e, h);
+        test_result("mac() rounds once", Fixed16::FromAccumulator(acc), Fixed16::FromRaw(2));
+        Fixed16::msub(acc, e, h);
+        Fixed16::msub(acc, e, h);
+        Fixed16::msub(acc, e, h);
+        Fixed16::msub(acc, a, b);
+        test_result("msub()", Fixed16::FromAccumulator(acc), Fixed16(-18));
+    }
+
+    /* Fixed16Sat clamps at the ends of the range, Fixed16Trap throws */
+    {
+        const Fixed16Sat big = Fixed16Sat::FromRaw(0x7fffffff);
+        const Fixed16Sat small = Fixed16Sat::FromRaw(f_int32(0x80000000));
+        const Fixed16Sat lsb = Fixed16Sat::FromRaw(1);
+#ifdef FIXED_OVERFLOW_COUNTERS
+        fixed_overflow_count.saturated = 0;
+#endif
+        test_result("Sat max + lsb", (big + lsb).Raw(), big.Raw());
+        test_result("Sat min - lsb", (small - lsb).Raw(), small.Raw());
+        test_result("Sat -min", (-small).Raw(), big.Raw());
+        test_result("Sat -max", (-big).Raw(), small.Raw() + 1);
+        test_result("Sat 3 << 15", (Fixed16Sat(3) << 15).Raw(), big.Raw());
+        test_result("Sat -3 << 15", (Fixed16Sat(-3) << 15).Raw(), small.Raw());
+        test_result("Sat Fixed16Sat(40000)", Fixed16Sat(40000).Raw(), big.Raw());
+        test_result("Sat 300 * -300", Fixed16Sat(Fixed16Sat(300) * Fixed16Sat(-300)).Raw(), small.Raw());
+        Fixed16Sat c(20000);
+        c *= 2;
+        test_result("Sat *= 2", c.Raw(), big.Raw());
+        c = Fixed16Sat(-20000);
+        c -= Fixed16Sat(20000);
+        test_result("Sat -=", c.Raw(), small.Raw());
+#ifdef FIXED_OVERFLOW_COUNTERS
+        test_result("Sat overflows counted", f_int32(fixed_overflow_count.saturated), 9);
+#endif
+        /* Results that fit are the same as Fixed16 */
+        test_result("Sat a + b", Fixed16Sat(6) + Fixed16Sat(-9), Fixed16Sat(-3));
+        test_result("Sat a * b", Fixed16Sat(Fixed16Sat(-6) * Fixed16Sat(3)), Fixed16Sat(-18));
+        test_result("Sat (max - lsb) + lsb", ((big - lsb) + lsb).Raw(), big.Raw());
+
+        bool trapped = false;
+        try
+        {
+            Fixed16Trap t = Fixed16Trap(30000) + Fixed16Trap(30000);
+            cout << "Trap did not trap: " << t << endl;
+        }
+        catch (int)
+        {
+            trapped = true;
+        }
+        test_result("Trap 30000 + 30000 traps", trapped, true);
+        test_result("Trap a - b", Fixed16Trap(30000) - Fixed16Trap(-2767), Fixed16Trap(32767));
+    }
+
+    /* Ints and casts into an f_int16 are checked before they are narrowed, so 65537 does not wrap to 1 */
+    {
+        typedef Fixed<8,8,f_int16,fixed_saturate> Q8_8Sat;
+        typedef Fixed<1,15,f_int16,fixed_saturate> Q1_15Sat;
+        test_result("Sat Q8_8(65537)", f_int32(Q8_8Sat(65537).Raw()), 32767);
+        test_result("Sat Q8_8(-65535)", f_int32(Q8_8Sat(-65535).Raw()), -32768);
+        Q8_8Sat q;
+        q = 65537;
+        test_result("Sat Q8_8 = 65537", f_int32(q.Raw()), 32767);
+        q = -127;
+        test_result("Sat Q8_8 = -127", f_int32(q.Raw()), -127 * 256);
+        test_result("Sat fixed_cast 2", f_int32(fixed_cast<Q1_15Sat>(Fixed16(2)).Raw()), 32767);
+        test_result("Sat fixed_cast -2", f_int32(fixed_cast<Q1_15Sat>(Fixed16(-2)).Raw()), -32768);
+        test_result("Sat fixed_cast -1", f_int32(fixed_cast<Q1_15Sat>(Fixed16(-1)).Raw()), -32768);
+        test_result("Sat fixed_cast 0.5", f_int32(fixed_cast<Q1_15Sat>(Fixed16::one() >> 1).Raw()), 16384);
+    }
+
+    /* Products of 1.5, 2.5, -1.5 and -2.5 PRECISION() and 1, then 1.25 PRECISION() */
+    {
+        typedef Fixed<16,16,f_int32,fixed_wrap,fixed_truncate> Trunc;
+        typedef Fixed<16,16,f_int32,fixed_wrap,fixed_round_half_up> HalfUp;
+        typedef Fixed<16,16,f_int32,fixed_wrap,fixed_round_half_even> HalfEven;
+        const f_int32 raw[5] = { 3, 5, -3, -5, 5 };
+        const f_int32 shift[5] = { 1, 1, 1, 1, 2 };
+        const f_int32 trunc[5] = { 1, 2, -2, -3, 1 };
+        const f_int32 half_up[5] = { 2, 3, -1, -2, 1 };
+        const f_int32 half_even[5] = { 2, 2, -2, -2, 1 };
+        int mismatches = 0;
+        for (int i = 0; i < 5; i++)
+        {
+            if (Trunc(Trunc::FromRaw(raw[i]) * (Trunc::one() >> shift[i])).Raw() != trunc[i]) mismatches++;
+            if (HalfUp(HalfUp::FromRaw(raw[i]) * (HalfUp::one() >> shift[i])).Raw() != half_up[i]) mismatches++;
+            if (HalfEven(HalfEven::FromRaw(raw[i]) * (HalfEven::one() >> shift[i])).Raw() != half_even[i]) mismatches++;
+
+            HalfEven x = HalfEven::FromRaw(raw[i]);
+            x *= (HalfEven::one() >> shift[i]);
+            if (x.Raw() != half_even[i]) mismatches++;
+            if (HalfUp::FromFixed32(HalfUp::FromRaw(raw[i]) * (HalfUp::one() >> shift[i])).Raw() != half_up[i]) mismatches++;
+        }
+        test_result("rounding policy mismatches", mismatches, 0);
+
+        /* Add 1.5 PRECISION() a million times: truncation drifts down, stochastic rounding does not */
+        typedef Fixed<16,16,f_int32,fixed_wrap,fixed_round_stochastic> Stoch;
+        fixed_seed_rounding(1);
+        Trunc t_sum(0);
+        Stoch s_sum(0);
+        const Trunc t_q = Trunc::FromRaw(3);
+        const Stoch s_q = Stoch::FromRaw(3);
+        for (int i = 0; i < 1 << 20; i++)
+        {
+            t_sum += Trunc(t_q * (Trunc::one() >> 1));
+            s_sum += Stoch(s_q * (Stoch::one() >> 1));
+        }
+        test_result("truncated sum of 2^20 * 1.5 lsb", t_sum.Raw(), f_int32(1 << 20));
+        test_result("stochastic sum of 2^20 * 1.5 lsb", s_sum.toDouble() / (1.5 * (1 << 20) / 65536.0), 1.0, 0.002);
+    }
+
+    /* div_by<N> against integer division, for awkward divisors and dividends */
+    {
+        const f_int32 n[] = { 0, 1, -1, 7, -7, 65535, -65536, 123456789, -987654321,
+                              0x7fffffff, f_int32(0x80000001u), f_int32(0x80000000u) };
+        int mismatches = 0;
+        for (unsigned i = 0; i < sizeof(n) / sizeof(n[0]); i++)
+        {
+            /* The last one is -2^31, which does not have an integer quotient by -1 */
+            const f_int32 raw = n[i];
+            Fixed16 x = Fixed16::FromRaw(raw);
+            if (div_by<2>(x).Raw() != raw / 2) mismatches++;
+            if (div_by<3>(x).Raw() != raw / 3) mismatches++;
+            if (div_by<7>(x).Raw() != raw / 7) mismatches++;
+            if (div_by<10>(x).Raw() != raw / 10) mismatches++;
+            if (div_by<1000>(x).Raw() != raw / 1000) mismatches++;
+            if (div_by<65536>(x).Raw() != raw / 65536) mismatches++;
+            if (div_by<641>(x).Raw() != raw / 641) mismatches++;
+            if (div_by<-5>(x).Raw() != raw / -5) mismatches++;
+            if (div_by<-8>(x).Raw() != raw / -8) mismatches++;
+            if (div_by<0x7fffffff>(x).Raw() != raw / 0x7fffffff) mismatches++;
+            if (div_by<1>(x).Raw() != raw) mismatches++;
+            if (raw != f_int32(0x80000000u) && div_by<-1>(x).Raw() != -raw) mismatches++;
+        }
+        /* And every Q8.24 in a sweep, by a divisor that needs the add back */
+        for (f_int32 raw = -(1 << 30); raw < (1 << 30); raw += 9973)
+            if (div_by<7>(FixedQ8_24::FromRaw(raw)).Raw() != raw / 7)
+                mismatches++;
+        test_result("div_by<N> mismatches", mismatches, 0);
+#if !defined(NO_64BIT_MULTIPLY)
+        static_assert(div_by<1000>(Fixed16::one()).Raw() == 65, "div_by<1000>(one())");
+#endif
+        static_assert(div_by<4>(-Fixed16::PI()).Raw() == -205887 / 4, "div_by<4>(-PI())");
+    }
+
+    /* Fixed16Divider against 64 bit division, rounded half away from zero, wherever the quotient fits */
+    {
+        int mismatches = 0;
+        f_uint32 seed = 1;
+        for (int i = 0; i < 2000; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            f_int32 draw = f_int32(seed) >> (seed & 31);
+            if (draw == 0)
+                draw = 1;
+            Fixed16Divider by(Fixed16::FromRaw(draw));
+            for (int j = 0; j < 50; j++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                f_int32 xraw = f_int32(seed) >> (j & 31);
+                int64_t num = int64_t(xraw < 0 ? -int64_t(xraw) : xraw) << 16;
+                int64_t den = (draw < 0) ? -int64_t(draw) : draw;
+                int64_t q = (2 * num + den) / (2 * den);
+                if (q > 0x7fffffff)
+                    continue;
+                if (((xraw < 0) != (draw < 0)))
+                    q = -q;
+                if ((Fixed16::FromRaw(xraw) / by).Raw() != q)
+                    mismatches++;
+            }
+        }
+        test_result("Fixed16Divider mismatches", mismatches, 0);
+        test_result("a / Fixed16Divider(b)", a / Fixed16Divider(b), Fixed16(2));
+        test_result("x / Fixed16Divider(0)", a / Fixed16Divider(Fixed16(0)), Fixed16(0));
+        test_result("Fixed16Divider(-3).divisor()", Fixed16Divider(Fixed16(-3)).divisor(), Fixed16(-3));
+    }
+
     Fixed16 zero(0);
 
     test_result("arctan2(0,1)",arctan2(zero,one()), Fixed16::zero());
     test_result("arctan2(0,-1)",arctan2(zero,-one()), Fixed16::PI(), tol);
-    test_result("arctan2(1,1)",arctan2(one(),one()), Fixed16::PI()/4, tol);
-    test_result("arctan2(1,0)",arctan2(one(),zero), Fixed16::PI()/2, tol);
-    test_result("arctan2(1,-1)",arctan2(one(),-one()), Fixed16::PI() - Fixed16::PI()/4, tol << 4);
-    test_result("arctan2(-1,1)",arctan2(-one(),one()), -Fixed16::PI()/4, tol << 4);
-    test_result("arctan2(-1,0)",arctan2(-one(),zero), -Fixed16::PI()/2, tol);
-    test_result("arctan2(-1,-1)",arctan2(-one(),-one()), -Fixed16::PI()  + Fixed16::PI()/4, tol);
+    test_result("arctan2(1,1)",arctan2(one(),one()), div_by<4>(Fixed16::PI()), tol);
+    test_result("arctan2(1,0)",arctan2(one(),zero), div_by<2>(Fixed16::PI()), tol);
+    test_result("arctan2(1,-1)",arctan2(one(),-one()), Fixed16::PI() - div_by<4>(Fixed16::PI()), tol << 4);
+    test_result("arctan2(-1,1)",arctan2(-one(),one()), -div_by<4>(Fixed16::PI()), tol << 4);
+    test_result("arctan2(-1,0)",arctan2(-one(),zero), -div_by<2>(Fixed16::PI()), tol);
+    test_result("arctan2(-1,-1)",arctan2(-one(),-one()), -Fixed16::PI()  + div_by<4>(Fixed16::PI()), tol);
 
-    Fixed16 pi4 = Fixed16::PI()/4;
+    Fixed16 pi4 = div_by<4>(Fixed16::PI());
 
     test_result("arcsin(sin(pi/4))", arcsin(sin(pi4)), pi4, tol);
     test_result("arcsin(sin(-pi/4))", arcsin(sin(-pi4)), -pi4, tol);
     test_result("arccos(cos(pi/4))", arccos(cos(pi4)), pi4, tol);
     test_result("arccos(cos(-pi/4))", arccos(cos(-pi4)), pi4, tol);
 
-    Fixed16 pi32 = (Fixed16::PI()/2)*3;
+    Fixed16 pi32 = div_by<2>(Fixed16::PI())*3;
 
     test_result("arccos(cos(3 pi/2))", arccos(cos(pi32)), pi32 - Fixed16::PI(), tol); //answers in range 0 - PI/2
     test_result("arccos(cos(-3 pi/2))", arccos(cos(-pi32)), pi32 - Fixed16::PI(), tol);//answers in range 0 - PI/2
@@ -174,9 +413,9 @@ void Fixed16::testharness()
     test_result("sqrt(9)", sqrt(Fixed16(9)), Fixed16(3), tol);
     test_result("sqrt(64)", sqrt(Fixed16(64)), Fixed16(8), tol);
 
-    test_result("invsqrt(4)", invsqrt(Fixed16(4)), one()/2, tol);
-    test_result("invsqrt(9)", invsqrt(Fixed16(9)), one()/3, tol);
-    test_result("invsqrt(64)", invsqrt(Fixed16(64)), one()/8, tol);
+    test_result("invsqrt(4)", invsqrt(Fixed16(4)), div_by<2>(one()), tol);
+    test_result("invsqrt(9)", invsqrt(Fixed16(9)), div_by<3>(one()), tol);
+    test_result("invsqrt(64)", invsqrt(Fixed16(64)), div_by<8>(one()), tol);
     
     Fixed16 tol2(Fixed32(0.01));    // accuracy
     for (int i=1;i<1000;i++)
@@ -187,11 +426,62 @@ void Fixed16::testharness()
         cout << "invsqrt(" << ii << ")";
         test_result(" ", invsqrt(ii), sqrt(Fixed16(i)), Fixed16(tol2*invsqrt(ii)));
     }
+
+    /*
+    * Sweep raw 1 to 64, where the results are largest, every power of two
+    * and every 97th positive Fixed16 after that. Over every positive Fixed16
+    * the worst cases are 0.5 LSB for reciprocal() and 0.5037 LSB for
+    * invsqrt(), at raw 13.
+    */
+    double worst_r = 0;
+    double worst_i = 0;
+    for (int64_t raw = 1; raw <= 0x7FFFFFFF; raw += (raw < 64) ? 1 : 97)
+        sweep_errors(f_int32(raw), worst_r, worst_i);
+    for (int k = 0; k < 31; k++)
+        sweep_errors(f_int32(1) << k, worst_r, worst_i);
+#if FIXED_RECIPROCAL_ITERATIONS >= 2
+    test_result("reciprocal error (LSB)", worst_r, 0.0, 0.5);
+    test_result("reciprocal(2^-14)", reciprocal(Fixed16::FromRaw(4)).Raw(), f_int32(1) << 30);
+    test_result("reciprocal(3 * 2^-16)", reciprocal(Fixed16::FromRaw(3)).Raw(), f_int32(1431655765));
+    test_result("reciprocal(2^-12)", reciprocal(Fixed16::FromRaw(16)).Raw(), f_int32(1) << 28);
+#endif
+    /* The most negative Fixed16 has no positive counterpart, and 1/-32768 is exact */
+    test_result("reciprocal(-32768)", reciprocal(Fixed16::FromRaw(f_int32(0x80000000u))), Fixed16::FromRaw(-2));
+#if FIXED_INVSQRT_ITERATIONS >= 2
+    test_result("invsqrt error (LSB)", worst_i, 0.0, 0.504);
+#endif
+
+    /* sqrt(Fixed32) and invsqrt_wide() over every size of input, up to sqrt(x) = 32768 */
+    double worst_s = 0;
+    double worst_w = 0;
+    f_uint32 bits = 987654321;
+    for (int i = 0; i < 20000; i++)
+    {
+        bits = bits * 1664525u + 1013904223u;
+        int size = 1 + i % 62;
+        f_int64 raw = (f_int64(0, bits) << 30) >> (62 - size);
+        if (raw <= f_int64(0))
+            raw = f_int64(1);
+        Fixed32 x = Fixed32::FromRaw(raw);
+        double xd = double(raw.GetHi()) * 4294967296.0 + double(raw.GetLo());
+
+        double es = std::fabs(sqrt(x).Raw() - std::sqrt(xd));
+        if (es > worst_s) worst_s = es;
+
+        int shift;
+        f_int32 r_q30 = invsqrt_wide(x, shift);
+        double r = std::ldexp(double(r_q30), shift - 30);
+        double ew = std::fabs(r * std::sqrt(xd / 4294967296.0) - 1.0);
+        if (ew > worst_w) worst_w = ew;
+    }
+    test_result("sqrt(Fixed32) error (LSB)", worst_s, 0.0, 0.5);
+    test_result("invsqrt_wide relative error * 2^28", std::ldexp(worst_w, 28), 0.0, 1.0);
+    test_result("sqrt(Fixed32(25))", sqrt(Fixed32(25)), Fixed16(5));
 }
 
 uint32_t seed = 123456789;
 
-Fixed16 Fixed16::rand(int32_t x)
+template <> Fixed16 Fixed16::rand(int x)
 {
     static const uint32_t a = 1103515245;
     static const uint32_t c = 12345;
@@ -203,28 +493,6 @@ Fixed16 Fixed16::rand(int32_t x)
 #endif /* IOSTREAMS */
 
 
-Fixed16 Fixed16::zero()
-{
-    return FromRaw(0);
-}
-Fixed16 Fixed16::one()
-{
-    return FromRaw(65536);
-}
-Fixed16 Fixed16::PI()
-{
-    return FromRaw(205887);
-}
-Fixed16 Fixed16::PI_OVER_2()
-{
-    return FromRaw(102944);
-}
-Fixed16 Fixed16::PI_3OVER_2()
-{
-    return FromRaw(308831);
-}
-
-
 /**********************************************************************/
 uint32_t divmodsi4(bool modwanted, uint32_t num, uint32_t den);
 int32_t __modsi3 (int32_t numerator, int32_t denominator);
@@ -320,63 +588,134 @@ inline int32_t __udivsi3 (uint32_t numerator, uint32_t denominator)
 
 /**********************************************************************/
 
+/*!\brief Newton's method seeds for reciprocal() and invsqrt(), in Q30
+
+    reciprocal[i] is 1/d at the middle of [0.5 + i/128, 0.5 + (i+1)/128).
+    invsqrt[i] is 1/sqrt(d) at the middle of [0.25 + i/128, 0.25 + (i+1)/128),
+    and invsqrt[32+i] is the same on [0.5 + i/64, 0.5 + (i+1)/64).
+    Each seed is good to about 7 bits, and each Newton step doubles that.
+*/
+struct fixed_seed_table
+{
+    f_uint32 reciprocal[64];
+    f_uint32 invsqrt[64];
+
+    constexpr fixed_seed_table() : reciprocal(), invsqrt() {
+        for (int i = 0; i < 64; i++)
+            reciprocal[i] = q30(1.0 / (0.5 + (i + 0.5) / 128));
+        for (int i = 0; i < 32; i++)
+        {
+            invsqrt[i] = q30(inv_sqrt(0.25 + (i + 0.5) / 128));
+            invsqrt[32 + i] = q30(inv_sqrt(0.5 + (i + 0.5) / 64));
+        }
+    }
+
+private:
+    static constexpr f_uint32 q30(double x) { return f_uint32(x * 1073741824.0 + 0.5); }
+
+    /* 1/sqrt(d) by Newton's method, for 0.25 <= d < 1 */
+    static constexpr double inv_sqrt(double d) {
+        double r = 1.0;
+        for (int i = 0; i < 40; i++)
+            r = r * (3.0 - d * r * r) / 2;
+        return r;
+    }
+};
+
+static constexpr fixed_seed_table seed_table = fixed_seed_table();
+
+/* The Q30 part of a Q60 product, and half of it */
+static inline f_uint32 shr30(const f_uint64& p) { return (p.GetHi() << 2) | (p.GetLo() >> 30); }
+static inline f_uint32 shr31(const f_uint64& p) { return (p.GetHi() << 1) | (p.GetLo() >> 31); }
+
+f_uint32 reciprocal_q30(f_uint32 d)
+{
+    f_uint32 y = seed_table.reciprocal[(d >> 25) & 63];
+    for (int i = 0; i < FIXED_RECIPROCAL_ITERATIONS; i++)
+    {
+        f_uint32 e = f_uint64::umult32(d, y).GetHi();   // d*y in Q30
+        y = shr30(f_uint64::umult32(y, (f_uint32(2) << 30) - e));
+    }
+    return y;
+}
+
+/*!\brief 1/sqrt(d) in Q30, for a Q32 d with 0.25 <= d < 1, from the seed
+    table and the given number of Newton steps
+*/
+static f_uint32 invsqrt_q30(f_uint32 d, int iterations)
+{
+    f_uint32 y = (d >> 31) ? seed_table.invsqrt[32 + ((d >> 26) & 31)] : seed_table.invsqrt[(d >> 25) & 31];
+    for (int i = 0; i < iterations; i++)
+    {
+        f_uint32 dy = f_uint64::umult32(d, y).GetHi();  // d*y in Q30
+        f_uint32 dyy = shr30(f_uint64::umult32(dy, y)); // d*y*y in Q30
+        y = shr31(f_uint64::umult32(y, (f_uint32(3) << 30) - dyy));
+    }
+    return y;
+}
+
+/*!\brief Calculate 1/x by Newton's method
+
+    |x| is normalised with a count of the leading zeros to d * 2^-n, with
+    0.5 <= d < 1. A table indexed by the top bits of d gives 1/d to about
+    7 bits, then FIXED_RECIPROCAL_ITERATIONS Newton steps
+
+        y = y * (2 - d*y)
+
+    refine it. The result is 1/d * 2^n, and the remainder of 2^32 / |x|
+    then corrects it by a few LSB to 1/x rounded to nearest. Results too
+    large for a Fixed16 saturate.
+*/
 Fixed16 reciprocal(const Fixed16& x)
 {
-    /*
-        We lose a little precision here with the division
-        because we would saturate if we actually did the correct
-        division of 1 by x. Instead we divide 1/8 by x and multiply
-        the answer by 8.
-    */
-#if 0
-    f_int32 ret = (__divsi3(1 << 30, x.Raw()) + 1)  >> 1;
-    return Fixed16::FromRaw(ret <<  3);
-    
-#else
-    /*
-        Use Newtons Method to calculate the reciprocal
-        
-        f(x) = y = 1/x
-        g(y) = y2 = x, the inverse function of f(x)
-        g'(y) = 1, the derivative of the inverse function
-        
-        
-        Set up the iteration:
-        
-        yn+1 = yn - (g(yn) - x)/g'(yn)
-        
-        y = 2*y - x*y*y
-        
-        
-        y2 = y1 * (two - x*y1);
-    */
-    Fixed16 two(2);
-    
-    f_int32 guess = 1;
-    f_int32 max = 1 << 30;
-    f_int32 raw = abs(x).Raw();
-    
-    while ((max > 0) && ((max & raw) == 0))
+    f_int32 raw = x.Raw();
+    if (raw == 0)
     {
-        max = max >> 1;
-        guess = guess << 1;
+#ifdef DEBUGGING
+        cout << "Error. reciprocal called on zero" << endl;
+        throw -1;
+#endif
+        return Fixed16::zero();
     }
-    
-    Fixed16 y1;
-    if (x > Fixed16::zero())
-        y1 = Fixed16::FromRaw(guess);
+
+    f_uint32 a = (raw < 0) ? 0u - f_uint32(raw) : f_uint32(raw);
+    int n = f_clz32(a);
+    f_uint32 d = a << n;    // Q32, 0.5 <= d < 1
+    f_uint32 y = reciprocal_q30(d);
+
+    /* 1/x in Q16 is y * 2^(n-30), which is within a few LSB of 2^32 / a */
+    f_uint32 ret;
+    if (n < 30)
+        ret = (y + (f_uint32(1) << (29 - n))) >> (30 - n);
+    else if (n == 30)
+        ret = y;
     else
-        y1 = -Fixed16::FromRaw(guess);
-    
-    // Do six iterations (nice balance between speed and accuracy)
-    for (int i=6;i>0;i--)
+        ret = 0xFFFFFFFF;   // a = 1, too large however it is rounded
+
+    /* u = 2^32 - ret*a + a/2 must lie in [0, a) for ret to be 2^32 / a rounded */
+    if (n < 31)
     {
-        y1 = y1 * (two - x*y1);
+        f_uint64 p = f_uint64::umult32(ret, a);
+        f_uint32 half = a >> 1;
+        f_uint32 u_lo = half - p.GetLo();
+        f_int32 u_hi = f_int32(1 - p.GetHi() - (half < p.GetLo()));
+        while (u_hi < 0)
+        {
+            ret--;
+            u_lo += a;
+            u_hi += (u_lo < a);
+        }
+        while (u_hi > 0 || u_lo >= a)
+        {
+            ret++;
+            u_hi -= (u_lo < a);
+            u_lo -= a;
+        }
     }
-    
-    return y1;
-    
-#endif
+    if (ret > 0x7FFFFFFF)
+        ret = 0x7FFFFFFF;
+
+    return Fixed16::FromRaw((raw < 0) ? -f_int32(ret) : f_int32(ret));
 }
     
 
@@ -454,7 +793,7 @@ Fixed16 sqrt(const Fixed16& x)
     // Do 6 iterations
     for (int i = 0; i < 6; i++)
     {
-        y = (y + (x/y)) / 2;
+        y = div_by<2>(y + (x/y));
     }
     return y;
 #endif
@@ -463,6 +802,15 @@ Fixed16 sqrt(const Fixed16& x)
 
 
 /*!\brief Calculate the inverse square root
+
+    x is normalised with a count of the leading zeros to d * 4^-k, with
+    0.25 <= d < 1. A table indexed by the top bits of d gives 1/sqrt(d) to
+    about 7 bits, then FIXED_INVSQRT_ITERATIONS Newton steps
+
+        y = y * (3 - d*y*y) / 2
+
+    refine it. The result is 1/sqrt(d) * 2^k, rounded to within 0.504 LSB
+    of 1/sqrt(x) (the worst case is raw 13).
 */
 Fixed16    invsqrt(const Fixed16& x)
 {
@@ -474,78 +822,157 @@ Fixed16    invsqrt(const Fixed16& x)
 #endif
         return Fixed16::zero();
     }
-    Fixed16 y = x;        // starting approximation
-    int n = 0;
-    if (y < Fixed16::one())
-    {
-        while (y < Fixed16::one())
-        {
-            y = y << 2;    // multiply by 4
-            n += 1;
-        }
-        y = Fixed16::one() << (n-1);
-    }
-    else if (y > Fixed16::one())
+
+    f_uint32 a = f_uint32(x.Raw());
+    int n = f_clz32(a);
+    f_uint32 d = a << n;    // Q32, x = d * 2^(16 - n)
+    int e = 16 - n;
+
+    if (e & 1)
     {
-        while (y > Fixed16::one())
-        {
-            y = y >> 2;    // divide by 4
-            n += 1;
-        }
-        y = Fixed16::one() >> n;
+        d >>= 1;            // make the exponent even, 0.25 <= d < 0.5
+        e += 1;
     }
-//    cout << "Approximation invsqrt(" << x << ") = " << y << endl;
-    
-    Fixed32 three = Fixed32(int32_t(3));
-    Fixed16 half = Fixed16::one() >> 1;
-    for (int i = 5; i > 0; i--)
+    f_uint32 y = invsqrt_q30(d, FIXED_INVSQRT_ITERATIONS);
+
+    /* 1/sqrt(x) in Q16 is y * 2^(-14 - e/2), and 7 <= 14 + e/2 <= 22 */
+    int shift = 14 + e / 2;
+    return Fixed16::FromRaw(f_int32((y + (f_uint32(1) << (shift - 1))) >> shift));
+}
+
+
+/*!\brief Normalise a positive 64 bit x to d * 4^e, with d in Q32 and
+    0.25 <= d < 1, from a count of the leading zeros. Any bits of x below the
+    32 kept in d are dropped.
+*/
+static f_uint32 normalise_q32(const f_int64& x, int& e)
+{
+    f_uint32 hi = f_uint32(x.GetHi());
+    int bits = (hi != 0) ? 64 - f_clz32(hi) : 32 - f_clz32(x.GetLo());
+    int t = bits - 32;
+    if (t & 1)
+        t += 1;     // an even shift, which leaves 31 or 32 bits
+    e = t / 2;
+    return (t >= 0) ? (x >> t).GetLo() : (x.GetLo() << -t);
+}
+
+/*!\brief Calculate 1/sqrt(x) for a positive Fixed32 of any size, as
+    r * 2^shift with r in Q30 (0.5 < r <= 1), so that no bits are lost.
+
+    x is normalised as by invsqrt(), but from the leading zeros of all 64
+    bits, and one more Newton step is taken for the extra precision.
+*/
+f_int32 invsqrt_wide(const Fixed32& x, int& shift)
+{
+    if (x.Raw() <= f_int64(0))
     {
-        y = half*y*(three - x*y*y);
-//        cout << "y=" << y << endl;
+#ifdef DEBUGGING
+        cout << "Error. invsqrt_wide called on negative number: " << x << endl;
+        throw -1;
+#endif
+        shift = 0;
+        return 0;
     }
-    return y;
-//    return reciprocal(sqrt(x));
-}
 
+    int e;
+    f_uint32 y = invsqrt_q30(normalise_q32(x.Raw(), e), FIXED_INVSQRT_ITERATIONS + 1);
 
-/*!\brief Calculate square-root of a Fixed32 (32.32) fixed point number. 
-    (approximate) by normalizing the number to 16:16 and
-    then renormalizing the sqrt.
-    
-    We do this because we would like to be able to normalize vectors
-    with co-efficients larger than 256. So if the number is small enough
-    we just take the sqrt(). However if the number is too big we divide
-    it down by powers of 4. For each division by 4, we multiply the
-    result by two since
-        sqrt(x / 4^n)     == sqrt(x)/2^n
-    so    sqrt(x)        == 2^n * sqrt(x / 4^n)
+    /* x = d * 4^e in Q32, so 1/sqrt(x) = (y / 2) * 2^(1 - e) */
+    shift = 1 - e;
+    return f_int32((y + 1) >> 1);
+}
 
+/*!\brief Calculate the square root of a Fixed32, correctly rounded.
 
+    x is normalised from the leading zeros of all 64 bits to d * 4^e, so
+    that sqrt(x) = d * invsqrt(d) * 2^e. That is within a few PRECISION(),
+    and comparing its square with x puts it right. Returns zero for x <= 0.
+    The result must be less than 32768, so x must be less than 2^30.
 */
 Fixed16 sqrt(const Fixed32& x)
 {
-    if (x.is_Fixed16_compatable())
-        return sqrt(Fixed16::FromFixed32(x));
-        
-    Fixed32 t(x);
-    int n = 0;
-    while (false == t.is_Fixed16_compatable())
+    if (x.Raw() <= f_int64(0))
     {
-        t.shiftr(2);    // divide by 4
-        n += 1;
+#ifdef DEBUGGING
+        cout << "Error. sqrt called on negative number: " << x << endl;
+        throw -1;
+#endif
+        return Fixed16::zero();
     }
-    
-    Fixed16 ret = Fixed16::FromFixed32(t);        // now coerce to Fixed16
-    ret = sqrt(ret);    // and take the sqrt()
-    ret = (ret << n);    // multiply by 2^n
-    return ret;
+
+    int e;
+    f_uint32 d = normalise_q32(x.Raw(), e);
+    f_uint32 y = invsqrt_q30(d, FIXED_INVSQRT_ITERATIONS + 1);
+
+    /* d * y is sqrt(d) in Q62, and Q16 is 46 - e bits further down, 30 to 61 */
+    int shift = 46 - e;
+    f_uint64 r = (f_uint64::umult32(d, y) + (f_uint64(1u) << (shift - 1))) >> shift;
+
+    /* Round to nearest: (r - 1/2)^2 <= x < (r + 1/2)^2, or r^2 - r < x <= r^2 + r in Q32 */
+    f_uint64 x2(x.Raw());
+    f_uint32 root = r.GetLo();
+    while (f_uint64::umult32(root, root) + root < x2)
+        root++;
+    while (f_uint64::umult32(root, root) >= x2 + root)
+        root--;
+
+    typedef Fixed16::overflow_policy P;
+    return Fixed16::FromRaw(P::narrow_shr<f_int32>(f_int64(f_int32(0), root), 0));
 }
 
 
-/*!\brief Calculate sin(x) where x is in radians (0 <= x <= 2PI)
-*/    
+/*!\brief Calculate sin(x) where x is in radians (-2PI <= x <= 2PI).
+    Uses sin_lut() instead if FIXED_TRIG_LUT is defined.
+*/
 Fixed16 sin(const Fixed16& x)
 {
+#ifdef FIXED_TRIG_LUT
+    return sin_lut(x);
+#else
+    return sin_poly(x);
+#endif
+}
+
+/*!\brief Calculate cos(f), f in radians.
+    Uses cos_lut() instead if FIXED_TRIG_LUT is defined.
+*/
+Fixed16 cos(const Fixed16& f)
+{
+#ifdef FIXED_TRIG_LUT
+    return cos_lut(f);
+#else
+    return cos_poly(f);
+#endif
+}
+
+/*!\brief Calculate tan(f), f is in radians (0 <= f <= PI/4)
+    Uses tan_lut() instead if FIXED_TRIG_LUT is defined.
+*/
+Fixed16 tan(const Fixed16& f)
+{
+#ifdef FIXED_TRIG_LUT
+    return tan_lut(f);
+#else
+    return tan_poly(f);
+#endif
+}
+
+/*!\brief Calculate sin(f) and cos(f) together, f in radians (-2PI <= f <= 2PI).
+    Uses sincos_lut() instead if FIXED_TRIG_LUT is defined.
+*/
+void sincos(const Fixed16& f, Fixed16& s, Fixed16& c)
+{
+#ifdef FIXED_TRIG_LUT
+    sincos_lut(f, s, c);
+#else
+    sincos_poly(f, s, c);
+#endif
+}
+
+/*!\brief Calculate sin(x) where x is in radians (-2PI <= x <= 2PI), by a 5th order polynomial
+*/    
+Fixed16 sin_poly(const Fixed16& x)
+{
 #ifdef IOSTREAMS
     double xd = x.toDouble();
     if ((xd > 6.28) || (xd < -6.28))
@@ -555,7 +982,7 @@ Fixed16 sin(const Fixed16& x)
     }
 #endif
     if (x < Fixed16::zero())
-        return -sin(-x);
+        return -sin_poly(-x);
 
     Fixed16 f(x);
     int sign = 1;
@@ -585,16 +1012,16 @@ Fixed16 sin(const Fixed16& x)
     #define CK1 2428
     #define CK2 32551
     
-/*!\brief Calculate cos(f), f in radians.
+/*!\brief Calculate cos(f), f in radians, by a 4th order polynomial.
     calculates for -inf <= f <= inf, using 0 <= f <= PI/2
 */
-Fixed16 cos(const Fixed16& f)
+Fixed16 cos_poly(const Fixed16& f)
 {
     if (f < Fixed16::zero())            //covers negatives
-        return cos(-f);
+        return cos_poly(-f);
 
     if (f > Fixed16::PI_OVER_2())            //extends range
-        return -cos(f - Fixed16::PI());
+        return -cos_poly(f - Fixed16::PI());
 
     Fixed16 sqr = Fixed16::FromFixed32(f*f);
     Fixed16 result = Fixed16::FromRaw(CK1);
@@ -606,12 +1033,69 @@ Fixed16 cos(const Fixed16& f)
 }
     
     
+/*!\brief Calculate sin(x) and cos(x) where x is in radians (-2PI <= x <= 2PI).
+    Gives the same results as sin_poly() and cos_poly(), but reduces x to
+    0 <= f <= PI/2 and squares it only once.
+*/
+void sincos_poly(const Fixed16& x, Fixed16& s, Fixed16& c)
+{
+#ifdef IOSTREAMS
+    double xd = x.toDouble();
+    if ((xd > 6.28) || (xd < -6.28))
+    {
+        cerr << "Fixed16::sincos(" << xd << ") out of range" << endl;
+        throw -1;
+    }
+#endif
+    /* sin is odd and cos is even */
+    bool negative = (x < Fixed16::zero());
+    Fixed16 a = negative ? -x : x;
+
+    Fixed16 f(a);
+    bool sin_negative = negative;
+    bool cos_negative = false;
+    if ((a > Fixed16::PI_OVER_2()) && (a <= Fixed16::PI()))
+    {
+        f = Fixed16::PI() - a;
+        cos_negative = true;
+    } else if ((a > Fixed16::PI_OVER_2()) && (a <= (Fixed16::PI_3OVER_2())))
+    {
+        f = a - Fixed16::PI();
+        sin_negative = !sin_negative;
+        cos_negative = true;
+    } else if (a > (Fixed16::PI_3OVER_2()))
+    {
+        f = Fixed16::FromFixed32(Fixed16::PI()*Fixed16(2))-a;
+        sin_negative = !sin_negative;
+    }
+
+    Fixed16 sqr = Fixed16::FromFixed32(f*f);
+
+    s = Fixed16::FromRaw(498);
+    s *= sqr;
+    s -= Fixed16::FromRaw(10882);
+    s *= sqr;
+    s += Fixed16::one();
+    s *= f;
+
+    c = Fixed16::FromRaw(CK1);
+    c *= sqr;
+    c -= Fixed16::FromRaw(CK2);
+    c *= sqr;
+    c += Fixed16::one();
+
+    if (sin_negative)
+        s = -s;
+    if (cos_negative)
+        c = -c;
+}
+
 /*!\brief Calculate tan(f), f is in radians (0 <= f <= PI/4)
 */    
     #define TK1 13323
     #define TK2 20810
     
-Fixed16 tan(const Fixed16& f)
+Fixed16 tan_poly(const Fixed16& f)
 {
 #ifdef IOSTREAMS
     double xd = f.toDouble();
@@ -38,6 +38,22 @@ Fixed16 y(14);
 Fixed16 z = x*y;
 Fixed16 t = Fixed16::one() / 2; // half
 Fixed16 x2 = sqrt(t);
+
+Fixed16 is Fixed<16,16,f_int32>. Other formats are used the same way
+
+FixedQ1_15 s = fixed_cast<FixedQ1_15>(t);
+FixedQ1_15 s2 = FixedQ1_15::FromProduct(s*s);  // the product is a Fixed<2,30,f_int32>
+
+Fixed32 acc;                        // sum products exactly, then round once
+Fixed16::mac(acc, x, y);
+Fixed16::msub(acc, z, t);
+Fixed16 d = Fixed16::FromAccumulator(acc);   // x*y - z*t
+
+Fixed16Sat a(30000);                // clamps instead of wrapping
+Fixed16Sat b = a + a;               // 32767.99998
+
+typedef Fixed<16,16,f_int32,fixed_wrap,fixed_round_half_even> Fixed16Even;
+Fixed16Even h = Fixed16Even(x * y);  // products rounded half to even
 */
 
 #ifdef IOSTREAMS
@@ -70,11 +86,387 @@ template <class Type> void test_result(const char* message, const Type& x, const
 
 
 
-class Fixed32;
-class Fixed16;
-
 #include "f_int64.h"
 
+#ifdef IOSTREAMS
+/*
+* Helpers that the template testharnesses share with test_result(): the one
+* pseudo-random stream they draw their fixtures from, a count of the values
+* that differ from a reference, and a run over blocks of growing sizes.
+*/
+
+/*!\brief Step a 32 bit LCG and return the new seed, as signed */
+inline f_int32 test_rand(f_uint32& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return f_int32(seed);
+}
+
+/*!\brief Set n values to raw test_rand(seed) >> shift */
+template <class Q> void test_fill(Q* data, int n, f_uint32& seed, int shift)
+{
+    for (int i = 0; i < n; i++)
+        data[i] = Q::FromRaw(typename Q::storage_type(test_rand(seed) >> shift));
+}
+
+/*!\brief The number of the n values of a that differ from those of b */
+template <class T> int test_mismatches(const T* a, const T* b, int n)
+{
+    int mismatches = 0;
+    for (int i = 0; i < n; i++)
+        if (a[i] != b[i])
+            mismatches++;
+    return mismatches;
+}
+
+/*!\brief Call process(offset, count) on consecutive blocks of 1, 1 + grow,
+    1 + 2*grow ... values, the last cut short to end at n
+*/
+template <class Process> void test_in_blocks(int n, int grow, Process process)
+{
+    int done = 0;
+    for (int size = 1; done < n; size += grow)
+    {
+        int count = (done + size > n) ? n - done : size;
+        process(done, count);
+        done += count;
+    }
+}
+#endif
+
+/*!\brief Fixed: A signed IntBits.FracBits fixed-point number held in Storage
+
+* IntBits includes the sign bit, so IntBits + FracBits is the width of
+* Storage. The shifts, the wider type used to hold products, and the
+* constants (one(), PI(), PRECISION() ...) are all resolved at compile time
+* from the template arguments. For example
+
+    Fixed<1,15,f_int16>     Q1.15 (audio samples)
+    Fixed<8,24,f_int32>     Q8.24 (unit quaternions)
+    Fixed<2,30,f_int32>     Q2.30 (rotation matrices)
+    Fixed<16,16,f_int32>    Fixed16
+    Fixed<32,32,f_int64>    Fixed32
+
+* The product of two Fixed<I,F,S> numbers is exact, and is held in a
+* Fixed<2I,2F,W> where W is the storage type twice as wide as S. So the
+* product of two Fixed16 numbers is a Fixed32, as it always has been.
+*/
+struct fixed_wrap;
+struct fixed_truncate;
+struct fixed_round_half_up;
+struct fixed_round_half_even;
+struct fixed_round_stochastic;
+template <int IntBits, int FracBits, class Storage, class Overflow = fixed_wrap, class Rounding = fixed_truncate> class Fixed;
+
+/* Define FIXED16_ROUNDING as one of the rounding policies below to change
+   how Fixed16, and so FixedVector, FixedMatrix and Quaternion, narrow products */
+#ifndef FIXED16_ROUNDING
+#define FIXED16_ROUNDING fixed_truncate
+#define FIXED16_DEFAULT_ROUNDING    /* for code that only handles truncation, such as the SIMD kernels */
+#endif
+
+#ifndef FIXED_THREAD_LOCAL
+#define FIXED_THREAD_LOCAL thread_local
+#endif
+
+typedef Fixed<16,16,f_int32,fixed_wrap,FIXED16_ROUNDING> Fixed16;
+typedef Fixed<32,32,f_int64> Fixed32;
+
+/*!\brief How Fixed widens, multiplies and narrows each storage type.
+*/
+template <class Storage> struct fixed_storage_traits;
+
+/*
+* shl() shifts the bit pattern, so that negative values can be shifted in a
+* constant expression. narrow_shr(w, n) is narrow(w >> n).
+*/
+template <> struct fixed_storage_traits<f_int16>
+{
+    typedef f_int32 wide_type;
+    typedef uint16_t unsigned_type;
+
+    static constexpr wide_type mult(f_int16 a, f_int16 b) { return wide_type(a) * wide_type(b); }
+    static constexpr f_int16 narrow(wide_type w) { return f_int16(w); }
+    static constexpr f_int16 narrow_shr(wide_type w, int n) {
+#ifdef IOSTREAMS
+        if ((w >> n) != f_int16(w >> n))
+        {
+            cout << "Fixed OVERFLOW " << w << endl;
+            throw -1;
+        }
+#endif
+        return f_int16(w >> n);
+    }
+    static constexpr f_int16 truncate_shr(wide_type w, int n) { return f_int16(w >> n); }
+    static constexpr f_uint32 low_word(wide_type w) { return f_uint32(w); }
+    static constexpr bool fits_shr(wide_type w, int n) { return (w >> n) == f_int16(w >> n); }
+    static constexpr bool negative(wide_type w) { return w < 0; }
+    static constexpr f_int16 shl(f_int16 x, int n) { return f_int16(uint16_t(x) << n); }
+    static constexpr f_int16 from_int64(int64_t x) { return f_int16(x); }
+    static double to_double(f_int16 x) { return x; }
+};
+
+template <> struct fixed_storage_traits<f_int32>
+{
+    typedef f_int64 wide_type;
+    typedef f_uint32 unsigned_type;
+
+#ifdef NO_64BIT_MULTIPLY
+    /* f_int64::mult32() is out of line, so products are not constant expressions */
+    static wide_type mult(f_int32 a, f_int32 b) { return f_int64::mult32(a, b); }
+#else
+    static constexpr wide_type mult(f_int32 a, f_int32 b) { return f_int64::mult32(a, b); }
+#endif
+    static constexpr f_int32 narrow(const wide_type& w) { return w.toInt32(); }
+    
+    /* Built from the two words so that it is a constant expression with either f_int64 backend */
+    static constexpr f_int32 narrow_shr(const wide_type& w, int n) {
+#ifdef IOSTREAMS
+        if (n > 0 && (w.GetHi() >> n) != 0 && (w.GetHi() >> n) != -1)
+        {
+            cout << "Fixed OVERFLOW " << w << endl;
+            throw -1;
+        }
+#endif
+        return (n == 0) ? w.toInt32() : f_int32((f_uint32(w.GetHi()) << (32 - n)) | (w.GetLo() >> n));
+    }
+    static constexpr f_uint32 low_word(const wide_type& w) { return w.GetLo(); }
+    static constexpr f_int32 truncate_shr(const wide_type& w, int n) {
+        return (n == 0) ? f_int32(w.GetLo()) : f_int32((f_uint32(w.GetHi()) << (32 - n)) | (w.GetLo() >> n));
+    }
+    /* The high word of w >> n is the sign extension of the low word */
+    static constexpr bool fits_shr(const wide_type& w, int n) {
+        return (w.GetHi() >> n) == (truncate_shr(w, n) >> 31);
+    }
+    static constexpr bool negative(const wide_type& w) { return w.GetHi() < 0; }
+    static constexpr f_int32 shl(f_int32 x, int n) { return f_int32(f_uint32(x) << n); }
+    static constexpr f_int32 from_int64(int64_t x) { return f_int32(x); }
+    static double to_double(f_int32 x) { return x; }
+};
+
+/* There is nothing wider, so formats held in an f_int64 have no product type */
+template <> struct fixed_storage_traits<f_int64>
+{
+    typedef void wide_type;
+
+    static f_int64 shl(const f_int64& x, int n) { return x << n; }
+    static constexpr f_int64 from_int64(int64_t x) { return f_int64(f_int32(x >> 32), f_uint32(x)); }
+    static double to_double(const f_int64& x) { return double(x.GetHi()) * 4294967296.0 + double(x.GetLo()); }
+};
+
+/*!\brief The type of the product of two Fixed<I/2,F/2,S> numbers, where Wide is twice the width of S.
+*/
+template <int IntBits, int FracBits, class Wide> struct fixed_product
+{
+    typedef Fixed<IntBits, FracBits, Wide> type;
+};
+
+/* Placeholder product type of formats that are already held in an f_int64 */
+struct fixed_no_product {};
+
+template <int IntBits, int FracBits> struct fixed_product<IntBits, FracBits, void>
+{
+    typedef fixed_no_product type;
+};
+
+/*!\brief What Fixed does with a result that does not fit, chosen by its Overflow parameter
+
+    fixed_wrap      keeps the low bits, as the integer types do. This is the
+                    default, and with IOSTREAMS defined a product that does
+                    not fit still throws.
+    fixed_saturate  clamps to the largest or smallest value, without branches.
+    fixed_trap      calls fixed_overflow_trap(), then keeps the low bits.
+
+* The policies apply to +, -, negation, <<, *=, the Fixed(f_int32)
+* constructor and the narrowing of products (Fixed(product_type),
+* FromProduct() and FromAccumulator()). Sums of products held in a
+* product_type are never checked.
+*
+* With FIXED_OVERFLOW_COUNTERS defined, fixed_saturate and fixed_trap count
+* the overflows they meet in fixed_overflow_count, which is per thread.
+*/
+struct fixed_wrap
+{
+    template <class S> static constexpr S add(S a, S b) { return S(a + b); }
+    template <class S> static constexpr S sub(S a, S b) { return S(a - b); }
+    template <class S> static constexpr S neg(S a) { return S(-a); }
+    template <class S> static constexpr S mul(S a, f_int32 b) { return S(a * b); }
+    template <class S> static constexpr S shl(S x, int n) { return fixed_storage_traits<S>::shl(x, n); }
+    template <class S> static constexpr S from_int64(int64_t x, int n) {
+        return fixed_storage_traits<S>::shl(fixed_storage_traits<S>::from_int64(x), n);
+    }
+    template <class S> static constexpr S narrow_shr(const typename fixed_storage_traits<S>::wide_type& w, int n) {
+        return fixed_storage_traits<S>::narrow_shr(w, n);
+    }
+};
+
+#ifdef FIXED_OVERFLOW_COUNTERS
+struct fixed_overflow_counters
+{
+    f_uint32 saturated;
+    f_uint32 trapped;
+};
+
+/* This thread's counts. Read and reset them as you like. */
+extern FIXED_THREAD_LOCAL fixed_overflow_counters fixed_overflow_count;
+#endif
+
+/*!\brief Called by fixed_trap on overflow. With IOSTREAMS defined it prints a
+    message and throws -1. Otherwise it calls the handler given to
+    fixed_set_overflow_handler(), or aborts if there is none.
+*/
+void fixed_overflow_trap();
+void fixed_set_overflow_handler(void (*handler)());
+
+/*!\brief Computes each result with wrap around, and a word whose sign bit is
+    set if it overflowed. Action decides what to return.
+*/
+template <class Action> struct fixed_checked
+{
+    template <class S> static S add(S a, S b) {
+        S r = S(U<S>(a) + U<S>(b));
+        return Action::result(r, a, S((a ^ r) & (b ^ r)));
+    }
+    template <class S> static S sub(S a, S b) {
+        S r = S(U<S>(a) - U<S>(b));
+        return Action::result(r, a, S((a ^ b) & (a ^ r)));
+    }
+    /* Only the most negative value overflows, and it goes to the most positive */
+    template <class S> static S neg(S a) {
+        S r = S(U<S>(0) - U<S>(a));
+        return Action::result(r, S(~a), S(a & r));
+    }
+    template <class S> static S mul(S a, f_int32 b) {
+        return narrow_shr<S>(fixed_storage_traits<S>::mult(a, S(b)), 0);
+    }
+    template <class S> static S shl(S x, int n) {
+        S r = fixed_storage_traits<S>::shl(x, n);
+        return Action::result(r, x, S(-S((r >> n) != x)));
+    }
+    /* x << n, checked in 64 bits before x is narrowed to S */
+    template <class S> static S from_int64(int64_t x, int n) {
+        typedef fixed_storage_traits<S> traits;
+        const int64_t max = int64_t(U<S>(~U<S>(0)) >> 1);
+        const bool fits = x <= (max >> n) && x >= (~max >> n);
+        return Action::result(traits::shl(traits::from_int64(x), n), S(-S(x < 0)), S(-S(!fits)));
+    }
+    template <class S> static S narrow_shr(const typename fixed_storage_traits<S>::wide_type& w, int n) {
+        typedef fixed_storage_traits<S> traits;
+        return Action::result(traits::truncate_shr(w, n), S(-S(traits::negative(w))), S(-S(!traits::fits_shr(w, n))));
+    }
+
+private:
+    template <class S> using U = typename fixed_storage_traits<S>::unsigned_type;
+};
+
+/* Saturate to the end of the range on the side of sign_of */
+struct fixed_saturate_action
+{
+    template <class S> static S result(S r, S sign_of, S overflow) {
+        const int top = 8*sizeof(S) - 1;
+        S mask = S(overflow >> top);
+        S limit = S((sign_of >> top) ^ S(~(typename fixed_storage_traits<S>::unsigned_type(1) << top)));
+#ifdef FIXED_OVERFLOW_COUNTERS
+        fixed_overflow_count.saturated += (mask & 1);
+#endif
+        return S((r & ~mask) | (limit & mask));
+    }
+};
+
+struct fixed_trap_action
+{
+    template <class S> static S result(S r, S, S overflow) {
+        if (overflow < 0)
+        {
+#ifdef FIXED_OVERFLOW_COUNTERS
+            fixed_overflow_count.trapped++;
+#endif
+            fixed_overflow_trap();
+        }
+        return r;
+    }
+};
+
+typedef fixed_checked<fixed_saturate_action> fixed_saturate;
+typedef fixed_checked<fixed_trap_action> fixed_trap;
+
+/*!\brief How Fixed narrows a product, chosen by its Rounding parameter
+
+    fixed_truncate          drops the extra bits (rounds toward -infinity).
+                            This is the default.
+    fixed_round_half_up     rounds to nearest, halves toward +infinity.
+    fixed_round_half_even   rounds to nearest, halves to the even neighbour.
+    fixed_round_stochastic  rounds up with probability equal to the bits
+                            dropped, so that on average there is no bias.
+
+* The policy is used by Fixed(product_type), FromProduct(), FromFixed32() and
+* *=. FromAccumulator() uses Rounding::accumulator, which is the policy
+* itself, except that fixed_truncate rounds a sum of products half up as it
+* always has.
+*
+* add_bias(w, n) is what to add to w before it is shifted right by n.
+*/
+struct fixed_truncate
+{
+    typedef fixed_round_half_up accumulator;
+    template <class S> static constexpr typename fixed_storage_traits<S>::wide_type
+    add_bias(const typename fixed_storage_traits<S>::wide_type& w, int) {
+        return w;
+    }
+};
+
+struct fixed_round_half_up
+{
+    typedef fixed_round_half_up accumulator;
+    template <class S> static constexpr typename fixed_storage_traits<S>::wide_type
+    add_bias(const typename fixed_storage_traits<S>::wide_type& w, int n) {
+        typedef typename fixed_storage_traits<S>::wide_type W;
+        return (n == 0) ? w : w + W(f_int32(f_uint32(1) << (n - 1)));
+    }
+};
+
+/* Half less one, plus the bit that will become the lsb: a tie only carries if that bit is odd */
+struct fixed_round_half_even
+{
+    typedef fixed_round_half_even accumulator;
+    template <class S> static constexpr typename fixed_storage_traits<S>::wide_type
+    add_bias(const typename fixed_storage_traits<S>::wide_type& w, int n) {
+        typedef fixed_storage_traits<S> traits;
+        typedef typename traits::wide_type W;
+        return (n == 0) ? w : w + W(f_int32((f_uint32(1) << (n - 1)) - 1 + ((traits::low_word(w) >> n) & 1)));
+    }
+};
+
+/* This thread's xorshift32 state for fixed_round_stochastic. It must not be zero. */
+extern FIXED_THREAD_LOCAL f_uint32 fixed_rounding_state;
+
+/*!\brief Restart this thread's rounding sequence, so that a run can be repeated */
+void fixed_seed_rounding(f_uint32 seed);
+
+inline f_uint32 fixed_rounding_random() {
+    f_uint32 x = fixed_rounding_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    fixed_rounding_state = x;
+    return x;
+}
+
+struct fixed_round_stochastic
+{
+    typedef fixed_round_stochastic accumulator;
+    template <class S> static typename fixed_storage_traits<S>::wide_type
+    add_bias(const typename fixed_storage_traits<S>::wide_type& w, int n) {
+        typedef typename fixed_storage_traits<S>::wide_type W;
+        return (n == 0) ? w : w + W(f_int32(fixed_rounding_random() >> (32 - n)));
+    }
+};
+
+/* pi, pi/2 and 3pi/2 in Q4.60, rounded to nearest */
+constexpr int64_t FIXED_PI_Q60 = 3622009729038561421LL;
+constexpr int64_t FIXED_PI_OVER_2_Q60 = 1811004864519280711LL;
+constexpr int64_t FIXED_PI_3OVER_2_Q60 = 5433014593557842132LL;
+
 /*!\brief Fixed32: A 64 bit (32.32) fixed-point number
 
 * This class is used to hold the product of multiplying two Fixed16 numbers
@@ -82,24 +474,26 @@ class Fixed16;
 * norm) we support addition and square root operations on Fixed32 numbers.
 
 */
-class Fixed32
+template <> class Fixed<32,32,f_int64>
 {
 public:
+    typedef f_int64 storage_type;
 
-    explicit Fixed32() {}
-    explicit Fixed32( const f_int32& i ) {
+    static const int int_bits = 32;
+    static const int frac_bits = 32;
+
+    explicit Fixed() {}
+    explicit Fixed( const f_int32& i ) {
         f_int64 temp(i);
         temp <<= 32;
         v = temp;
     }
-    explicit Fixed32( const Fixed16& x );
+    explicit Fixed( const Fixed16& x );
     
     Fixed32& operator=( const Fixed16& rhs );
     
-    static Fixed32 FromRaw( const f_int64& raw ) {
-        Fixed32 r;
-        r.v = raw;
-        return r;
+    static constexpr Fixed32 FromRaw( const f_int64& raw ) {
+        return Fixed32(raw, raw_tag());
     }
     
 #ifdef IOSTREAMS
@@ -108,7 +502,7 @@ public:
         return f;
     }
     
-    explicit Fixed32(const double x) {
+    explicit Fixed(const double x) {
         v.FromDouble(x*65536.0*65536.0);
     }
 
@@ -127,7 +521,7 @@ public:
         return false;
     }
     
-    f_int64 Raw() const { return v; }
+    constexpr f_int64 Raw() const { return v; }
 
     inline void shiftr(f_int32 y)
     {    v >>= y; }
@@ -152,6 +546,9 @@ public:
     static void testharness();
 #endif
 private:
+    struct raw_tag {};
+    constexpr Fixed( const f_int64& raw, raw_tag ) : v(raw) {}
+
     f_int64 v;
 };
 
@@ -202,163 +599,231 @@ inline Fixed32 abs(const Fixed32& f) {
 }
 
 
-/*!\brief Fixed16: A 16.16 fixed point number
+/*!\brief The general Fixed<IntBits, FracBits, Storage, Overflow, Rounding> number. Fixed16 is the 16.16 case.
 */
-class Fixed16 {
+template <int IntBits, int FracBits, class Storage, class Overflow, class Rounding>
+class Fixed {
+    static_assert(IntBits + FracBits == 8*sizeof(Storage), "IntBits + FracBits must be the width of Storage");
+    static_assert(IntBits >= 1, "IntBits includes the sign bit");
 public:
+    typedef Storage storage_type;
+    typedef fixed_storage_traits<Storage> traits;
+    typedef Overflow overflow_policy;
+    typedef Rounding rounding_policy;
+    typedef typename traits::wide_type wide_type;
 
-    Fixed16() {    v = 0; }
-    explicit Fixed16( const f_int32 i )   : v( f_int32(i) << 16 ) {}
+    /*!\brief The type of the (exact) product of two of these numbers */
+    typedef typename fixed_product<2*IntBits, 2*FracBits, wide_type>::type product_type;
+
+    static const int int_bits = IntBits;
+    static const int frac_bits = FracBits;
+
+    constexpr Fixed() : v(0) {}
+    constexpr explicit Fixed( const f_int32 i )   : v( Overflow::template from_int64<Storage>(i, FracBits) ) {}
     
-    Fixed16( const Fixed32& f32 ) {
-#ifdef IOSTREAMS
-        // test for overflow
-        if (f32.toDouble() > 32768.0) {
-            cout << "Fixed16 OVERFLOW " << f32 << endl;
-            throw -1;
-        }
-#endif
-        f_int64 temp(f32.Raw());
-        temp >>= 16;
+    /* With IOSTREAMS defined, narrow_shr() throws if the product overflows */
+    constexpr Fixed( const product_type& p ) : v(narrow_product<Rounding>(p.Raw())) {}
     
-        v = temp.toInt32();
+    /*!\brief Narrow a product back to this format, rounding as Rounding says (truncating by default) */
+    static constexpr Fixed FromProduct( const product_type& p ) {
+        return Fixed::FromRaw(narrow_product<Rounding>(p.Raw()));
     }
-    
-    static Fixed16 FromFixed32( const Fixed32& f32 ) {
-        f_int64 temp(f32.Raw());
-        temp >>= 16;
-    
-        return Fixed16::FromRaw(temp.toInt32());
+
+    /*!\brief Same as FromProduct(). For a Fixed16 the product is a Fixed32. */
+    static constexpr Fixed FromFixed32( const product_type& p ) {
+        return FromProduct(p);
+    }
+
+    /*!\brief acc += a * b. The products are exact, so a sum of them is only
+        rounded once, by FromAccumulator().
+    */
+    static void mac( product_type& acc, const Fixed& a, const Fixed& b ) {
+        acc = product_type::FromRaw(acc.Raw() + traits::mult(a.v, b.v));
+    }
+
+    /*!\brief acc -= a * b */
+    static void msub( product_type& acc, const Fixed& a, const Fixed& b ) {
+        acc = product_type::FromRaw(acc.Raw() - traits::mult(a.v, b.v));
+    }
+
+    /*!\brief x, exactly, as an accumulator to start a sum of products from */
+    static product_type ToAccumulator( const Fixed& x ) {
+        return product_type::FromRaw(wide_type(x.v) << FracBits);
+    }
+
+    /*!\brief Narrow a sum of products back to this format, rounding to nearest
+        (or as Rounding::accumulator says).
+    */
+    static constexpr Fixed FromAccumulator( const product_type& acc ) {
+        return Fixed::FromRaw(narrow_product<typename Rounding::accumulator>(acc.Raw()));
     }
     
-    static Fixed16 FromRaw( f_int32 raw ) {
-        Fixed16 r;
+    static constexpr Fixed FromRaw( Storage raw ) {
+        Fixed r;
         r.v = raw;
         return r;
     }
 
     void FromInt( f_int32 i ) {
-        v = ( f_int32(i) << 16 );
+        v = Overflow::template from_int64<Storage>(i, FracBits);
     }
     
-    static Fixed16 zero();
-    static Fixed16 one();
-    static Fixed16 PRECISION() { return Fixed16::FromRaw(1); }
-    static Fixed16 PI();
-    static Fixed16 PI_OVER_2();
-    static Fixed16 PI_3OVER_2();
-
-    f_int32 Raw() const {
+    static constexpr Fixed zero() { return FromRaw(Storage(0)); }
+    static constexpr Fixed one() {
+        static_assert(IntBits >= 2, "one() is not representable in this format");
+        return FromRaw(Storage(1) << FracBits);
+    }
+    static constexpr Fixed PRECISION() { return FromRaw(Storage(1)); }
+    static constexpr Fixed PI() {
+        static_assert(IntBits >= 3, "PI() is not representable in this format");
+        return FromRaw(from_q60(FIXED_PI_Q60));
+    }
+    static constexpr Fixed PI_OVER_2() {
+        static_assert(IntBits >= 2, "PI_OVER_2() is not representable in this format");
+        return FromRaw(from_q60(FIXED_PI_OVER_2_Q60));
+    }
+    static constexpr Fixed PI_3OVER_2() {
+        static_assert(IntBits >= 4, "PI_3OVER_2() is not representable in this format");
+        return FromRaw(from_q60(FIXED_PI_3OVER_2_Q60));
+    }
+
+    constexpr Storage Raw() const {
         return v;
     }
 
     /* See also the round() operation */
-    f_int32 toInteger() const {
-        return v >> 16;
+    Storage toInteger() const {
+        return v >> FracBits;
     }
     
     /* See also the round() operation */
     double toDouble() const {
-        double f = (v >> 16) + (double(v & 0xFFFF) / 65536.0);
-        return f;
+        return traits::to_double(v) / double(int64_t(1) << FracBits);
     }
     
     
-    Fixed16& operator=( const Fixed16& rhs ) {
+    constexpr Fixed( const Fixed& x ) : v(x.v) {}
+
+    constexpr Fixed& operator=( const Fixed& rhs ) {
         v = rhs.v;
         return *this;
     }
     
-    Fixed16& operator=( const f_int32& rhs ) {
+    Fixed& operator=( const f_int32& rhs ) {
         FromInt(rhs);
         return *this;
     }
     
-    Fixed16& operator*=( f_int32 rhs ) {
-        v *= rhs;
+    constexpr Fixed& operator*=( f_int32 rhs ) {
+        v = Overflow::template mul<Storage>(v, rhs);
         return *this;
     }
     
-    Fixed16& operator+=(const Fixed16& rhs ) {
-        v += rhs.v;
+    constexpr Fixed& operator+=(const Fixed& rhs ) {
+        v = Overflow::template add<Storage>(v, rhs.v);
         return *this;
     }
 
-    Fixed16& operator-=(const Fixed16& rhs ) {
-        v -= rhs.v;
+    constexpr Fixed& operator-=(const Fixed& rhs ) {
+        v = Overflow::template sub<Storage>(v, rhs.v);
         return *this;
     }
 
-    Fixed16& operator*=(const Fixed16& rhs ) {
-        f_int64 temp = f_int64::mult32(v,rhs.v);
-        temp >>= 16;
-        v = temp.toInt32();
+    constexpr Fixed& operator*=(const Fixed& rhs ) {
+        v = narrow_product<Rounding>(traits::mult(v, rhs.v));
         return *this;
     }
 
     // Logical operations
-    inline bool operator==(const Fixed16& other) const {
+    constexpr bool operator==(const Fixed& other) const {
         return v == other.v;
     }
 
-    inline bool operator!=(const Fixed16& other) const {
+    constexpr bool operator!=(const Fixed& other) const {
         return v != other.v;
     }
 
-    inline bool operator<(const Fixed16& other) const {
+    constexpr bool operator<(const Fixed& other) const {
         return v < other.v;
     }
 
-    inline bool operator>(const Fixed16& other) const {
+    constexpr bool operator>(const Fixed& other) const {
         return v > other.v;
     }
 
-    inline bool operator<=(const Fixed16& other) const {
+    constexpr bool operator<=(const Fixed& other) const {
         return v <= other.v;
     }
 
-    inline bool operator>=(const Fixed16& other) const {
+    constexpr bool operator>=(const Fixed& other) const {
         return v >= other.v;
     }
 
 #ifdef IOSTREAMS
-/*    explicit Fixed16(const double x)
-    {
-        Fixed32 x32(x);
-        *this = Fixed16(x32);
-    }*/
-    
-    friend std::ostream& operator<<(std::ostream& os, const Fixed16&);
+    static Fixed FromDouble(const double x) {
+        return FromRaw(traits::from_int64(int64_t(x * double(int64_t(1) << FracBits))));
+    }
 
-    static Fixed16 rand(int x);
+    static Fixed rand(int x);
     static void testharness();
 #endif
     
 private:
-    f_int32 v;
+    /* Round a Q4.60 constant to this format */
+    static constexpr Storage from_q60(int64_t c) {
+        static_assert(FracBits < 60, "constants are only held to 60 fractional bits");
+        return traits::from_int64((c + (int64_t(1) << (59 - FracBits))) >> (60 - FracBits));
+    }
+
+    /* W is wide_type, left to be deduced since it is void for the widest formats */
+    template <class R, class W> static constexpr Storage narrow_product( const W& w ) {
+        return Overflow::template narrow_shr<Storage>(R::template add_bias<Storage>(w, FracBits), FracBits);
+    }
+
+    Storage v;
 };
 
+/* Formats with fewer integer bits than Fixed16 */
+typedef Fixed<1,15,f_int16> FixedQ1_15;
+typedef Fixed<8,24,f_int32> FixedQ8_24;
+typedef Fixed<2,30,f_int32> FixedQ2_30;
+
+/* Fixed16 with the other overflow policies */
+typedef Fixed<16,16,f_int32,fixed_saturate> Fixed16Sat;
+typedef Fixed<16,16,f_int32,fixed_trap> Fixed16Trap;
+
+#ifdef IOSTREAMS
+template <> Fixed16 Fixed16::rand(int x);
+template <> void Fixed16::testharness();
+
+template <int I, int F, class S, class P, class R> std::ostream& operator<<(std::ostream& os, const Fixed<I,F,S,P,R>& x)
+{
+    os << x.toDouble();
+    return os;
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 //
-// Useful mathematical operations for Fixed16 objects
+// Useful mathematical operations for Fixed objects
 //
 //////////////////////////////////////////////////////////////////////////////
 
 
-inline Fixed16 operator<<(const Fixed16& x, f_int32 y) {
-    return Fixed16::FromRaw(x.Raw() << y);
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator<<(const Fixed<I,F,S,P,R>& x, f_int32 y) {
+    return Fixed<I,F,S,P,R>::FromRaw(P::template shl<S>(x.Raw(), y));
 }
 
-inline Fixed16 operator>>(const Fixed16& x, f_int32 y) {
-    return Fixed16::FromRaw(x.Raw() >> y);
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator>>(const Fixed<I,F,S,P,R>& x, f_int32 y) {
+    return Fixed<I,F,S,P,R>::FromRaw(x.Raw() >> y);
 }
 
-inline Fixed16 operator+(const Fixed16& a, const Fixed16& b ) {
-    return Fixed16::FromRaw(a.Raw() + b.Raw());
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator+(const Fixed<I,F,S,P,R>& a, const Fixed<I,F,S,P,R>& b ) {
+    return Fixed<I,F,S,P,R>::FromRaw(P::template add<S>(a.Raw(), b.Raw()));
 }
 
-inline Fixed16 operator+(const Fixed16& a, const f_int32& b ) {
-     return a + Fixed16(b);
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator+(const Fixed<I,F,S,P,R>& a, const f_int32& b ) {
+     return a + Fixed<I,F,S,P,R>(b);
 }
 
 inline Fixed32 operator+(const Fixed32& a, const Fixed16& b ) {
@@ -368,12 +833,12 @@ inline Fixed32 operator+(const Fixed16& a, const Fixed32& b ) {
     return Fixed32(a) + b;
 }
 
-inline Fixed16 operator-(const Fixed16& a, const Fixed16& b ) {
-    return Fixed16::FromRaw(a.Raw() - b.Raw());
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator-(const Fixed<I,F,S,P,R>& a, const Fixed<I,F,S,P,R>& b ) {
+    return Fixed<I,F,S,P,R>::FromRaw(P::template sub<S>(a.Raw(), b.Raw()));
 }
 
-inline Fixed16 operator-(const Fixed16& a, const f_int32& b ) {
-    return a - Fixed16(b);
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator-(const Fixed<I,F,S,P,R>& a, const f_int32& b ) {
+    return a - Fixed<I,F,S,P,R>(b);
 }
 inline Fixed32 operator-(const Fixed32& a, const Fixed16& b ) {
     return a - Fixed32(b);
@@ -383,9 +848,10 @@ inline Fixed32 operator-(const Fixed16& a, const Fixed32& b ) {
 }
 
 
-/* The product of two Fixed16's is a Fixed32 */
-inline Fixed32 operator*( const Fixed16& a, const Fixed16& b ) {
-    return Fixed32::FromRaw(f_int64::mult32(a.Raw(), b.Raw()));
+/* The product of two Fixed<I,F,S> is a Fixed<2I,2F,wide> (a Fixed32 for Fixed16) */
+template <int I, int F, class S, class P, class R> constexpr typename Fixed<I,F,S,P,R>::product_type operator*( const Fixed<I,F,S,P,R>& a, const Fixed<I,F,S,P,R>& b ) {
+    typedef Fixed<I,F,S,P,R> T;
+    return T::product_type::FromRaw(T::traits::mult(a.Raw(), b.Raw()));
 }
 
 inline Fixed32 operator*(const Fixed32& a, const Fixed16& b ) {
@@ -417,14 +883,123 @@ inline Fixed32 operator*( const Fixed16& a, const f_int32& b ) {
 }
 
 // Negation    
-inline Fixed16 operator-(const Fixed16& a ) {
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> operator-(const Fixed<I,F,S,P,R>& a ) {
 //    cout << "operator-(" << a << "," << b << ")" << endl;
-    return Fixed16::FromRaw(-a.Raw());
+    return Fixed<I,F,S,P,R>::FromRaw(P::template neg<S>(a.Raw()));
 //    return Fixed16::FromFixed32(a * Fixed16(-1));
 }
 
 Fixed16 reciprocal(const Fixed16& x);
 
+/*!\brief 1/d in Q30, for d in Q32 with its top bit set (0.5 <= d < 1).
+    This is the Newton's method step of reciprocal(), before it is scaled.
+*/
+f_uint32 reciprocal_q30(f_uint32 d);
+
+/*!\brief Divides many numbers by the same d. The reciprocal of d is found
+    once, by reciprocal_q30(), so that each division is a multiply and a
+    shift, and one more multiply to check the remainder. x / d is rounded
+    to nearest, and is exact where a / b only uses a 16 bit reciprocal.
+
+    Fixed16Divider by(d);
+    for (int i = 0; i < n; i++)
+        y[i] = x[i] / by;
+
+    Dividing by zero gives zero, as a / Fixed16(0) does. With IOSTREAMS
+    defined, a quotient that does not fit throws.
+*/
+template <class Q> class FixedDivider
+{
+    static_assert(sizeof(typename Q::storage_type) == sizeof(f_int32), "FixedDivider is for 32 bit Fixed formats");
+
+public:
+    FixedDivider() : m_abs(0), m_r(0), m_shift(0), m_round_lo(0), m_round_hi(0), m_negative(false) {}
+
+    explicit FixedDivider(const Q& d) : m_d(d) {
+        f_int32 raw = d.Raw();
+        m_negative = (raw < 0);
+        m_abs = m_negative ? (0u - f_uint32(raw)) : f_uint32(raw);
+
+        /* d is n * 2^(32 - s - FracBits), with 0.5 <= n < 1 in Q32 */
+        int s = f_clz32(m_abs);
+        m_r = (m_abs == 0) ? 0 : reciprocal_q30(m_abs << s);
+        m_shift = 62 - Q::frac_bits - s;
+        m_round_lo = (m_shift == 0 || m_shift > 32) ? 0 : f_uint32(1) << (m_shift - 1);
+        m_round_hi = (m_shift > 32) ? f_uint32(1) << (m_shift - 33) : 0;
+    }
+
+    const Q& divisor() const { return m_d; }
+
+    /*!\brief x / d, rounded to nearest */
+    Q divide(const Q& x) const {
+        if (m_abs == 0)
+            return Q::zero();
+
+        f_int32 raw = x.Raw();
+        bool negative = (raw < 0) != m_negative;
+        f_uint32 a = (raw < 0) ? (0u - f_uint32(raw)) : f_uint32(raw);
+
+        /* A rounded estimate, nearly always the quotient, then 32 bit steps to it */
+        f_uint64 e = f_uint64::umult32(a, m_r);
+        f_uint32 e_lo = e.GetLo() + m_round_lo;
+        f_uint32 e_hi = e.GetHi() + m_round_hi + (e_lo < m_round_lo);
+        if (m_shift < 32 && (e_hi >> m_shift) != 0)
+            return overflow(x, negative);
+        f_uint32 q = (m_shift >= 32) ? (e_hi >> (m_shift - 32))
+                   : (m_shift == 0) ? e_lo
+                   : ((e_hi << (32 - m_shift)) | (e_lo >> m_shift));
+
+        /* u = x - q*d + d/2 must lie in [0, d) for q to be x / d rounded */
+        const int F = Q::frac_bits;
+        f_uint64 p = f_uint64::umult32(q, m_abs);
+        f_uint32 x_lo = a << F;
+        f_uint32 x_hi = (F == 0) ? 0 : (a >> ((32 - F) & 31));
+        f_uint32 u_lo = x_lo - p.GetLo();
+        f_int32 u_hi = f_int32(x_hi - p.GetHi() - (x_lo < p.GetLo()));
+        f_uint32 half = m_abs >> 1;
+        u_lo += half;
+        u_hi += (u_lo < half);
+        while (u_hi < 0)
+        {
+            q--;
+            u_lo += m_abs;
+            u_hi += (u_lo < m_abs);
+        }
+        while (u_hi > 0 || u_lo >= m_abs)
+        {
+            q++;
+            u_hi -= (u_lo < m_abs);
+            u_lo -= m_abs;
+        }
+        if (q > 0x7FFFFFFFu)
+            return overflow(x, negative);
+        return Q::FromRaw(negative ? -f_int32(q) : f_int32(q));
+    }
+
+private:
+    /* With IOSTREAMS defined, throw. Otherwise give the end of the range. */
+    Q overflow(const Q& x, bool negative) const {
+#ifdef IOSTREAMS
+        cout << "Fixed OVERFLOW " << x << " / " << m_d << endl;
+        throw -1;
+#endif
+        return Q::FromRaw(negative ? f_int32(0x80000000u) : f_int32(0x7FFFFFFF));
+    }
+
+    Q m_d;
+    f_uint32 m_abs;     // |d|
+    f_uint32 m_r;       // 1/n in Q30, for |d| normalised to n
+    int m_shift;        // x * m_r >> m_shift is about x / d
+    f_uint32 m_round_lo, m_round_hi;    // half of 2^m_shift
+    bool m_negative;
+};
+
+typedef FixedDivider<Fixed16> Fixed16Divider;
+
+template <class Q> inline Q operator/(const Q& x, const FixedDivider<Q>& d) {
+    return d.divide(x);
+}
+
 //#define HIGH_ACCURACY 1
 
 inline Fixed16 operator/( const Fixed16& a, const Fixed16& b ) {
@@ -447,35 +1022,167 @@ inline Fixed16 operator/( const Fixed16& a, const f_int32 b ) {
     return a / Fixed16(b);
 }
 
-inline bool operator==( const Fixed16& a, const f_int32 b ) {
-    return a == Fixed16(b);
+/*!\brief The multiplier m and shift s that divide a signed 32 bit number by d,
+    for |d| >= 2 (Hacker's Delight, 10-1). The quotient is the high word of
+    m*n, corrected by n if m has the wrong sign, shifted right by s.
+*/
+struct fixed_magic
+{
+    f_int32 m;
+    int s;
+};
+
+constexpr fixed_magic fixed_signed_magic(f_int32 d) {
+    const f_uint32 two31 = 0x80000000u;
+    const f_uint32 ad = (d < 0) ? 0u - f_uint32(d) : f_uint32(d);
+    const f_uint32 t = two31 + (f_uint32(d) >> 31);
+    const f_uint32 anc = t - 1 - t % ad;    // |nc|, the largest n with n % d == d - 1
+    int p = 31;
+    f_uint32 q1 = two31 / anc, r1 = two31 - q1 * anc;
+    f_uint32 q2 = two31 / ad, r2 = two31 - q2 * ad;
+    f_uint32 delta = 0;
+    do {
+        p++;
+        q1 = 2 * q1; r1 = 2 * r1;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 = 2 * q2; r2 = 2 * r2;
+        if (r2 >= ad) { q2++; r2 -= ad; }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    fixed_magic r = { f_int32((d < 0) ? 0u - (q2 + 1) : q2 + 1), p - 32 };
+    return r;
 }
-inline bool operator==(  const f_int32 b, const Fixed16& a) {
-    return a == Fixed16(b);
+
+constexpr int fixed_log2_exact(f_uint32 d) {
+    return ((d & (d - 1)) != 0) ? -1 : (d == 1) ? 0 : 1 + fixed_log2_exact(d >> 1);
 }
 
+/*!\brief n / D for a constant D, rounded toward zero as integer division is.
+    A power of two takes a shift, anything else one multiply.
+*/
+template <f_int32 D> struct fixed_div_const
+{
+    static_assert(D != 0, "division by zero");
+    static_assert(D != f_int32(0x80000000u), "the divisor must have a magnitude below 2^31");
 
-inline bool operator<( const Fixed16& a, f_int32 b ) {
-    return a < Fixed16(b);
+    static const f_uint32 magnitude = (D < 0) ? 0u - f_uint32(D) : f_uint32(D);
+    static const int log2 = fixed_log2_exact(magnitude);
+    static const f_int32 m = (log2 < 0) ? fixed_signed_magic(D).m : 0;
+    static const int s = (log2 < 0) ? fixed_signed_magic(D).s : 0;
+
+    static constexpr f_int32 negate_if_negative(f_int32 q) {
+        return (D < 0) ? f_int32(0u - f_uint32(q)) : q;
+    }
+
+    static constexpr f_int32 divide(f_int32 n) {
+        if (log2 == 0)
+            return negate_if_negative(n);
+        if (log2 > 0)   // round toward zero by adding |D| - 1 to negative n first
+            return negate_if_negative((n + f_int32(f_uint32(n >> 31) >> (32 - log2))) >> log2);
+
+        f_int32 q = f_int64::mult32(m, n).GetHi();
+        if (D > 0 && m < 0)
+            q = f_int32(f_uint32(q) + f_uint32(n));
+        if (D < 0 && m > 0)
+            q = f_int32(f_uint32(q) - f_uint32(n));
+        q >>= s;
+        return f_int32(f_uint32(q) + (f_uint32(q) >> 31));
+    }
+};
+
+/*!\brief x / N for a constant integer N, exactly (rounded toward zero), and
+    without the Newton's method of operator/. It is a constant expression
+    except when N is not a power of two and NO_64BIT_MULTIPLY is defined,
+    as f_int64::mult32() is then out of line.
+
+    Fixed16 tenth = div_by<10>(x);
+*/
+template <f_int32 N, int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> div_by(const Fixed<I,F,S,P,R>& x) {
+    static_assert(sizeof(S) <= 4, "div_by is for formats of up to 32 bits");
+    return Fixed<I,F,S,P,R>::FromRaw(S(fixed_div_const<N>::divide(f_int32(x.Raw()))));
 }
-inline bool operator<=( const Fixed16& a, f_int32 b ) {
-    return a <= Fixed16(b);
+
+template <int I, int F, class S, class P, class R> constexpr bool operator==( const Fixed<I,F,S,P,R>& a, const f_int32 b ) {
+    return a == Fixed<I,F,S,P,R>(b);
 }
-inline bool operator>( const Fixed16& a, f_int32 b ) {
-    return a > Fixed16(b);
+template <int I, int F, class S, class P, class R> constexpr bool operator==(  const f_int32 b, const Fixed<I,F,S,P,R>& a) {
+    return a == Fixed<I,F,S,P,R>(b);
 }
 
 
-inline Fixed16 abs(const Fixed16& f) {
-    if (f < Fixed16::zero())
+template <int I, int F, class S, class P, class R> constexpr bool operator<( const Fixed<I,F,S,P,R>& a, f_int32 b ) {
+    return a < Fixed<I,F,S,P,R>(b);
+}
+template <int I, int F, class S, class P, class R> constexpr bool operator<=( const Fixed<I,F,S,P,R>& a, f_int32 b ) {
+    return a <= Fixed<I,F,S,P,R>(b);
+}
+template <int I, int F, class S, class P, class R> constexpr bool operator>( const Fixed<I,F,S,P,R>& a, f_int32 b ) {
+    return a > Fixed<I,F,S,P,R>(b);
+}
+
+
+template <int I, int F, class S, class P, class R> constexpr Fixed<I,F,S,P,R> abs(const Fixed<I,F,S,P,R>& f) {
+    if (f < Fixed<I,F,S,P,R>::zero())
         return -f;
         
     return f;
 }
 
+/*!\brief Convert between fixed-point formats of up to 32 bits.
+    Fractional bits that do not fit in the new format are truncated, and
+    integer bits that do not fit are handled as To's Overflow policy says.
+
+    FixedQ8_24 q = fixed_cast<FixedQ8_24>(Fixed16::one() >> 1);
+*/
+template <class To, int I, int F, class S, class P, class R> inline To fixed_cast(const Fixed<I,F,S,P,R>& x) {
+    static_assert(sizeof(S) <= 4 && sizeof(typename To::storage_type) <= 4, "fixed_cast is for formats of up to 32 bits");
+    const int shift = To::frac_bits - F;
+    int64_t raw = x.Raw();
+    if (shift >= 0)
+        raw *= (int64_t(1) << (shift >= 0 ? shift : 0));
+    else
+        raw >>= (shift < 0 ? -shift : 0);
+    return To::FromRaw(To::overflow_policy::template from_int64<typename To::storage_type>(raw, 0));
+}
+
+#ifdef IOSTREAMS
+/*!\brief The generic testharness, using values that every format can hold exactly.
+*/
+template <int IntBits, int FracBits, class Storage, class Overflow, class Rounding> void Fixed<IntBits,FracBits,Storage,Overflow,Rounding>::testharness()
+{
+    cout << "Fixed<" << IntBits << "," << FracBits << "> testharness" << endl;
+
+    Fixed a = FromDouble(0.5);
+    Fixed b = FromDouble(-0.375);
+
+    test_result("a + b", (a + b), FromDouble(0.125));
+    test_result("a - b", (a - b), FromDouble(0.875));
+    test_result("-b", (-b), FromDouble(0.375));
+    test_result("a * b", FromProduct(a * b), FromDouble(-0.1875));
+    test_result("a *= b", (Fixed(a) *= b), FromDouble(-0.1875));
+    test_result("a >> 2", (a >> 2), FromDouble(0.125));
+    test_result("abs(b)", abs(b), FromDouble(0.375));
+    test_result("PRECISION()", PRECISION().toDouble(), 1.0 / double(int64_t(1) << FracBits));
+    test_result("fixed_cast", fixed_cast<Fixed>(fixed_cast<Fixed16>(b)), b);
+}
+#endif
+
+/*
+* Newton steps taken by reciprocal() and invsqrt() after their table seed.
+* Each step doubles the number of correct bits: 1 step gives about 14 bits,
+* 2 give full Fixed16 precision.
+*/
+#ifndef FIXED_RECIPROCAL_ITERATIONS
+    #define FIXED_RECIPROCAL_ITERATIONS 2
+#endif
+#ifndef FIXED_INVSQRT_ITERATIONS
+    #define FIXED_INVSQRT_ITERATIONS 2
+#endif
+
 Fixed16 sqrt(const Fixed16& x);
 Fixed16 invsqrt(const Fixed16& x);
 Fixed16 sqrt(const Fixed32& x);
+f_int32 invsqrt_wide(const Fixed32& x, int& shift);
 
 Fixed16 round(const Fixed16& f);
 
@@ -483,6 +1190,7 @@ Fixed16 round(const Fixed16& f);
 Fixed16 sin(const Fixed16& f);
 Fixed16 cos(const Fixed16& f);
 Fixed16 tan(const Fixed16& f);
+void sincos(const Fixed16& f, Fixed16& s, Fixed16& c);
     
 Fixed16 arcsin(const Fixed16& f);
 Fixed16 arccos(const Fixed16& f);
@@ -0,0 +1,305 @@
+#ifndef __FixedBatchLanes__
+#define __FixedBatchLanes__
+/*
+FixedBatchLanes.h. The SIMD lanes shared by the batch kernels.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+This header is internal to FixedVectorBatch.cpp and FixedComplexBatch.cpp.
+Its functions are static, so each of them gets its own copy.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Fixed.h"
+
+/* The SIMD kernels round as the default Fixed16 does */
+#if !defined(FIXED_NO_SIMD) && defined(FIXED16_DEFAULT_ROUNDING)
+    #if defined(__AVX2__)
+        #define FIXED_BATCH_AVX2
+    #elif defined(__SSE4_1__)
+        #define FIXED_BATCH_SSE41
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define FIXED_BATCH_NEON
+    #endif
+#endif
+
+/*
+* Each instruction set provides the same few operations on a register of
+* LANES raw Fixed16 values. mult_wide() forms the exact 64 bit products, as
+* Fixed16 * Fixed16 does, and narrow() keeps bits 16 to 47 of them, as
+* Fixed16::FromFixed32() does. narrow_round() rounds them instead, as
+* Fixed16::FromAccumulator() does, so the kernels built on them give the same bits as
+* the scalar functions. narrow_q30() rounds a Q30 x Q16 product to Q16, as
+* rotate_many() does. Without SIMD a register is a single f_int32, and
+* narrow() and narrow_round() follow Fixed16's rounding policy. The
+* vectors left over at the end of a batch go through the scalar functions.
+*/
+#if defined(FIXED_BATCH_AVX2)
+
+#include <immintrin.h>
+
+static const size_t LANES = 8;
+
+typedef __m256i lanes;
+struct wide_lanes { __m256i even, odd; };
+
+static inline lanes load(const f_int32* p) { return _mm256_load_si256((const __m256i*)p); }
+static inline void store(f_int32* p, lanes v) { _mm256_storeu_si256((__m256i*)p, v); }
+static inline lanes broadcast(f_int32 x) { return _mm256_set1_epi32(x); }
+static inline lanes add_lanes(lanes a, lanes b) { return _mm256_add_epi32(a, b); }
+static inline lanes abs_lanes(lanes a) { return _mm256_abs_epi32(a); }
+static inline lanes max_lanes(lanes a, lanes b) { return _mm256_max_epi32(a, b); }
+
+/* _mm256_mul_epi32 multiplies the even lanes, so shift the odd lanes down to meet it */
+static inline wide_lanes mult_wide(lanes a, lanes b) {
+	wide_lanes w;
+	w.even = _mm256_mul_epi32(a, b);
+	w.odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	return w;
+}
+static inline wide_lanes add_wide(wide_lanes a, wide_lanes b) {
+	wide_lanes w;
+	w.even = _mm256_add_epi64(a.even, b.even);
+	w.odd = _mm256_add_epi64(a.odd, b.odd);
+	return w;
+}
+static inline wide_lanes sub_wide(wide_lanes a, wide_lanes b) {
+	wide_lanes w;
+	w.even = _mm256_sub_epi64(a.even, b.even);
+	w.odd = _mm256_sub_epi64(a.odd, b.odd);
+	return w;
+}
+static inline lanes narrow(wide_lanes w) {
+	return _mm256_blend_epi32(_mm256_srli_epi64(w.even, 16), _mm256_slli_epi64(w.odd, 16), 0xAA);
+}
+static inline lanes narrow_round(wide_lanes w) {
+	__m256i half = _mm256_set1_epi64x(int64_t(1) << 15);
+	return _mm256_blend_epi32(_mm256_srli_epi64(_mm256_add_epi64(w.even, half), 16),
+				_mm256_slli_epi64(_mm256_add_epi64(w.odd, half), 16), 0xAA);
+}
+static inline lanes narrow_q30(wide_lanes w) {
+	__m256i half = _mm256_set1_epi64x(int64_t(1) << 29);
+	return _mm256_blend_epi32(_mm256_srli_epi64(_mm256_add_epi64(w.even, half), 30),
+				_mm256_slli_epi64(_mm256_add_epi64(w.odd, half), 2), 0xAA);
+}
+
+/* Interleave the even and odd lanes back into order */
+typedef int64_t wide_raw;
+static inline void store_wide(wide_raw* p, wide_lanes w) {
+	__m256i low = _mm256_unpacklo_epi64(w.even, w.odd);     // lanes 0, 1, 4, 5
+	__m256i high = _mm256_unpackhi_epi64(w.even, w.odd);    // lanes 2, 3, 6, 7
+	_mm256_storeu_si256((__m256i*)p, _mm256_permute2x128_si256(low, high, 0x20));
+	_mm256_storeu_si256((__m256i*)(p + 4), _mm256_permute2x128_si256(low, high, 0x31));
+}
+
+#elif defined(FIXED_BATCH_SSE41)
+
+#include <smmintrin.h>
+
+static const size_t LANES = 4;
+
+typedef __m128i lanes;
+struct wide_lanes { __m128i even, odd; };
+
+static inline lanes load(const f_int32* p) { return _mm_load_si128((const __m128i*)p); }
+static inline void store(f_int32* p, lanes v) { _mm_storeu_si128((__m128i*)p, v); }
+static inline lanes broadcast(f_int32 x) { return _mm_set1_epi32(x); }
+static inline lanes add_lanes(lanes a, lanes b) { return _mm_add_epi32(a, b); }
+static inline lanes abs_lanes(lanes a) { return _mm_abs_epi32(a); }
+static inline lanes max_lanes(lanes a, lanes b) { return _mm_max_epi32(a, b); }
+
+/* _mm_mul_epi32 multiplies the even lanes, so shift the odd lanes down to meet it */
+static inline wide_lanes mult_wide(lanes a, lanes b) {
+	wide_lanes w;
+	w.even = _mm_mul_epi32(a, b);
+	w.odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return w;
+}
+static inline wide_lanes add_wide(wide_lanes a, wide_lanes b) {
+	wide_lanes w;
+	w.even = _mm_add_epi64(a.even, b.even);
+	w.odd = _mm_add_epi64(a.odd, b.odd);
+	return w;
+}
+static inline wide_lanes sub_wide(wide_lanes a, wide_lanes b) {
+	wide_lanes w;
+	w.even = _mm_sub_epi64(a.even, b.even);
+	w.odd = _mm_sub_epi64(a.odd, b.odd);
+	return w;
+}
+static inline lanes narrow(wide_lanes w) {
+	return _mm_blend_epi16(_mm_srli_epi64(w.even, 16), _mm_slli_epi64(w.odd, 16), 0xCC);
+}
+static inline lanes narrow_round(wide_lanes w) {
+	__m128i half = _mm_set1_epi64x(int64_t(1) << 15);
+	return _mm_blend_epi16(_mm_srli_epi64(_mm_add_epi64(w.even, half), 16),
+				_mm_slli_epi64(_mm_add_epi64(w.odd, half), 16), 0xCC);
+}
+static inline lanes narrow_q30(wide_lanes w) {
+	__m128i half = _mm_set1_epi64x(int64_t(1) << 29);
+	return _mm_blend_epi16(_mm_srli_epi64(_mm_add_epi64(w.even, half), 30),
+				_mm_slli_epi64(_mm_add_epi64(w.odd, half), 2), 0xCC);
+}
+
+/* Interleave the even and odd lanes back into order */
+typedef int64_t wide_raw;
+static inline void store_wide(wide_raw* p, wide_lanes w) {
+	_mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi64(w.even, w.odd));
+	_mm_storeu_si128((__m128i*)(p + 2), _mm_unpackhi_epi64(w.even, w.odd));
+}
+
+#elif defined(FIXED_BATCH_NEON)
+
+#include <arm_neon.h>
+
+static const size_t LANES = 4;
+
+typedef int32x4_t lanes;
+struct wide_lanes { int64x2_t low, high; };
+
+static inline lanes load(const f_int32* p) { return vld1q_s32(p); }
+static inline void store(f_int32* p, lanes v) { vst1q_s32(p, v); }
+static inline lanes broadcast(f_int32 x) { return vdupq_n_s32(x); }
+static inline lanes add_lanes(lanes a, lanes b) { return vaddq_s32(a, b); }
+static inline lanes abs_lanes(lanes a) { return vabsq_s32(a); }
+static inline lanes max_lanes(lanes a, lanes b) { return vmaxq_s32(a, b); }
+
+static inline wide_lanes mult_wide(lanes a, lanes b) {
+	wide_lanes w;
+	w.low = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+	w.high = vmull_s32(vget_high_s32(a), vget_high_s32(b));
+	return w;
+}
+static inline wide_lanes add_wide(wide_lanes a, wide_lanes b) {
+	wide_lanes w;
+	w.low = vaddq_s64(a.low, b.low);
+	w.high = vaddq_s64(a.high, b.high);
+	return w;
+}
+static inline wide_lanes sub_wide(wide_lanes a, wide_lanes b) {
+	wide_lanes w;
+	w.low = vsubq_s64(a.low, b.low);
+	w.high = vsubq_s64(a.high, b.high);
+	return w;
+}
+static inline lanes narrow(wide_lanes w) {
+	return vcombine_s32(vshrn_n_s64(w.low, 16), vshrn_n_s64(w.high, 16));
+}
+static inline lanes narrow_round(wide_lanes w) {
+	return vcombine_s32(vrshrn_n_s64(w.low, 16), vrshrn_n_s64(w.high, 16));
+}
+static inline lanes narrow_q30(wide_lanes w) {
+	return vcombine_s32(vrshrn_n_s64(w.low, 30), vrshrn_n_s64(w.high, 30));
+}
+
+typedef int64_t wide_raw;
+static inline void store_wide(wide_raw* p, wide_lanes w) {
+	vst1q_s64(p, w.low);
+	vst1q_s64(p + 2, w.high);
+}
+
+#else
+
+static const size_t LANES = 1;
+
+typedef f_int32 lanes;
+typedef f_int64 wide_lanes;
+
+static inline lanes load(const f_int32* p) { return *p; }
+static inline void store(f_int32* p, lanes v) { *p = v; }
+static inline lanes broadcast(f_int32 x) { return x; }
+static inline lanes add_lanes(lanes a, lanes b) { return f_int32(f_uint32(a) + f_uint32(b)); }
+static inline lanes abs_lanes(lanes a) { return (a < 0) ? f_int32(0u - f_uint32(a)) : a; }
+static inline lanes max_lanes(lanes a, lanes b) { return (a > b) ? a : b; }
+
+static inline wide_lanes mult_wide(lanes a, lanes b) { return f_int64::mult32(a, b); }
+static inline wide_lanes add_wide(const wide_lanes& a, const wide_lanes& b) { return a + b; }
+static inline wide_lanes sub_wide(const wide_lanes& a, const wide_lanes& b) { return a - b; }
+static inline lanes narrow_shr16(const wide_lanes& w) {
+	return f_int32((f_uint32(w.GetHi()) << 16) | (w.GetLo() >> 16));
+}
+static inline lanes narrow(const wide_lanes& w) {
+	return narrow_shr16(Fixed16::rounding_policy::add_bias<f_int32>(w, 16));
+}
+static inline lanes narrow_round(const wide_lanes& w) {
+	return narrow_shr16(Fixed16::rounding_policy::accumulator::add_bias<f_int32>(w, 16));
+}
+static inline lanes narrow_q30(const wide_lanes& w) {
+	return ((w + f_int64(f_int32(1) << 29)) >> 30).toInt32();
+}
+
+typedef f_int64 wide_raw;
+static inline void store_wide(wide_raw* p, const wide_lanes& w) { *p = w; }
+
+#endif
+
+/* A stored wide lane as the raw value of a Fixed32 */
+static inline Fixed32 wide_value(const int64_t& w) { return Fixed32::FromRaw(f_int64(f_int32(w >> 32), f_uint32(w))); }
+static inline Fixed32 wide_value(const f_int64& w) { return Fixed32::FromRaw(w); }
+
+/* Fixed16 results are stored straight into the caller's array */
+static_assert(sizeof(Fixed16) == sizeof(f_int32), "Fixed16 must be a bare f_int32");
+
+static inline f_int32* raw(Fixed16* p) { return reinterpret_cast<f_int32*>(p); }
+
+/* The narrowed product of each lane, a * b */
+static inline lanes mult_lanes(lanes a, lanes b) {
+	return narrow(mult_wide(a, b));
+}
+
+/* The rounded sum of products of each lane, a1 * b1 + a2 * b2 + a3 * b3 */
+static inline lanes dot_lanes(lanes a1, lanes b1, lanes a2, lanes b2, lanes a3, lanes b3) {
+	return narrow_round(add_wide(add_wide(mult_wide(a1, b1), mult_wide(a2, b2)), mult_wide(a3, b3)));
+}
+
+/* The rounded sum of products of each lane, a1 * b1 + a2 * b2 */
+static inline lanes sum2_lanes(lanes a1, lanes b1, lanes a2, lanes b2) {
+	return narrow_round(add_wide(mult_wide(a1, b1), mult_wide(a2, b2)));
+}
+
+/* The rounded difference of products of each lane, a1 * b1 - a2 * b2 */
+static inline lanes cross_lanes(lanes a1, lanes b1, lanes a2, lanes b2) {
+	return narrow_round(sub_wide(mult_wide(a1, b1), mult_wide(a2, b2)));
+}
+
+/* The instruction set the lanes were built for: "avx2", "sse4.1", "neon" or "scalar" */
+static inline const char* batch_kernel()
+{
+#if defined(FIXED_BATCH_AVX2)
+	return "avx2";
+#elif defined(FIXED_BATCH_SSE41)
+	return "sse4.1";
+#elif defined(FIXED_BATCH_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+#endif /* __FixedBatchLanes__ */
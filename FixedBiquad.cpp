@@ -0,0 +1,282 @@
+/*
+FixedBiquad.cpp. The section kernels for FixedBiquadCascade.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+#include "FixedBiquad.h"
+
+/* The SIMD kernels round as the default Fixed16 does */
+#if !defined(FIXED_NO_SIMD) && defined(FIXED16_DEFAULT_ROUNDING)
+	#if defined(__AVX2__)
+		#define FIXED_BIQUAD_AVX2
+	#elif defined(__SSE4_1__)
+		#define FIXED_BIQUAD_SSE41
+	#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define FIXED_BIQUAD_NEON
+	#endif
+#endif
+
+/* The coefficients are Q2.30, so a sum of products has 30 more fractional bits than its output */
+static const int COEFF_BITS = 30;
+static const f_uint32 ERROR_MASK = (f_uint32(1) << COEFF_BITS) - 1;
+
+/*
+* state holds channels of each of x[n-1], x[n-2], y[n-1], y[n-2] and the
+* error. A kernel loads channel c's from state + c, state + channels + c, ...
+*/
+
+/* Channel c alone, with f_int64 */
+template <bool Feedback> static void section_scalar(const f_int32* coeff, f_int32* state, int channels, int c,
+	f_int32* data, size_t frames)
+{
+	typedef fixed_storage_traits<f_int32> traits;
+	f_int32 x1 = state[c], x2 = state[channels + c];
+	f_int32 y1 = state[2*channels + c], y2 = state[3*channels + c];
+	f_int32 e = state[4*channels + c];
+
+	for (size_t n = 0; n < frames; n++)
+	{
+		f_int32* x = data + n*channels + c;
+		f_int64 acc = f_int64::mult32(*x, coeff[0]);
+		acc += f_int64::mult32(x1, coeff[1]);
+		acc += f_int64::mult32(x2, coeff[2]);
+		acc -= f_int64::mult32(y1, coeff[3]);
+		acc -= f_int64::mult32(y2, coeff[4]);
+
+		f_int32 y;
+		if (Feedback)
+		{
+			acc += e;
+			y = traits::truncate_shr(acc, COEFF_BITS);
+			e = f_int32(acc.GetLo() & ERROR_MASK);
+		}
+		else
+			y = traits::truncate_shr(Fixed16::rounding_policy::add_bias<f_int32>(acc, COEFF_BITS), COEFF_BITS);
+
+		x2 = x1; x1 = *x;
+		y2 = y1; y1 = y;
+		*x = y;
+	}
+
+	state[c] = x1; state[channels + c] = x2;
+	state[2*channels + c] = y1; state[3*channels + c] = y2;
+	state[4*channels + c] = e;
+}
+
+/*
+* The SIMD kernels hold each channel's samples in a 64 bit lane, and only
+* the low 32 bits of each lane matter: the multiplies read them as signed,
+* and the low 32 bits of acc >> 30 are the same whether the shift is
+* arithmetic or logical. The fed back error is the low 30 bits of acc.
+*/
+#if defined(FIXED_BIQUAD_AVX2)
+
+#include <immintrin.h>
+
+static const int LANES = 4;
+
+static inline __m256i load_lanes(const f_int32* p) {
+	return _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)p));
+}
+
+static inline void store_lanes(f_int32* p, __m256i v) {
+	const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	_mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, even)));
+}
+
+template <bool Feedback> static void section_lanes(const f_int32* coeff, f_int32* state, int channels, int c,
+	f_int32* data, size_t frames)
+{
+	const __m256i b0 = _mm256_set1_epi64x(coeff[0]), b1 = _mm256_set1_epi64x(coeff[1]), b2 = _mm256_set1_epi64x(coeff[2]);
+	const __m256i a1 = _mm256_set1_epi64x(coeff[3]), a2 = _mm256_set1_epi64x(coeff[4]);
+	const __m256i mask = _mm256_set1_epi64x(ERROR_MASK);
+
+	__m256i x1 = load_lanes(state + c), x2 = load_lanes(state + channels + c);
+	__m256i y1 = load_lanes(state + 2*channels + c), y2 = load_lanes(state + 3*channels + c);
+	__m256i e = load_lanes(state + 4*channels + c);
+
+	for (size_t n = 0; n < frames; n++)
+	{
+		f_int32* p = data + n*channels + c;
+		__m256i x = load_lanes(p);
+		__m256i acc = _mm256_add_epi64(_mm256_mul_epi32(x, b0), _mm256_mul_epi32(x1, b1));
+		acc = _mm256_add_epi64(acc, _mm256_mul_epi32(x2, b2));
+		acc = _mm256_sub_epi64(acc, _mm256_mul_epi32(y1, a1));
+		acc = _mm256_sub_epi64(acc, _mm256_mul_epi32(y2, a2));
+		if (Feedback)
+		{
+			acc = _mm256_add_epi64(acc, e);
+			e = _mm256_and_si256(acc, mask);
+		}
+		__m256i y = _mm256_srli_epi64(acc, COEFF_BITS);
+		store_lanes(p, y);
+
+		x2 = x1; x1 = x;
+		y2 = y1; y1 = y;
+	}
+
+	store_lanes(state + c, x1); store_lanes(state + channels + c, x2);
+	store_lanes(state + 2*channels + c, y1); store_lanes(state + 3*channels + c, y2);
+	store_lanes(state + 4*channels + c, e);
+}
+
+#elif defined(FIXED_BIQUAD_SSE41)
+
+#include <smmintrin.h>
+
+static const int LANES = 2;
+
+static inline __m128i load_lanes(const f_int32* p) {
+	return _mm_cvtepi32_epi64(_mm_loadl_epi64((const __m128i*)p));
+}
+
+static inline void store_lanes(f_int32* p, __m128i v) {
+	_mm_storel_epi64((__m128i*)p, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+template <bool Feedback> static void section_lanes(const f_int32* coeff, f_int32* state, int channels, int c,
+	f_int32* data, size_t frames)
+{
+	const __m128i b0 = _mm_set1_epi64x(coeff[0]), b1 = _mm_set1_epi64x(coeff[1]), b2 = _mm_set1_epi64x(coeff[2]);
+	const __m128i a1 = _mm_set1_epi64x(coeff[3]), a2 = _mm_set1_epi64x(coeff[4]);
+	const __m128i mask = _mm_set1_epi64x(ERROR_MASK);
+
+	__m128i x1 = load_lanes(state + c), x2 = load_lanes(state + channels + c);
+	__m128i y1 = load_lanes(state + 2*channels + c), y2 = load_lanes(state + 3*channels + c);
+	__m128i e = load_lanes(state + 4*channels + c);
+
+	for (size_t n = 0; n < frames; n++)
+	{
+		f_int32* p = data + n*channels + c;
+		__m128i x = load_lanes(p);
+		__m128i acc = _mm_add_epi64(_mm_mul_epi32(x, b0), _mm_mul_epi32(x1, b1));
+		acc = _mm_add_epi64(acc, _mm_mul_epi32(x2, b2));
+		acc = _mm_sub_epi64(acc, _mm_mul_epi32(y1, a1));
+		acc = _mm_sub_epi64(acc, _mm_mul_epi32(y2, a2));
+		if (Feedback)
+		{
+			acc = _mm_add_epi64(acc, e);
+			e = _mm_and_si128(acc, mask);
+		}
+		__m128i y = _mm_srli_epi64(acc, COEFF_BITS);
+		store_lanes(p, y);
+
+		x2 = x1; x1 = x;
+		y2 = y1; y1 = y;
+	}
+
+	store_lanes(state + c, x1); store_lanes(state + channels + c, x2);
+	store_lanes(state + 2*channels + c, y1); store_lanes(state + 3*channels + c, y2);
+	store_lanes(state + 4*channels + c, e);
+}
+
+#elif defined(FIXED_BIQUAD_NEON)
+
+#include <arm_neon.h>
+
+static const int LANES = 2;
+
+template <bool Feedback> static void section_lanes(const f_int32* coeff, f_int32* state, int channels, int c,
+	f_int32* data, size_t frames)
+{
+	const int32x2_t b0 = vdup_n_s32(coeff[0]), b1 = vdup_n_s32(coeff[1]), b2 = vdup_n_s32(coeff[2]);
+	const int32x2_t a1 = vdup_n_s32(coeff[3]), a2 = vdup_n_s32(coeff[4]);
+	const int64x2_t mask = vdupq_n_s64(ERROR_MASK);
+
+	int32x2_t x1 = vld1_s32(state + c), x2 = vld1_s32(state + channels + c);
+	int32x2_t y1 = vld1_s32(state + 2*channels + c), y2 = vld1_s32(state + 3*channels + c);
+	int32x2_t e = vld1_s32(state + 4*channels + c);
+
+	for (size_t n = 0; n < frames; n++)
+	{
+		f_int32* p = data + n*channels + c;
+		int32x2_t x = vld1_s32(p);
+		int64x2_t acc = vmull_s32(x, b0);
+		acc = vmlal_s32(acc, x1, b1);
+		acc = vmlal_s32(acc, x2, b2);
+		acc = vmlsl_s32(acc, y1, a1);
+		acc = vmlsl_s32(acc, y2, a2);
+		if (Feedback)
+		{
+			acc = vaddq_s64(acc, vmovl_s32(e));    // e is never negative
+			e = vmovn_s64(vandq_s64(acc, mask));
+		}
+		int32x2_t y = vshrn_n_s64(acc, COEFF_BITS);
+		vst1_s32(p, y);
+
+		x2 = x1; x1 = x;
+		y2 = y1; y1 = y;
+	}
+
+	vst1_s32(state + c, x1); vst1_s32(state + channels + c, x2);
+	vst1_s32(state + 2*channels + c, y1); vst1_s32(state + 3*channels + c, y2);
+	vst1_s32(state + 4*channels + c, e);
+}
+
+#else
+
+static const int LANES = 1;
+
+template <bool Feedback> static void section_lanes(const f_int32* coeff, f_int32* state, int channels, int c,
+	f_int32* data, size_t frames)
+{
+	section_scalar<Feedback>(coeff, state, channels, c, data, frames);
+}
+
+#endif
+
+template <bool Feedback> static void section(const f_int32* coeff, f_int32* state, int channels,
+	f_int32* data, size_t frames)
+{
+	int c = 0;
+	for (; c + LANES <= channels; c += LANES)
+		section_lanes<Feedback>(coeff, state, channels, c, data, frames);
+	for (; c < channels; c++)
+		section_scalar<Feedback>(coeff, state, channels, c, data, frames);
+}
+
+void fixed_biquad_section(const f_int32* coeff, f_int32* state, int channels,
+	f_int32* data, size_t frames, bool error_feedback)
+{
+	if (error_feedback)
+		section<true>(coeff, state, channels, data, frames);
+	else
+		section<false>(coeff, state, channels, data, frames);
+}
+
+const char* fixed_biquad_kernel()
+{
+#if defined(FIXED_BIQUAD_AVX2)
+	return "avx2";
+#elif defined(FIXED_BIQUAD_SSE41)
+	return "sse4.1";
+#elif defined(FIXED_BIQUAD_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
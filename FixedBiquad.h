@@ -0,0 +1,281 @@
+#ifndef __FixedBiquad__
+#define __FixedBiquad__
+/*
+FixedBiquad.h. Cascades of fixed point second order IIR sections.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedBiquadCascade
+
+FixedBiquadCascade<2, 4> eq;                    // 2 sections, 4 interleaved channels
+eq.set_section(0, b0, b1, b2, a1, a2);          // doubles, quantized once here
+eq.set_section(1, ...);
+
+eq.process(in, out, 256);                       // 256 frames of 4 samples (in may be out)
+eq.reset();                                     // forget the past samples
+
+FixedBiquadCascade<1> lowpass;                  // one channel
+Fixed16 y = lowpass.process(x);                 // one sample at a time
+
+Each section is y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+in Direct Form I, with a0 taken as 1. The coefficients are held as Q2.30,
+so each must be greater than -2 and less than 2. Others throw with
+IOSTREAMS defined, and are clamped to the ends of the range otherwise.
+The five products are summed exactly in 64 bits and narrowed once to the
+section's output.
+
+With error feedback (the default) the bits that narrowing drops from each
+output are added into the next sum of the same section, so the rounding
+errors no longer pile up into an offset or a limit cycle. Without it each
+output is narrowed as Fixed16 narrows a product, which truncates by default.
+
+Each section runs over a whole block before the next one does. When the
+compiler targets AVX2, SSE4.1 or NEON, fixed_biquad_section() runs 4 (AVX2)
+or 2 channels at a time, and gives the same bits as the plain loop used for
+the rest. Define FIXED_NO_SIMD to always use the plain loop.
+
+As with the FixedVectorBatch kernels, outputs that overflow wrap around
+rather than being checked, so leave headroom in the gains of the sections.
+*/
+
+#include <stddef.h>
+
+#include "Fixed.h"
+
+/*!\brief Run one section in place over frames interleaved frames of
+    channels samples.
+
+* coeff is b0, b1, b2, a1 and a2 as raw Q2.30 values. state is x[n-1],
+* x[n-2], y[n-1], y[n-2] and the fed back error, channels of each.
+*/
+void fixed_biquad_section(const f_int32* coeff, f_int32* state, int channels,
+    f_int32* data, size_t frames, bool error_feedback);
+
+/*!\brief The instruction set that fixed_biquad_section() was built for: "avx2", "sse4.1", "neon" or "scalar"
+*/
+const char* fixed_biquad_kernel();
+
+/*!\brief Sections second order IIR filters in series, on Channels
+    interleaved channels of Fixed16 samples.
+*/
+template <int Sections, int Channels = 1> class FixedBiquadCascade
+{
+    static_assert(Sections >= 1, "a FixedBiquadCascade needs at least one section");
+    static_assert(Channels >= 1, "a FixedBiquadCascade needs at least one channel");
+    static_assert(sizeof(Fixed16) == sizeof(f_int32), "Fixed16 must be a bare f_int32");
+
+public:
+    static const int sections = Sections;
+    static const int channels = Channels;
+
+    /*!\brief Every section passes its input straight through */
+    explicit FixedBiquadCascade(bool error_feedback = true) : m_error_feedback(error_feedback) {
+        for (int s = 0; s < Sections; s++)
+            set_section(s, 1, 0, 0, 0, 0);
+        reset();
+    }
+
+    /*!\brief Quantize the coefficients of section s to Q2.30. a0 is taken as 1. The past samples are kept. */
+    void set_section(int s, double b0, double b1, double b2, double a1, double a2) {
+        m_coeff[s][0] = quantize(b0);
+        m_coeff[s][1] = quantize(b1);
+        m_coeff[s][2] = quantize(b2);
+        m_coeff[s][3] = quantize(a1);
+        m_coeff[s][4] = quantize(a2);
+    }
+
+    /*!\brief Coefficient k (b0, b1, b2, a1, a2) of section s, as quantized */
+    FixedQ2_30 coefficient(int s, int k) const {
+        return FixedQ2_30::FromRaw(m_coeff[s][k]);
+    }
+
+    void set_error_feedback(bool on) { m_error_feedback = on; }
+    bool error_feedback() const { return m_error_feedback; }
+
+    /*!\brief Set every past sample, and the fed back errors, to zero */
+    void reset() {
+        for (int s = 0; s < Sections; s++)
+            for (int k = 0; k < 5*Channels; k++)
+                m_state[s][k] = 0;
+    }
+
+    /*!\brief Filter frames frames of Channels interleaved samples. in and out may be the same array. */
+    void process(const Fixed16* in, Fixed16* out, size_t frames) {
+        if (in != out)
+            for (size_t i = 0; i < frames*Channels; i++)
+                out[i] = in[i];
+        f_int32* data = reinterpret_cast<f_int32*>(out);
+        for (int s = 0; s < Sections; s++)
+            fixed_biquad_section(m_coeff[s], m_state[s], Channels, data, frames, m_error_feedback);
+    }
+
+    /*!\brief Filter one sample of a single channel cascade */
+    Fixed16 process(const Fixed16& x) {
+        static_assert(Channels == 1, "process(x) is for a single channel");
+        Fixed16 y = x;
+        process(&y, &y, 1);
+        return y;
+    }
+
+#ifdef IOSTREAMS
+    static void testharness();
+#endif
+
+private:
+    static f_int32 quantize(double c) {
+#ifdef IOSTREAMS
+        if (c <= -2.0 || c >= 2.0)
+        {
+            cout << "FixedBiquadCascade coefficient out of range " << c << endl;
+            throw -1;
+        }
+#endif
+        /* Otherwise clamp both ends, so that f_int32(q) is always in range */
+        double q = c * double(1 << 30);
+        q = (q < 0) ? q - 0.5 : q + 0.5;
+        if (q >= 2147483647.0)
+            return f_int32(0x7FFFFFFF);
+        if (q <= -2147483648.0)
+            return f_int32(0x80000000u);
+        return f_int32(q);
+    }
+
+    f_int32 m_coeff[Sections][5];
+    f_int32 m_state[Sections][5*Channels];    // x[n-1], x[n-2], y[n-1], y[n-2], error
+    bool m_error_feedback;
+};
+
+#ifdef IOSTREAMS
+/* Lowpass sections, from gentle to resonant, for the testharness */
+static const double fixed_biquad_test_sections[4][5] = {
+    { 0.183712674, 0.367425347, 0.183712674, -0.328635221, 0.063485916 },
+    { 0.020083331, 0.040166662, 0.020083331, -1.561015391, 0.641348715 },
+    { 0.076705515, 0.153411030, 0.076705515, -1.299719105, 0.606541165 },
+    { 0.003893847, 0.007787693, 0.003893847, -1.959668247, 0.975243633 },
+};
+
+template <int Sections, int Channels> void FixedBiquadCascade<Sections,Channels>::testharness()
+{
+    cout << "FixedBiquadCascade<" << Sections << "," << Channels << "> testharness (" << fixed_biquad_kernel() << ")" << endl;
+
+    FixedBiquadCascade iir;
+    for (int s = 0; s < Sections; s++)
+    {
+        const double* c = fixed_biquad_test_sections[s % 4];
+        iir.set_section(s, c[0], c[1], c[2], c[3], c[4]);
+    }
+    test_result("coefficient(0, 3)", iir.coefficient(0, 3).toDouble(), fixed_biquad_test_sections[0][3], 1.0 / (1 << 30));
+
+    /* Pseudo-random samples between -8 and 8, a different stream on each channel */
+    const int N = 300;
+    Fixed16 in[N*Channels];
+    f_uint32 seed = 12345;
+    test_fill(in, N*Channels, seed, 12);
+
+    /* Against the definition, one channel and one sample at a time, with and without error feedback */
+    for (int feedback = 0; feedback < 2; feedback++)
+    {
+        iir.set_error_feedback(feedback != 0);
+        iir.reset();
+        Fixed16 out[N*Channels], expected[N*Channels];
+        iir.process(in, out, N);
+
+        for (int c = 0; c < Channels; c++)
+        {
+            f_int32 state[Sections][5] = {};
+            for (int n = 0; n < N; n++)
+            {
+                f_int32 x = in[n*Channels + c].Raw();
+                for (int s = 0; s < Sections; s++)
+                {
+                    const f_int32* h = iir.m_coeff[s];
+                    f_int32* z = state[s];
+                    f_int64 acc = f_int64::mult32(x, h[0]);
+                    acc += f_int64::mult32(z[0], h[1]);
+                    acc += f_int64::mult32(z[1], h[2]);
+                    acc -= f_int64::mult32(z[2], h[3]);
+                    acc -= f_int64::mult32(z[3], h[4]);
+                    f_int32 y;
+                    if (feedback)
+                    {
+                        acc += z[4];
+                        y = fixed_storage_traits<f_int32>::truncate_shr(acc, 30);
+                        z[4] = f_int32(acc.GetLo() & 0x3FFFFFFF);
+                    }
+                    else
+                        y = fixed_storage_traits<f_int32>::truncate_shr(Fixed16::rounding_policy::add_bias<f_int32>(acc, 30), 30);
+                    z[1] = z[0]; z[0] = x;
+                    z[3] = z[2]; z[2] = y;
+                    x = y;
+                }
+                expected[n*Channels + c] = Fixed16::FromRaw(x);
+            }
+        }
+        test_result(feedback ? "process() mismatches, error feedback" : "process() mismatches, truncated", test_mismatches(out, expected, N*Channels), 0);
+    }
+
+    /* Blocks of any size give the same bits, in place or not */
+    Fixed16 whole[N*Channels], pieces[N*Channels];
+    iir.set_error_feedback(true);
+    iir.reset();
+    iir.process(in, whole, N);
+    iir.reset();
+    test_in_blocks(N, 5, [&](int done, int n) {
+        for (int i = 0; i < n*Channels; i++)
+            pieces[done*Channels + i] = in[done*Channels + i];
+        iir.process(pieces + done*Channels, pieces + done*Channels, n);
+    });
+    test_result("process() in pieces mismatches", test_mismatches(pieces, whole, N*Channels), 0);
+
+    /*
+    * The resonant section, rung by an impulse and left to decay. Truncated,
+    * it never gets back to zero. With error feedback it settles within a
+    * couple of LSB of it.
+    */
+    for (int feedback = 0; feedback < 2; feedback++)
+    {
+        FixedBiquadCascade<1> ring(feedback != 0);
+        const double* c = fixed_biquad_test_sections[3];
+        ring.set_section(0, c[0], c[1], c[2], c[3], c[4]);
+        ring.process(Fixed16(100));
+        f_int32 tail = 0;
+        for (int n = 1; n < 20000; n++)
+        {
+            f_int32 y = ring.process(Fixed16::zero()).Raw();
+            if (n >= 19000)
+                tail = (y < 0 ? -y : y) > tail ? (y < 0 ? -y : y) : tail;
+        }
+        if (feedback)
+            test_result("decayed output with error feedback (LSB)", double(tail), 0.0, 2.0);
+        else
+            test_result("decayed output truncated (LSB)", tail > 2, true);
+    }
+}
+#endif
+
+#endif /* __FixedBiquad__ */
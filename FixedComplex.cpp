@@ -0,0 +1,246 @@
+/*
+FixedComplex.cpp. Fixed point complex numbers, for I/Q signal processing.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include "FixedComplex.h"
+#include "FixedCordic.h"
+
+#ifdef IOSTREAMS
+#include <cmath>
+#endif
+
+#ifdef IOSTREAMS
+std::ostream& operator<<(std::ostream& os, const FixedComplex& z)
+{
+	os << "(" << z.re << "," << z.im << ")";
+	return os;
+}
+#endif
+
+FixedComplex FixedComplex::from_polar(const Fixed16& magnitude, const Fixed16& phase)
+{
+	Fixed16 s, c;
+	FixedCordic<20>::sincos(phase, s, c);
+	return FixedComplex(magnitude * c, magnitude * s);
+}
+
+FixedComplex operator+(const FixedComplex& a, const FixedComplex& b)
+{
+	return FixedComplex(a.re + b.re, a.im + b.im);
+}
+
+FixedComplex operator-(const FixedComplex& a, const FixedComplex& b)
+{
+	return FixedComplex(a.re - b.re, a.im - b.im);
+}
+
+FixedComplex operator-(const FixedComplex& a)
+{
+	return FixedComplex(-a.re, -a.im);
+}
+
+FixedComplex operator*(const FixedComplex& a, const Fixed16& b)
+{
+	return FixedComplex(a.re * b, a.im * b);
+}
+
+FixedComplex operator*(const FixedComplex& a, const FixedComplex& b)
+{
+	Fixed32 re, im;
+	Fixed16::mac(re, a.re, b.re);
+	Fixed16::msub(re, a.im, b.im);
+	Fixed16::mac(im, a.re, b.im);
+	Fixed16::mac(im, a.im, b.re);
+	return FixedComplex(Fixed16::FromAccumulator(re), Fixed16::FromAccumulator(im));
+}
+
+FixedComplex mult3(const FixedComplex& a, const FixedComplex& b)
+{
+	/* (a.re + i a.im)(b.re + i b.im) = k1 - k3 + i(k1 + k2), with every k exact */
+	Fixed32 k1 = (a.re + a.im) * b.re;
+	Fixed32 k2 = a.re * (b.im - b.re);
+	Fixed32 k3 = a.im * (b.re + b.im);
+	return FixedComplex(Fixed16::FromAccumulator(k1 - k3), Fixed16::FromAccumulator(k1 + k2));
+}
+
+FixedComplex conj(const FixedComplex& a)
+{
+	return FixedComplex(a.re, -a.im);
+}
+
+FixedComplex conj_mult(const FixedComplex& a, const FixedComplex& b)
+{
+	Fixed32 re, im;
+	Fixed16::mac(re, a.re, b.re);
+	Fixed16::mac(re, a.im, b.im);
+	Fixed16::mac(im, a.im, b.re);
+	Fixed16::msub(im, a.re, b.im);
+	return FixedComplex(Fixed16::FromAccumulator(re), Fixed16::FromAccumulator(im));
+}
+
+Fixed16 norm2(const FixedComplex& a)
+{
+	Fixed32 acc;
+	Fixed16::mac(acc, a.re, a.re);
+	Fixed16::mac(acc, a.im, a.im);
+	return Fixed16::FromAccumulator(acc);
+}
+
+Fixed16 abs(const FixedComplex& a)
+{
+	Fixed32 acc;
+	Fixed16::mac(acc, a.re, a.re);
+	Fixed16::mac(acc, a.im, a.im);
+	return sqrt(acc);
+}
+
+Fixed16 arg(const FixedComplex& a)
+{
+	/* arctan2(0, 0) is an error, but 0 is the phase polar() gives */
+	if ((a.re == Fixed16::zero()) && (a.im == Fixed16::zero()))
+		return Fixed16::zero();
+	return arctan2(a.im, a.re);
+}
+
+Fixed16 polar(const FixedComplex& a, Fixed16& magnitude)
+{
+	/* 20 iterations give the phase to within a PRECISION() */
+	return FixedCordic<20>::arctan2(a.im, a.re, magnitude);
+}
+
+
+#ifdef IOSTREAMS
+
+/*!\brief The exact raw value of a sum of two raw products, rounded to Fixed16
+	as FromAccumulator() rounds it
+*/
+static f_int32 rounded(double raw_sum)
+{
+	int64_t w = int64_t(raw_sum);
+	return Fixed16::FromAccumulator(Fixed32::FromRaw(f_int64(f_int32(w >> 32), f_uint32(w)))).Raw();
+}
+
+bool FixedComplex::testharness()
+{
+	cout << "FixedComplex testharness" << endl;
+
+	FixedComplex a(1, 2), b(3, -4);
+	test_result("(1+2i)(3-4i).re", (a * b).re, Fixed16(11));
+	test_result("(1+2i)(3-4i).im", (a * b).im, Fixed16(2));
+	test_result("conj_mult((1+2i),(3-4i)).re", conj_mult(a, b).re, Fixed16(-5));
+	test_result("conj_mult((1+2i),(3-4i)).im", conj_mult(a, b).im, Fixed16(10));
+	test_result("abs(3-4i)", abs(b), Fixed16(5));
+	test_result("norm2(1+2i)", norm2(a), Fixed16(5));
+
+	/*
+		Parts up to 64 in size, so that nothing overflows. The raw products
+		are below 2^45 and so exact in a double, as is their sum.
+	*/
+	f_int32 mult_count = 0, mult3_count = 0, conj_count = 0, norm2_count = 0;
+	f_int32 worst_abs = 0, worst_arg = 0, worst_phase = 0;
+	double worst_magnitude = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		a = FixedComplex(Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9);
+		b = FixedComplex(Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9);
+		if (i == 0) a = FixedComplex();
+		if (i == 1) b = FixedComplex(Fixed16::PRECISION(), -Fixed16::PRECISION());
+
+		double ar = a.re.Raw(), ai = a.im.Raw(), br = b.re.Raw(), bi = b.im.Raw();
+
+		FixedComplex c = a * b;
+		if ((c.re.Raw() != rounded(ar * br - ai * bi)) || (c.im.Raw() != rounded(ar * bi + ai * br)))
+			mult_count++;
+		if (mult3(a, b) != c)
+			mult3_count++;
+		if (conj_mult(a, b) != a * conj(b))
+			conj_count++;
+		if (norm2(a).Raw() != rounded(ar * ar + ai * ai))
+			norm2_count++;
+
+		double hyp = std::hypot(ar, ai);
+		f_int32 e = std::abs(abs(a).Raw() - f_int32(std::floor(hyp + 0.5)));
+		if (e > worst_abs) worst_abs = e;
+
+		double phi = std::atan2(ai, ar) * 65536.0;
+		e = std::abs(arg(a).Raw() - f_int32(std::floor(phi + 0.5)));
+		if (e > worst_arg) worst_arg = e;
+
+		/* See FixedCordic: two PRECISION() and one unit of the normalised vector a step */
+		Fixed16 m;
+		Fixed16 p = polar(a, m);
+		e = std::abs(p.Raw() - f_int32(std::floor(phi + 0.5)));
+		if (e > worst_phase) worst_phase = e;
+		double em = std::fabs(m.Raw() - hyp) / (2.0 + 20 * hyp / (1 << 28));
+		if (em > worst_magnitude) worst_magnitude = em;
+	}
+	test_result("a * b mismatches", mult_count, 0);
+	test_result("mult3(a, b) != a * b", mult3_count, 0);
+	test_result("conj_mult(a, b) != a * conj(b)", conj_count, 0);
+	test_result("norm2 mismatches", norm2_count, 0);
+	test_result("abs error", worst_abs, 0, 1);
+	/* arctan2() goes through y / x, which costs some bits */
+	test_result("arg error", worst_arg, 0, 32);
+	test_result("polar phase error", worst_phase, 0, 1);
+	test_result("polar magnitude error / bound", worst_magnitude, 0.0, 1.0);
+
+	/* The same bits from mult3 close to its limit of 16384 */
+	a = FixedComplex(Fixed16::FromRaw((16384 << 16) - 1), Fixed16::FromRaw(-(16384 << 16) + 1));
+	b = FixedComplex(Fixed16::FromRaw(3), Fixed16::FromRaw(-5));
+	test_result("mult3 near its limit re", mult3(a, b).re, (a * b).re);
+	test_result("mult3 near its limit im", mult3(a, b).im, (a * b).im);
+
+	/* from_polar undoes polar */
+	a = FixedComplex(Fixed16(-30), Fixed16(40));
+	Fixed16 m;
+	Fixed16 p = polar(a, m);
+	test_result("polar magnitude", m, Fixed16(50), Fixed16::FromRaw(2));
+	FixedComplex z = FixedComplex::from_polar(m, p);
+	test_result("from_polar(polar).re", z.re, a.re, Fixed16::FromRaw(64));
+	test_result("from_polar(polar).im", z.im, a.im, Fixed16::FromRaw(64));
+
+	/* A phasor turning by w each sample: the phase of x[n] * conj(x[n-1]) is w, as in an FM discriminator */
+	Fixed16 w = Fixed16::FromRaw(19661);   // 0.3 radians
+	FixedComplex last = FixedComplex::from_polar(Fixed16(100), Fixed16(-3));
+	f_int32 worst_w = 0;
+	for (int n = 1; n < 20; n++)
+	{
+		FixedComplex x = FixedComplex::from_polar(Fixed16(100), Fixed16::FromRaw(-3 * 65536 + n * w.Raw()));
+		p = polar(conj_mult(x, last), m);
+		f_int32 e = std::abs(p.Raw() - w.Raw());
+		if (e > worst_w) worst_w = e;
+		last = x;
+	}
+	test_result("discriminator error", worst_w, 0, 2);
+
+	return true;
+}
+
+#endif /* IOSTREAMS */
@@ -0,0 +1,156 @@
+#ifndef __FixedComplex__
+#define __FixedComplex__
+/*
+FixedComplex.h. Fixed point complex numbers, for I/Q signal processing.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedComplex
+
+FixedComplex a(1, 2), b(Fixed16::FromRaw(-70000), Fixed16(3));
+FixedComplex c = a * b;             // four multiplies, one rounding per part
+c = mult3(a, b);                    // three multiplies, the same bits
+c = conj_mult(a, b);                // a * conj(b), the phase difference
+Fixed16 r, phi = polar(c, r);       // phase and magnitude together (CORDIC)
+c = FixedComplex::from_polar(r, phi);
+
+Each product is summed exactly in 64 bits and rounded once, as dot() and
+cross() do for a FixedVector, so a * b and conj_mult(a, b) are correct to
+half a PRECISION().
+
+mult3() forms k1 = c(a + b), k2 = a(d - c) and k3 = b(c + d) for the product
+of a + ib and c + id, which is then k1 - k3 + i(k1 + k2). The three products
+are exact, so the result is the same as a * b, for one Fixed16 multiply
+less. It is worth having where a multiply is expensive (without
+NATIVE_64BIT each is a call into f_int64), but the sums a + b, d - c and
+c + d must not overflow, so each part of a and b must stay below 16384 in
+size.
+
+polar() runs CORDIC in vectoring mode, which gives the phase to within a
+PRECISION() and the magnitude in one pass of shifts and adds, for less than
+abs() and arg() cost between them. abs() is sqrt(const Fixed32&) of
+the exact sum of squares, rounded to nearest. arg() is the library's
+arctan2(), which divides y by x and can be some tens of PRECISION() out.
+Either way the magnitude must be less than 32768.
+
+For whole blocks of samples see FixedComplexBatch.h.
+*/
+
+#include "Fixed.h"
+
+
+/*!\brief A complex number with Fixed16 real and imaginary parts.
+*/
+class FixedComplex
+{
+public:
+	FixedComplex()
+		: re(0), im(0)
+	{
+	}
+
+	FixedComplex(const Fixed16& in_re, const Fixed16& in_im)
+		: re(in_re), im(in_im)
+	{
+	}
+
+	FixedComplex(const f_int32& in_re, const f_int32& in_im)
+		: re(in_re), im(in_im)
+	{
+	}
+
+	explicit FixedComplex(const Fixed16& in_re)
+		: re(in_re), im(0)
+	{
+	}
+
+	/*!\brief magnitude * (cos(phase) + i sin(phase))
+		Runs CORDIC in rotation mode, so a value taken through polar() and
+		back is within a PRECISION() of each part times the magnitude.
+	*/
+	static FixedComplex from_polar(const Fixed16& magnitude, const Fixed16& phase);
+
+#ifdef IOSTREAMS
+	friend std::ostream& operator<<(std::ostream& os, const FixedComplex&);
+
+	static bool testharness();
+#endif
+
+	Fixed16 re,im;
+};
+
+inline bool operator==(const FixedComplex& a, const FixedComplex& b) {
+	return (a.re == b.re) && (a.im == b.im);
+}
+inline bool operator!=(const FixedComplex& a, const FixedComplex& b) {
+	return !(a == b);
+}
+
+FixedComplex operator+(const FixedComplex& a, const FixedComplex& b);
+FixedComplex operator-(const FixedComplex& a, const FixedComplex& b);
+FixedComplex operator-(const FixedComplex& a);
+FixedComplex operator*(const FixedComplex& a, const Fixed16& b);
+
+/*!\brief The complex product, from four multiplies
+*/
+FixedComplex operator*(const FixedComplex& a, const FixedComplex& b);
+
+/*!\brief The complex product, from three multiplies.
+	The same bits as a * b, as long as no part of a or b reaches 16384 in size.
+*/
+FixedComplex mult3(const FixedComplex& a, const FixedComplex& b);
+
+/*!\brief The complex conjugate, re - i im
+*/
+FixedComplex conj(const FixedComplex& a);
+
+/*!\brief a * conj(b), without forming conj(b).
+	arg(conj_mult(a, b)) is the phase of a less the phase of b.
+*/
+FixedComplex conj_mult(const FixedComplex& a, const FixedComplex& b);
+
+/*!\brief re * re + im * im, rounded once
+*/
+Fixed16 norm2(const FixedComplex& a);
+
+/*!\brief The magnitude sqrt(re * re + im * im), from the exact sum of squares,
+	rounded to nearest.
+*/
+Fixed16 abs(const FixedComplex& a);
+
+/*!\brief The phase arctan2(im, re), between -PI and PI, and zero for zero
+*/
+Fixed16 arg(const FixedComplex& a);
+
+/*!\brief Return the phase of a, and set magnitude to its magnitude.
+	Both come from one CORDIC vectoring pass. The magnitude must be less
+	than 32768.
+*/
+Fixed16 polar(const FixedComplex& a, Fixed16& magnitude);
+
+#endif /* __FixedComplex__ */
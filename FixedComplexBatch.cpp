@@ -0,0 +1,221 @@
+/*
+FixedComplexBatch.cpp. Structure-of-arrays batches of fixed point complex numbers.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "FixedComplexBatch.h"
+#include "FixedBatchLanes.h"
+
+static void check_size(const char* name, const FixedComplexBatch& a, size_t n)
+{
+#ifdef IOSTREAMS
+	if (a.size() != n)
+	{
+		cerr << name << "(FixedComplexBatch) sizes differ: " << a.size() << " != " << n << endl;
+		throw -1;
+	}
+#endif
+}
+
+
+FixedComplexBatch::FixedComplexBatch(size_t n)
+	: m_size(n)
+{
+	/* Round each array up to whole 32 byte blocks, with room to align the first */
+	size_t stride = (n + 7) & ~size_t(7);
+	m_buffer = new f_int32[2 * stride + 8];
+	for (size_t i = 0; i < 2 * stride + 8; i++)
+		m_buffer[i] = 0;
+
+	size_t offset = ((32 - (uintptr_t(m_buffer) & 31)) & 31) / sizeof(f_int32);
+	m_re = m_buffer + offset;
+	m_im = m_re + stride;
+}
+
+FixedComplexBatch::~FixedComplexBatch()
+{
+	delete[] m_buffer;
+}
+
+const char* FixedComplexBatch::kernel()
+{
+	return batch_kernel();
+}
+
+void mult(const FixedComplexBatch& a, const FixedComplexBatch& b, FixedComplexBatch& out)
+{
+	size_t n = a.size();
+	check_size("mult", b, n);
+	check_size("mult", out, n);
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes ar = load(a.re() + i), ai = load(a.im() + i);
+		lanes br = load(b.re() + i), bi = load(b.im() + i);
+		store(out.re() + i, cross_lanes(ar, br, ai, bi));
+		store(out.im() + i, sum2_lanes(ar, bi, ai, br));
+	}
+	for (; i < n; i++)
+		out.set(i, a.get(i) * b.get(i));
+}
+
+void mult(const FixedComplexBatch& a, const FixedComplex& b, FixedComplexBatch& out)
+{
+	size_t n = a.size();
+	check_size("mult", out, n);
+
+	size_t i = 0;
+	lanes br = broadcast(b.re.Raw()), bi = broadcast(b.im.Raw());
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes ar = load(a.re() + i), ai = load(a.im() + i);
+		store(out.re() + i, cross_lanes(ar, br, ai, bi));
+		store(out.im() + i, sum2_lanes(ar, bi, ai, br));
+	}
+	for (; i < n; i++)
+		out.set(i, a.get(i) * b);
+}
+
+void conj_mult(const FixedComplexBatch& a, const FixedComplexBatch& b, FixedComplexBatch& out)
+{
+	size_t n = a.size();
+	check_size("conj_mult", b, n);
+	check_size("conj_mult", out, n);
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes ar = load(a.re() + i), ai = load(a.im() + i);
+		lanes br = load(b.re() + i), bi = load(b.im() + i);
+		store(out.re() + i, sum2_lanes(ar, br, ai, bi));
+		store(out.im() + i, cross_lanes(ai, br, ar, bi));
+	}
+	for (; i < n; i++)
+		out.set(i, conj_mult(a.get(i), b.get(i)));
+}
+
+void norm2(const FixedComplexBatch& a, Fixed16* out)
+{
+	size_t n = a.size();
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes ar = load(a.re() + i), ai = load(a.im() + i);
+		store(raw(out + i), sum2_lanes(ar, ar, ai, ai));
+	}
+	for (; i < n; i++)
+		out[i] = norm2(a.get(i));
+}
+
+void polar(const FixedComplexBatch& a, Fixed16* magnitude, Fixed16* phase)
+{
+	for (size_t i = 0; i < a.size(); i++)
+		phase[i] = polar(a.get(i), magnitude[i]);
+}
+
+
+#ifdef IOSTREAMS
+
+/*!\brief The number of complex numbers in a and b that differ
+*/
+static f_int32 mismatches(const FixedComplexBatch& a, const FixedComplexBatch& b)
+{
+	f_int32 count = 0;
+	for (size_t i = 0; i < a.size(); i++)
+		if (a.get(i) != b.get(i))
+			count++;
+	return count;
+}
+
+bool FixedComplexBatch::testharness()
+{
+	cout << "FixedComplexBatch testharness (" << kernel() << " kernels)" << endl;
+
+	/* An odd size, so that the scalar code finishes off every kernel */
+	const size_t n = 1003;
+	FixedComplexBatch a(n), b(n), out(n), expected(n);
+
+	test_result("re() aligned", f_int32(uintptr_t(a.re()) & 31), 0);
+	test_result("im() aligned", f_int32(uintptr_t(a.im()) & 31), 0);
+
+	/* Parts up to 64, so that none of the scalar functions overflow */
+	for (size_t i = 0; i < n; i++)
+	{
+		a.set(i, FixedComplex(Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9));
+		b.set(i, FixedComplex(Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9));
+	}
+	a.set(0, FixedComplex());
+	a.set(1, FixedComplex(Fixed16::PRECISION(), -Fixed16::PRECISION()));
+	a.set(2, FixedComplex(Fixed16(-64), Fixed16(64)));
+
+	mult(a, b, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, a.get(i) * b.get(i));
+	test_result("mult mismatches", mismatches(out, expected), 0);
+
+	FixedComplex s(Fixed16::FromRaw(-98765), Fixed16::FromRaw(43210));
+	mult(a, s, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, a.get(i) * s);
+	test_result("mult(a, s) mismatches", mismatches(out, expected), 0);
+
+	conj_mult(a, b, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, conj_mult(a.get(i), b.get(i)));
+	test_result("conj_mult mismatches", mismatches(out, expected), 0);
+
+	/* In place, out = conj_mult(out, b) */
+	for (size_t i = 0; i < n; i++)
+		out.set(i, a.get(i));
+	conj_mult(out, b, out);
+	test_result("conj_mult in place mismatches", mismatches(out, expected), 0);
+
+	Fixed16 m[n], p[n];
+	norm2(a, m);
+	f_int32 norm2_count = 0;
+	for (size_t i = 0; i < n; i++)
+		if (m[i] != norm2(a.get(i)))
+			norm2_count++;
+	test_result("norm2 mismatches", norm2_count, 0);
+
+	polar(a, m, p);
+	f_int32 polar_count = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		Fixed16 r;
+		if ((p[i] != polar(a.get(i), r)) || (m[i] != r))
+			polar_count++;
+	}
+	test_result("polar mismatches", polar_count, 0);
+
+	return true;
+}
+
+#endif /* IOSTREAMS */
@@ -0,0 +1,116 @@
+#ifndef __FixedComplexBatch__
+#define __FixedComplexBatch__
+/*
+FixedComplexBatch.h. Structure-of-arrays batches of fixed point complex numbers.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+How to use the FixedComplexBatch
+
+FixedComplexBatch z(1000), w(1000);
+z.set(0, FixedComplex(1, 2));       // or fill z.re() and z.im() with raw values
+conj_mult(z, w, z);                 // z[i] = conj_mult(z[i], w[i])
+Fixed16 magnitude[1000], phase[1000];
+polar(z, magnitude, phase);         // phase[i] = polar(z[i], magnitude[i])
+
+The kernels give the same bits as the FixedComplex functions of the same
+name, and are built for the same instruction sets as the FixedVectorBatch
+kernels, with the same caveats: see FixedVectorBatch.h.
+*/
+
+#include <stddef.h>
+
+#include "FixedComplex.h"
+
+/*!\brief A batch of complex numbers, stored as separate arrays of the raw
+	real and imaginary parts, each aligned to 32 bytes as in a FixedVectorBatch.
+*/
+class FixedComplexBatch
+{
+public:
+	explicit FixedComplexBatch(size_t n);
+	~FixedComplexBatch();
+
+	size_t size() const { return m_size; }
+
+	f_int32* re() { return m_re; }
+	f_int32* im() { return m_im; }
+	const f_int32* re() const { return m_re; }
+	const f_int32* im() const { return m_im; }
+
+	FixedComplex get(size_t i) const {
+		return FixedComplex(Fixed16::FromRaw(m_re[i]), Fixed16::FromRaw(m_im[i]));
+	}
+
+	void set(size_t i, const FixedComplex& z) {
+		m_re[i] = z.re.Raw();
+		m_im[i] = z.im.Raw();
+	}
+
+	/*!\brief The instruction set the kernels were built for: "avx2", "sse4.1", "neon" or "scalar" */
+	static const char* kernel();
+
+#ifdef IOSTREAMS
+	static bool testharness();
+#endif
+
+private:
+	FixedComplexBatch(const FixedComplexBatch&) = delete;
+	FixedComplexBatch& operator=(const FixedComplexBatch&) = delete;
+
+	size_t m_size;
+	f_int32* m_buffer;
+	f_int32 *m_re, *m_im;
+};
+
+/*
+* The output batch must be the same size as the inputs, and may be one of
+* them. Arrays of Fixed16 results must hold size() elements.
+*/
+
+/*!\brief out[i] = a[i] * b[i]
+*/
+void mult(const FixedComplexBatch& a, const FixedComplexBatch& b, FixedComplexBatch& out);
+
+/*!\brief out[i] = a[i] * b, for example to mix a block down by a fixed phasor
+*/
+void mult(const FixedComplexBatch& a, const FixedComplex& b, FixedComplexBatch& out);
+
+/*!\brief out[i] = conj_mult(a[i], b[i])
+*/
+void conj_mult(const FixedComplexBatch& a, const FixedComplexBatch& b, FixedComplexBatch& out);
+
+/*!\brief out[i] = norm2(a[i])
+*/
+void norm2(const FixedComplexBatch& a, Fixed16* out);
+
+/*!\brief phase[i] = polar(a[i], magnitude[i])
+	CORDIC is still run one sample at a time.
+*/
+void polar(const FixedComplexBatch& a, Fixed16* magnitude, Fixed16* phase);
+
+#endif /* __FixedComplexBatch__ */
@@ -0,0 +1,287 @@
+#ifndef __FixedCordic_h__
+#define __FixedCordic_h__
+/*
+FixedCordic.h. CORDIC trigonometry for the Fixed16 class.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the CORDIC trigonometry
+
+Fixed16 s, c, r;
+FixedCordic<16>::sincos(x, s, c);            // rotation mode
+Fixed16 a = FixedCordic<16>::arctan2(y, x);   // vectoring mode
+a = FixedCordic<16>::arctan2(y, x, r);        // ... and r = sqrt(x*x + y*y)
+
+Each iteration is two shifts and three additions on raw integers, and
+gains about one bit of angle, so the iteration count trades accuracy for
+speed. sin, cos and arctan2 are within 32 PRECISION() of libm after 12
+iterations, 2 after 16 and 1 after 20. The only multiply is the gain
+correction of the magnitude in arctan2(y, x, r).
+*/
+
+#include "Fixed.h"
+
+/*!\brief atan(2^-i) in Q29
+*/
+inline f_int32 fixed_cordic_atan(int i)
+{
+    static const f_int32 table[28] = {
+        421657428, 248918915, 131521918, 66762579,
+        33510843, 16771758, 8387925, 4194219,
+        2097141, 1048575, 524288, 262144,
+        131072, 65536, 32768, 16384,
+        8192, 4096, 2048, 1024,
+        512, 256, 128, 64,
+        32, 16, 8, 4,
+    };
+    return table[i];
+}
+
+/*!\brief CORDIC rotation and vectoring on Fixed16 numbers, with Iterations steps.
+
+* Internally the vector is held in Q30 and angles in Q29. The steps are
+* written with a sign mask rather than a branch, so each one costs the same.
+*/
+template <int Iterations> class FixedCordic
+{
+    static_assert(Iterations >= 1 && Iterations <= 28, "FixedCordic supports 1 to 28 iterations");
+
+public:
+    /*!\brief Calculate sin(angle) and cos(angle), angle in radians (-2PI <= angle <= 2PI)
+    */
+    static void sincos(const Fixed16& angle, Fixed16& s, Fixed16& c) {
+        /* Reduce to -PI/2 <= z <= PI/2 in Q27, which holds the whole input range */
+        const f_int32 PI_Q27 = 421657428;
+        f_int32 z = f_int32(f_uint32(angle.Raw()) << 11);
+        if (z > PI_Q27)
+            z -= 2*PI_Q27;
+        else if (z < -PI_Q27)
+            z += 2*PI_Q27;
+
+        bool negate = false;
+        if (z > PI_Q27/2) {
+            z -= PI_Q27;
+            negate = true;
+        } else if (z < -PI_Q27/2) {
+            z += PI_Q27;
+            negate = true;
+        }
+
+        /* Starting from 1/gain means no correction is needed afterwards */
+        f_int32 x = inverse_gain();
+        f_int32 y = 0;
+        z = f_int32(f_uint32(z) << 2);
+        for (int i = 0; i < Iterations; i++)
+        {
+            f_int32 d = z >> 31;    // 0 to rotate anticlockwise, -1 to rotate clockwise
+            f_int32 dx = y >> i;
+            f_int32 dy = x >> i;
+            x -= (dx ^ d) - d;
+            y += (dy ^ d) - d;
+            z -= (fixed_cordic_atan(i) ^ d) - d;
+        }
+
+        s = Fixed16::FromRaw(round_q30(negate ? -y : y));
+        c = Fixed16::FromRaw(round_q30(negate ? -x : x));
+    }
+
+    /*!\brief Calculate arctan(y/x), in the range -PI < angle <= PI
+    */
+    static Fixed16 arctan2(const Fixed16& y, const Fixed16& x) {
+        f_int32 vx, vy, shift;
+        if (!normalise(y, x, vy, vx, shift))
+            return Fixed16::zero(); // same as GCC's atan2
+
+        return Fixed16::FromRaw(round_q29(vector(vy, vx)));
+    }
+
+    /*!\brief Calculate arctan(y/x) and the magnitude sqrt(x*x + y*y) of (x, y) together.
+        The magnitude must be less than 32768.
+    */
+    static Fixed16 arctan2(const Fixed16& y, const Fixed16& x, Fixed16& magnitude) {
+        f_int32 vx, vy, shift;
+        if (!normalise(y, x, vy, vx, shift))
+        {
+            magnitude = Fixed16::zero();
+            return Fixed16::zero();
+        }
+
+        f_int32 angle = vector(vy, vx);
+
+        /* vx is now gain * |(x,y)| << shift, in Q16 */
+        f_int64 m = f_int64::mult32(vx, inverse_gain());
+        m += f_int64(1) << (29 + shift);
+        magnitude = Fixed16::FromRaw((m >> (30 + shift)).toInt32());
+
+        return Fixed16::FromRaw(round_q29(angle));
+    }
+
+    /*!\brief The inverse of the CORDIC gain after Iterations steps, in Q30 */
+    static constexpr f_int32 inverse_gain() {
+        double p = 1.0;
+        double k = 1.0;
+        for (int i = 0; i < Iterations; i++)
+        {
+            p *= 1.0 + k;
+            k /= 4;
+        }
+        /* 1/sqrt(p) by Newton's method. p is between 2 and 2.72 */
+        double r = 0.6;
+        for (int i = 0; i < 8; i++)
+            r = r * (3.0 - p * r * r) / 2;
+        return f_int32(r * 1073741824.0 + 0.5);
+    }
+
+#ifdef IOSTREAMS
+    static void testharness();
+#endif
+
+private:
+    static f_int32 round_q30(f_int32 v) { return (v + (1 << 13)) >> 14; }
+    static f_int32 round_q29(f_int32 v) { return (v + (1 << 12)) >> 13; }
+
+    /*!\brief Scale (x, y) so that the larger component has its top bit at bit 28,
+        leaving room for the gain. Returns false for the zero vector.
+    */
+    static bool normalise(const Fixed16& y, const Fixed16& x, f_int32& vy, f_int32& vx, f_int32& shift) {
+        f_int32 rx = x.Raw();
+        f_int32 ry = y.Raw();
+        f_uint32 m = ((rx < 0) ? 0u - f_uint32(rx) : f_uint32(rx)) | ((ry < 0) ? 0u - f_uint32(ry) : f_uint32(ry));
+        if (m == 0)
+            return false;
+
+        shift = f_clz32(m) - 3;
+        if (shift >= 0) {
+            vx = f_int32(f_uint32(rx) << shift);
+            vy = f_int32(f_uint32(ry) << shift);
+        } else {
+            vx = rx >> -shift;
+            vy = ry >> -shift;
+        }
+        return true;
+    }
+
+    /*!\brief Rotate (x, y) onto the positive x axis. Returns the angle that
+        it was rotated through, in Q29.
+    */
+    static f_int32 vector(f_int32& y, f_int32& x) {
+        const f_int32 PI_Q29 = 1686629713;
+        f_int32 z = 0;
+        if (x < 0)
+        {
+            z = (y < 0) ? -PI_Q29 : PI_Q29;
+            x = -x;
+            y = -y;
+        }
+        for (int i = 0; i < Iterations; i++)
+        {
+            f_int32 d = y >> 31;    // 0 to rotate clockwise, -1 to rotate anticlockwise
+            f_int32 dx = y >> i;
+            f_int32 dy = x >> i;
+            x += (dx ^ d) - d;
+            y -= (dy ^ d) - d;
+            z += (fixed_cordic_atan(i) ^ d) - d;
+        }
+        return z;
+    }
+};
+
+#ifdef IOSTREAMS
+template <int Iterations> void FixedCordic<Iterations>::testharness()
+{
+    cout << "FixedCordic<" << Iterations << "> testharness" << endl;
+
+    const double pi = 3.14159265358979323846;
+
+    /* Each step halves the angle that is left, so the error is about the last atan(2^-i), and never less than 1 */
+    f_int32 bound = f_int32(std::floor(65536.0 * std::atan(std::ldexp(1.0, 1 - Iterations)) + 0.5));
+    if (bound < 1)
+        bound = 1;
+
+    f_int32 worst_s = 0;
+    f_int32 worst_c = 0;
+    for (f_int32 raw = Fixed16::FromDouble(-2 * pi).Raw(); raw <= Fixed16::FromDouble(2 * pi).Raw(); raw += 7)
+    {
+        Fixed16 a = Fixed16::FromRaw(raw);
+        Fixed16 s, c;
+        sincos(a, s, c);
+        f_int32 es = std::abs(s.Raw() - f_int32(floor(std::sin(a.toDouble()) * 65536.0 + 0.5)));
+        f_int32 ec = std::abs(c.Raw() - f_int32(floor(std::cos(a.toDouble()) * 65536.0 + 0.5)));
+        if (es > worst_s) worst_s = es;
+        if (ec > worst_c) worst_c = ec;
+    }
+    test_result("sin error", worst_s, 0, bound);
+    test_result("cos error", worst_c, 0, bound);
+
+    test_result("arctan2(0,0)", arctan2(Fixed16::zero(), Fixed16::zero()), Fixed16::zero());
+    test_result("arctan2(0,-1)", arctan2(Fixed16::zero(), -Fixed16::one()), Fixed16::PI(), Fixed16::FromRaw(bound));
+    test_result("arctan2(-1,0)", arctan2(-Fixed16::one(), Fixed16::zero()), -Fixed16::PI_OVER_2(), Fixed16::FromRaw(bound));
+    Fixed16 most_negative = Fixed16::FromRaw(f_int32(0x80000000u));
+    test_result("arctan2(-32768,0)", arctan2(most_negative, Fixed16::zero()), -Fixed16::PI_OVER_2(), Fixed16::FromRaw(bound));
+    test_result("arctan2(0,-32768)", arctan2(Fixed16::zero(), most_negative), Fixed16::PI(), Fixed16::FromRaw(bound));
+
+    /* atan2 and magnitude around circles of small and large radius */
+    double theta = std::atan(std::ldexp(1.0, 1 - Iterations));
+    f_int32 worst_a = 0;
+    double worst_m = 0;
+    f_int32 mismatches = 0;
+    const double radius[] = { 0.01, 1.0, 300.0, 20000.0 };
+    for (int r = 0; r < 4; r++)
+    {
+        for (int k = -180; k <= 180; k++)
+        {
+            double t = k * pi / 180.5;
+            Fixed16 x = Fixed16::FromDouble(radius[r] * std::cos(t));
+            Fixed16 y = Fixed16::FromDouble(radius[r] * std::sin(t));
+            Fixed16 m;
+            Fixed16 a = arctan2(y, x, m);
+            if (arctan2(y, x) != a)
+                mismatches++;
+
+            double ref = std::atan2(y.toDouble(), x.toDouble());
+            f_int32 ea = std::abs(a.Raw() - f_int32(floor(ref * 65536.0 + 0.5)));
+            if (ea > worst_a) worst_a = ea;
+
+            /*
+                The vector is left within theta of the x axis, which shortens it by up
+                to r*theta^2/2. Each step also truncates by up to one unit of the
+                normalised vector, which is r/2^28 (and more than PRECISION() for large r).
+            */
+            double hyp = std::hypot(x.toDouble(), y.toDouble());
+            double unit = hyp / (1 << 28);
+            double em = std::fabs(m.toDouble() - hyp) / (2.0 / 65536.0 + Iterations * unit + hyp * theta * theta / 2);
+            if (em > worst_m) worst_m = em;
+        }
+    }
+    test_result("arctan2(y,x) == arctan2(y,x,m)", mismatches, 0);
+    test_result("arctan2 error", worst_a, 0, bound);
+    test_result("magnitude error / bound", worst_m, 0.0, 1.0);
+}
+#endif
+
+#endif /* __FixedCordic_h__ */
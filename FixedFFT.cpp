@@ -0,0 +1,452 @@
+/*
+FixedFFT.cpp. The passes of FixedFFT.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+#include "FixedFFT.h"
+
+#if !defined(FIXED_NO_SIMD)
+	#if defined(__AVX2__)
+		#define FIXED_FFT_AVX2
+	#elif defined(__SSE4_1__)
+		#define FIXED_FFT_SSE41
+	#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define FIXED_FFT_NEON
+	#endif
+#endif
+
+/* The twiddles are Q2.30 */
+static const int TWIDDLE_BITS = 30;
+
+/* |v|, or |v| - 1 for a negative v, which cannot overflow */
+template <class S> static inline f_uint32 magnitude(S v)
+{
+	f_int32 x = v;
+	return f_uint32(x ^ (x >> 31));
+}
+
+/* v / 2^s, rounded half up, without overflow */
+static inline f_int32 round_shr(f_int32 v, int s)
+{
+	return (s == 0) ? v : (v >> s) + ((v >> (s - 1)) & 1);
+}
+
+/* b * w / 2^(30 + s), rounded half up, for b and w of a complex multiply */
+static inline f_int32 twiddle_shr(f_int64 p, int s)
+{
+	p += f_int64(1) << (TWIDDLE_BITS - 1 + s);
+	return fixed_storage_traits<f_int32>::truncate_shr(p >> s, TWIDDLE_BITS);
+}
+
+/*
+* The shift for a pass whose outputs can be up to 2^growth times its
+* largest input. Scaled down by it, the outputs stay under half of the
+* range of S, which leaves the next pass room for its own rounding.
+*/
+template <class S> static int pass_shift(f_uint32 largest, int growth)
+{
+	const f_uint32 limit = f_uint32(1) << (8*sizeof(S) - 2 - growth);
+	int s = 0;
+	while ((largest >> s) >= limit)
+		s++;
+	return s;
+}
+
+template <class S> static void bit_reverse(S* d, size_t n)
+{
+	for (size_t i = 0, j = 0; i < n; i++)
+	{
+		if (i < j)
+		{
+			S re = d[2*i], im = d[2*i + 1];
+			d[2*i] = d[2*j]; d[2*i + 1] = d[2*j + 1];
+			d[2*j] = re; d[2*j + 1] = im;
+		}
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j |= bit;
+	}
+}
+
+template <class S> static f_uint32 largest(const S* d, size_t n)
+{
+	f_uint32 m = 0;
+	for (size_t i = 0; i < 2*n; i++)
+		if (magnitude(d[i]) > m)
+			m = magnitude(d[i]);
+	return m;
+}
+
+template <class S> static void swap_re_im(S* d, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		S t = d[2*i];
+		d[2*i] = d[2*i + 1];
+		d[2*i + 1] = t;
+	}
+}
+
+/*
+* The first two stages together. Each group of four, in bit reversed
+* order, is a 4 point DFT, whose twiddles are 1 and -i.
+*/
+template <class S> static f_uint32 radix4_pass(S* d, size_t n, int s)
+{
+	f_uint32 m = 0;
+	for (size_t g = 0; g < n; g += 4)
+	{
+		S* x = d + 2*g;
+		f_int32 x0r = round_shr(x[0], s), x0i = round_shr(x[1], s);
+		f_int32 x1r = round_shr(x[2], s), x1i = round_shr(x[3], s);
+		f_int32 x2r = round_shr(x[4], s), x2i = round_shr(x[5], s);
+		f_int32 x3r = round_shr(x[6], s), x3i = round_shr(x[7], s);
+
+		f_int32 ar = x0r + x1r, ai = x0i + x1i;
+		f_int32 br = x0r - x1r, bi = x0i - x1i;
+		f_int32 cr = x2r + x3r, ci = x2i + x3i;
+		f_int32 dr = x2r - x3r, di = x2i - x3i;
+
+		/* X1 = b - i d and X3 = b + i d */
+		x[0] = S(ar + cr); x[1] = S(ai + ci);
+		x[2] = S(br + di); x[3] = S(bi - dr);
+		x[4] = S(ar - cr); x[5] = S(ai - ci);
+		x[6] = S(br - di); x[7] = S(bi + dr);
+		for (int k = 0; k < 8; k++)
+			if (magnitude(x[k]) > m)
+				m = magnitude(x[k]);
+	}
+	return m;
+}
+
+/* Butterflies k0 <= k < k1 of one group of a radix-2 stage */
+template <class S> static f_uint32 butterflies(S* g, size_t half, const f_int32* w, int s, size_t k0, size_t k1)
+{
+	f_uint32 m = 0;
+	for (size_t k = k0; k < k1; k++)
+	{
+		S* a = g + 2*k;
+		S* b = g + 2*(k + half);
+		f_int32 wr = w[2*k], wi = w[2*k + 1];
+
+		f_int32 tr = twiddle_shr(f_int64::mult32(b[0], wr) - f_int64::mult32(b[1], wi), s);
+		f_int32 ti = twiddle_shr(f_int64::mult32(b[0], wi) + f_int64::mult32(b[1], wr), s);
+		f_int32 ar = round_shr(a[0], s), ai = round_shr(a[1], s);
+
+		a[0] = S(ar + tr); a[1] = S(ai + ti);
+		b[0] = S(ar - tr); b[1] = S(ai - ti);
+		for (int j = 0; j < 2; j++)
+		{
+			if (magnitude(a[j]) > m)
+				m = magnitude(a[j]);
+			if (magnitude(b[j]) > m)
+				m = magnitude(b[j]);
+		}
+	}
+	return m;
+}
+
+/*
+* The SIMD stages work on f_int32 data, several butterflies at a time. The
+* 64 bit products are shifted logically, which leaves the same low 32 bits
+* as an arithmetic shift would, as 30 + s is at most 32. Like the plain
+* loop, they return the largest magnitude they wrote, for the next pass.
+*/
+#if defined(FIXED_FFT_AVX2)
+
+#include <immintrin.h>
+
+static const size_t LANES = 4;
+
+static inline f_uint32 max_lanes(__m256i v)
+{
+	__m128i x = _mm_max_epu32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	x = _mm_max_epu32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+	x = _mm_max_epu32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+	return f_uint32(_mm_cvtsi128_si32(x));
+}
+
+static f_uint32 butterflies_simd(f_int32* g, size_t half, const f_int32* w, int s)
+{
+	const __m128i shift = _mm_cvtsi32_si128(TWIDDLE_BITS + s);
+	const __m128i down = _mm_cvtsi32_si128(s);
+	const __m128i down1 = _mm_cvtsi32_si128(s - 1);
+	const __m256i bias = _mm256_set1_epi64x((int64_t(1) << (TWIDDLE_BITS - 1 + s)));
+	const __m256i one = _mm256_set1_epi32(1);
+	__m256i m = _mm256_setzero_si256();
+
+	for (size_t k = 0; k < half; k += LANES)
+	{
+		f_int32* pa = g + 2*k;
+		f_int32* pb = g + 2*(k + half);
+		__m256i a = _mm256_loadu_si256((const __m256i*)pa);
+		__m256i b = _mm256_loadu_si256((const __m256i*)pb);
+		__m256i wv = _mm256_loadu_si256((const __m256i*)(w + 2*k));
+		__m256i bi = _mm256_srli_epi64(b, 32);
+		__m256i wi = _mm256_srli_epi64(wv, 32);
+
+		/* The products of the re parts are in the even lanes, of the im parts in the odd ones */
+		__m256i tr = _mm256_sub_epi64(_mm256_mul_epi32(b, wv), _mm256_mul_epi32(bi, wi));
+		__m256i ti = _mm256_add_epi64(_mm256_mul_epi32(b, wi), _mm256_mul_epi32(bi, wv));
+		tr = _mm256_srl_epi64(_mm256_add_epi64(tr, bias), shift);
+		ti = _mm256_slli_epi64(_mm256_srl_epi64(_mm256_add_epi64(ti, bias), shift), 32);
+		__m256i t = _mm256_blend_epi32(tr, ti, 0xAA);
+
+		if (s > 0)
+			a = _mm256_add_epi32(_mm256_sra_epi32(a, down), _mm256_and_si256(_mm256_sra_epi32(a, down1), one));
+
+		__m256i x = _mm256_add_epi32(a, t);
+		__m256i y = _mm256_sub_epi32(a, t);
+		_mm256_storeu_si256((__m256i*)pa, x);
+		_mm256_storeu_si256((__m256i*)pb, y);
+		m = _mm256_max_epu32(m, _mm256_xor_si256(x, _mm256_srai_epi32(x, 31)));
+		m = _mm256_max_epu32(m, _mm256_xor_si256(y, _mm256_srai_epi32(y, 31)));
+	}
+	return max_lanes(m);
+}
+
+#elif defined(FIXED_FFT_SSE41)
+
+#include <smmintrin.h>
+
+static const size_t LANES = 2;
+
+static inline f_uint32 max_lanes(__m128i x)
+{
+	x = _mm_max_epu32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+	x = _mm_max_epu32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+	return f_uint32(_mm_cvtsi128_si32(x));
+}
+
+static f_uint32 butterflies_simd(f_int32* g, size_t half, const f_int32* w, int s)
+{
+	const __m128i shift = _mm_cvtsi32_si128(TWIDDLE_BITS + s);
+	const __m128i down = _mm_cvtsi32_si128(s);
+	const __m128i down1 = _mm_cvtsi32_si128(s - 1);
+	const __m128i bias = _mm_set1_epi64x((int64_t(1) << (TWIDDLE_BITS - 1 + s)));
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i m = _mm_setzero_si128();
+
+	for (size_t k = 0; k < half; k += LANES)
+	{
+		f_int32* pa = g + 2*k;
+		f_int32* pb = g + 2*(k + half);
+		__m128i a = _mm_loadu_si128((const __m128i*)pa);
+		__m128i b = _mm_loadu_si128((const __m128i*)pb);
+		__m128i wv = _mm_loadu_si128((const __m128i*)(w + 2*k));
+		__m128i bi = _mm_srli_epi64(b, 32);
+		__m128i wi = _mm_srli_epi64(wv, 32);
+
+		__m128i tr = _mm_sub_epi64(_mm_mul_epi32(b, wv), _mm_mul_epi32(bi, wi));
+		__m128i ti = _mm_add_epi64(_mm_mul_epi32(b, wi), _mm_mul_epi32(bi, wv));
+		tr = _mm_srl_epi64(_mm_add_epi64(tr, bias), shift);
+		ti = _mm_slli_epi64(_mm_srl_epi64(_mm_add_epi64(ti, bias), shift), 32);
+		__m128i t = _mm_blend_epi16(tr, ti, 0xCC);
+
+		if (s > 0)
+			a = _mm_add_epi32(_mm_sra_epi32(a, down), _mm_and_si128(_mm_sra_epi32(a, down1), one));
+
+		__m128i x = _mm_add_epi32(a, t);
+		__m128i y = _mm_sub_epi32(a, t);
+		_mm_storeu_si128((__m128i*)pa, x);
+		_mm_storeu_si128((__m128i*)pb, y);
+		m = _mm_max_epu32(m, _mm_xor_si128(x, _mm_srai_epi32(x, 31)));
+		m = _mm_max_epu32(m, _mm_xor_si128(y, _mm_srai_epi32(y, 31)));
+	}
+	return max_lanes(m);
+}
+
+#elif defined(FIXED_FFT_NEON)
+
+#include <arm_neon.h>
+
+static const size_t LANES = 4;
+
+/* vrshl by a negative count is a right shift that rounds half up, as twiddle_shr() and round_shr() do */
+static f_uint32 butterflies_simd(f_int32* g, size_t half, const f_int32* w, int s)
+{
+	const int64x2_t shift = vdupq_n_s64(-(TWIDDLE_BITS + s));
+	const int32x4_t down = vdupq_n_s32(-s);
+	uint32x4_t m = vdupq_n_u32(0);
+
+	for (size_t k = 0; k < half; k += LANES)
+	{
+		f_int32* pa = g + 2*k;
+		f_int32* pb = g + 2*(k + half);
+		int32x4x2_t a = vld2q_s32(pa);
+		int32x4x2_t b = vld2q_s32(pb);
+		int32x4x2_t wv = vld2q_s32(w + 2*k);
+
+		int64x2_t rl = vmlsl_s32(vmull_s32(vget_low_s32(b.val[0]), vget_low_s32(wv.val[0])), vget_low_s32(b.val[1]), vget_low_s32(wv.val[1]));
+		int64x2_t rh = vmlsl_s32(vmull_s32(vget_high_s32(b.val[0]), vget_high_s32(wv.val[0])), vget_high_s32(b.val[1]), vget_high_s32(wv.val[1]));
+		int64x2_t il = vmlal_s32(vmull_s32(vget_low_s32(b.val[0]), vget_low_s32(wv.val[1])), vget_low_s32(b.val[1]), vget_low_s32(wv.val[0]));
+		int64x2_t ih = vmlal_s32(vmull_s32(vget_high_s32(b.val[0]), vget_high_s32(wv.val[1])), vget_high_s32(b.val[1]), vget_high_s32(wv.val[0]));
+		int32x4_t tr = vcombine_s32(vmovn_s64(vrshlq_s64(rl, shift)), vmovn_s64(vrshlq_s64(rh, shift)));
+		int32x4_t ti = vcombine_s32(vmovn_s64(vrshlq_s64(il, shift)), vmovn_s64(vrshlq_s64(ih, shift)));
+
+		int32x4_t ar = vrshlq_s32(a.val[0], down);
+		int32x4_t ai = vrshlq_s32(a.val[1], down);
+
+		int32x4x2_t x, y;
+		x.val[0] = vaddq_s32(ar, tr); x.val[1] = vaddq_s32(ai, ti);
+		y.val[0] = vsubq_s32(ar, tr); y.val[1] = vsubq_s32(ai, ti);
+		vst2q_s32(pa, x);
+		vst2q_s32(pb, y);
+		for (int j = 0; j < 2; j++)
+		{
+			m = vmaxq_u32(m, vreinterpretq_u32_s32(veorq_s32(x.val[j], vshrq_n_s32(x.val[j], 31))));
+			m = vmaxq_u32(m, vreinterpretq_u32_s32(veorq_s32(y.val[j], vshrq_n_s32(y.val[j], 31))));
+		}
+	}
+	uint32x2_t r = vpmax_u32(vget_low_u32(m), vget_high_u32(m));
+	return vget_lane_u32(vpmax_u32(r, r), 0);
+}
+
+#endif
+
+template <class S> static f_uint32 radix2_pass(S* d, size_t n, size_t half, const f_int32* w, int s)
+{
+	f_uint32 m = 0;
+	for (size_t g = 0; g < n; g += 2*half)
+	{
+		f_uint32 v = butterflies(d + 2*g, half, w + 2*half, s, 0, half);
+		if (v > m)
+			m = v;
+	}
+	return m;
+}
+
+#if defined(FIXED_FFT_AVX2) || defined(FIXED_FFT_SSE41) || defined(FIXED_FFT_NEON)
+/* Every stage after the radix-4 pass has half >= 4, a whole number of registers */
+template <> f_uint32 radix2_pass(f_int32* d, size_t n, size_t half, const f_int32* w, int s)
+{
+	f_uint32 m = 0;
+	for (size_t g = 0; g < n; g += 2*half)
+	{
+		f_uint32 v = (half % LANES == 0) ? butterflies_simd(d + 2*g, half, w + 2*half, s)
+			: butterflies(d + 2*g, half, w + 2*half, s, 0, half);
+		if (v > m)
+			m = v;
+	}
+	return m;
+}
+#endif
+
+template <class S> static int forward(S* d, int log2n, const f_int32* w, int* shifts)
+{
+	const size_t n = size_t(1) << log2n;
+	bit_reverse(d, n);
+
+	int s = pass_shift<S>(largest(d, n), 2);
+	f_uint32 m = radix4_pass(d, n, s);
+	int total = s;
+	if (shifts)
+		*shifts++ = s;
+
+	for (size_t half = 4; half < n; half *= 2)
+	{
+		s = pass_shift<S>(m, 1);
+		m = radix2_pass(d, n, half, w, s);
+		total += s;
+		if (shifts)
+			*shifts++ = s;
+	}
+	return total;
+}
+
+/* The inverse is the forward transform with re and im swapped, going in and coming out */
+template <class S> static int inverse(S* d, int log2n, const f_int32* w, int* shifts)
+{
+	const size_t n = size_t(1) << log2n;
+	swap_re_im(d, n);
+	int total = forward(d, log2n, w, shifts);
+	swap_re_im(d, n);
+	return total;
+}
+
+/*
+* An N/2 point FFT of z[n] = x[2n] + i x[2n+1] gives Z, and then
+*   X[k] = E[k] + W^k O[k],  X[N/2 - k] = conj(E[k] - W^k O[k])
+* with E[k] = (Z[k] + conj(Z[N/2 - k])) / 2, O[k] = -i (Z[k] - conj(Z[N/2 - k])) / 2
+* and W = exp(-2 PI i / N). X[0] and X[N/2] are Z[0].re + Z[0].im and
+* Z[0].re - Z[0].im.
+*/
+template <class S> static int real_forward(S* d, int log2n, const f_int32* w, int* shifts)
+{
+	const size_t half = size_t(1) << (log2n - 1);
+	int total = forward(d, log2n - 1, w, shifts);
+
+	/* The halves in E and O are taken along with the pass's own shift */
+	int s = pass_shift<S>(largest(d, half), 1);
+	total += s;
+	if (shifts)
+		shifts[log2n - 2] = s;
+
+	f_int32 z0r = round_shr(d[0], s), z0i = round_shr(d[1], s);
+	d[0] = S(z0r + z0i);
+	d[1] = S(z0r - z0i);
+
+	const f_int32* wk = w + 2*half;
+	for (size_t k = 1; k <= half / 2; k++)
+	{
+		S* a = d + 2*k;
+		S* b = d + 2*(half - k);
+		f_int32 ar = round_shr(a[0], s + 1), ai = round_shr(a[1], s + 1);
+		f_int32 br = round_shr(b[0], s + 1), bi = -round_shr(b[1], s + 1);
+
+		f_int32 er = ar + br, ei = ai + bi;
+		f_int32 orr = ai - bi, oi = br - ar;
+		f_int32 wr = wk[2*k], wi = wk[2*k + 1];
+		f_int32 tr = twiddle_shr(f_int64::mult32(orr, wr) - f_int64::mult32(oi, wi), 0);
+		f_int32 ti = twiddle_shr(f_int64::mult32(orr, wi) + f_int64::mult32(oi, wr), 0);
+
+		b[0] = S(er - tr); b[1] = S(ti - ei);
+		a[0] = S(er + tr); a[1] = S(ei + ti);
+	}
+	return total;
+}
+
+int fixed_fft_forward(f_int32* data, int log2n, const f_int32* w, int* shifts) { return forward(data, log2n, w, shifts); }
+int fixed_fft_forward(f_int16* data, int log2n, const f_int32* w, int* shifts) { return forward(data, log2n, w, shifts); }
+int fixed_fft_inverse(f_int32* data, int log2n, const f_int32* w, int* shifts) { return inverse(data, log2n, w, shifts); }
+int fixed_fft_inverse(f_int16* data, int log2n, const f_int32* w, int* shifts) { return inverse(data, log2n, w, shifts); }
+int fixed_fft_real_forward(f_int32* data, int log2n, const f_int32* w, int* shifts) { return real_forward(data, log2n, w, shifts); }
+int fixed_fft_real_forward(f_int16* data, int log2n, const f_int32* w, int* shifts) { return real_forward(data, log2n, w, shifts); }
+
+const char* fixed_fft_kernel()
+{
+#if defined(FIXED_FFT_AVX2)
+	return "avx2";
+#elif defined(FIXED_FFT_SSE41)
+	return "sse4.1";
+#elif defined(FIXED_FFT_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,277 @@
+#ifndef __FixedFFT__
+#define __FixedFFT__
+/*
+FixedFFT.h. Fixed point fast Fourier transforms with block floating point.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedFFT
+
+Fixed16 data[2*1024];                           // re, im, re, im, ...
+int e = FixedFFT<1024>::forward(data);          // X[k] = (data[2k], data[2k+1]) * 2^e
+e = FixedFFT<1024>::inverse(data);              // N x[n] = (data[2n], data[2n+1]) * 2^e
+
+int shifts[FixedFFT<1024>::passes];
+e = FixedFFT<1024>::forward(data, shifts);      // and the shift of each pass (e is their sum)
+
+Fixed16 samples[1024];                          // real input
+e = FixedFFT<1024>::real_forward(samples);      // X[k] for 0 <= k < N/2 as above, except
+                                                // samples[1] holds X[N/2], which is real
+
+FixedQ1_15 q[2*256];                            // Q1.15 data too
+e = FixedFFT<256, FixedQ1_15>::forward(q);
+
+The transforms are in place, in natural order, and unnormalised:
+X[k] = sum over n of x[n] exp(-2 PI i n k / N), and inverse() has the
+opposite sign, with no 1/N.
+
+The first two radix-2 stages are done together as one radix-4 pass, whose
+twiddles are 1 and -i and so need no multiplies. Each later pass is a
+radix-2 stage. Before each pass the largest value is checked, and the pass
+scales its outputs down by as many bits as it needs to stay in range (block
+floating point). The shifts are returned, so nothing overflows and small
+inputs keep all their bits.
+
+The twiddles are held as Q2.30 and built once per size, on first use, by
+fixed_fft_cos_q30(). Products are 32x32 bit into 64, rounded once. When the
+compiler targets AVX2, SSE4.1 or NEON the radix-2 stages on 32 bit data use
+SIMD butterflies, which give the same bits as the plain loop. Define
+FIXED_NO_SIMD to always use the plain loop.
+*/
+
+#include <stddef.h>
+
+#include "Fixed.h"
+
+/*!\brief round(cos(2 PI k / n) * 2^30), from a Taylor series, so that the
+    twiddles need neither libm nor a trip through Fixed16's 16 bits of sin().
+*/
+constexpr f_int32 fixed_fft_cos_q30(long k, long n)
+{
+    k %= n;
+    if (k < 0)
+        k += n;
+
+    /* 2 PI k / n = q PI/2 + x, with 0 <= x < PI/2 */
+    long q = 4*k / n;
+    double x = 1.57079632679489661923 * double(4*k - q*n) / double(n);
+
+    double c = 1.0, s = x, tc = 1.0, ts = x;
+    for (int i = 1; i < 12; i++)
+    {
+        tc *= -x*x / double((2*i - 1) * (2*i));
+        ts *= -x*x / double((2*i) * (2*i + 1));
+        c += tc;
+        s += ts;
+    }
+
+    double v = (q == 0) ? c : (q == 1) ? -s : (q == 2) ? -c : s;
+    v *= 1073741824.0;
+    return f_int32((v < 0) ? v - 0.5 : v + 0.5);
+}
+
+/*!\brief The twiddles of every radix-2 stage up to an n point FFT.
+
+* The stage whose butterflies are half apart uses exp(-2 PI i k / (2 half))
+* for 0 <= k < half, as Q2.30 (re, im) pairs from w + 2*half. That does not
+* depend on n, so a table serves every smaller FFT too. get() gives the one
+* table of each size, which FixedFFT<N,T> shares for every sample type T.
+*/
+template <int N> struct fixed_fft_table
+{
+    f_int32 w[2*N];
+
+    static const f_int32* get() {
+        static const fixed_fft_table t;
+        return t.w;
+    }
+
+    fixed_fft_table() {
+        w[0] = w[1] = 0;
+        for (long half = 1; half < N; half *= 2)
+            for (long k = 0; k < half; k++)
+            {
+                w[2*(half + k)] = fixed_fft_cos_q30(4*k, 8*half);
+                w[2*(half + k) + 1] = fixed_fft_cos_q30(4*k + 2*half, 8*half);    // -sin
+            }
+    }
+};
+
+/*
+* The transforms on raw data, interleaved (re, im). The size is 2^log2n
+* complex values (real values for fixed_fft_real_forward()). w is a
+* fixed_fft_table at least that big. shifts, if not null, gets the shift of
+* each pass, and the sum is returned.
+*/
+int fixed_fft_forward(f_int32* data, int log2n, const f_int32* w, int* shifts);
+int fixed_fft_forward(f_int16* data, int log2n, const f_int32* w, int* shifts);
+int fixed_fft_inverse(f_int32* data, int log2n, const f_int32* w, int* shifts);
+int fixed_fft_inverse(f_int16* data, int log2n, const f_int32* w, int* shifts);
+int fixed_fft_real_forward(f_int32* data, int log2n, const f_int32* w, int* shifts);
+int fixed_fft_real_forward(f_int16* data, int log2n, const f_int32* w, int* shifts);
+
+/*!\brief The instruction set the radix-2 stages were built for: "avx2", "sse4.1", "neon" or "scalar"
+*/
+const char* fixed_fft_kernel();
+
+constexpr int fixed_fft_log2(int n)
+{
+    return (n <= 1) ? 0 : 1 + fixed_fft_log2(n / 2);
+}
+
+/*!\brief N point FFTs on T (Fixed16, FixedQ1_15 or another Fixed of 16 or 32 bits)
+*/
+template <int N, class T = Fixed16> class FixedFFT
+{
+    typedef typename T::storage_type storage_type;
+
+    static_assert(N >= 4 && N <= 65536 && (N & (N - 1)) == 0, "FixedFFT sizes are powers of 2 from 4 to 65536");
+    static_assert(sizeof(storage_type) == sizeof(f_int16) || sizeof(storage_type) == sizeof(f_int32), "FixedFFT is for 16 and 32 bit formats");
+    static_assert(sizeof(T) == sizeof(storage_type), "T must be a bare storage_type");
+
+public:
+    static const int size = N;
+    static const int log2n = fixed_fft_log2(N);
+
+    /*!\brief The number of passes, and so of shifts, of each transform */
+    static const int passes = log2n - 1;
+
+    /*!\brief Transform N complex values, data[2k] + i data[2k+1], in place */
+    static int forward(T* data, int* shifts = 0) {
+        return fixed_fft_forward(raw(data), log2n, fixed_fft_table<N>::get(), shifts);
+    }
+
+    /*!\brief The inverse transform, without the 1/N */
+    static int inverse(T* data, int* shifts = 0) {
+        return fixed_fft_inverse(raw(data), log2n, fixed_fft_table<N>::get(), shifts);
+    }
+
+    /*!\brief Transform N real values in place, with an N/2 point FFT. Bin k < N/2
+        is data[2k] + i data[2k+1], except that data[1] holds the real bin N/2.
+    */
+    static int real_forward(T* data, int* shifts = 0) {
+        static_assert(N >= 8, "real_forward() needs N of at least 8");
+        return fixed_fft_real_forward(raw(data), log2n, fixed_fft_table<N>::get(), shifts);
+    }
+
+#ifdef IOSTREAMS
+    static void testharness();
+#endif
+
+private:
+    static storage_type* raw(T* data) { return reinterpret_cast<storage_type*>(data); }
+};
+
+#ifdef IOSTREAMS
+#include <cmath>
+
+template <int N, class T> void FixedFFT<N,T>::testharness()
+{
+    cout << "FixedFFT<" << N << "," << T::int_bits << "." << T::frac_bits << "> testharness (" << fixed_fft_kernel() << ")" << endl;
+
+    const double PI = 3.14159265358979323846;
+    test_result("fixed_fft_cos_q30(1, 8)", fixed_fft_cos_q30(1, 8), f_int32(std::floor(std::cos(PI / 4) * 1073741824.0 + 0.5)));
+    test_result("fixed_fft_cos_q30(-1, 3)", fixed_fft_cos_q30(-1, 3), f_int32(-536870912));
+
+    /* Pseudo-random values up to an eighth of the range, so that the passes have to scale */
+    static T data[2*N], copy[2*N];
+    f_uint32 seed = 24680;
+    test_fill(data, 2*N, seed, 35 - 8*int(sizeof(storage_type)));
+    for (int i = 0; i < 2*N; i++)
+        copy[i] = data[i];
+
+    /* Against a DFT in double, in units of the last bit of the largest bin */
+    int shifts[passes];
+    int e = forward(data, shifts);
+    int sum = 0;
+    for (int p = 0; p < passes; p++)
+        sum += shifts[p];
+    test_result("sum of the shifts", sum, e);
+
+    const double lsb = std::ldexp(1.0, e) * T::PRECISION().toDouble();
+    double error = 0, largest = 0;
+    const int bins = (N <= 1024) ? N : 64;     // the DFT is N^2, so only check some bins of the big ones
+    for (int k = 0; k < bins; k++)
+    {
+        double xr = 0, xi = 0;
+        for (int n = 0; n < N; n++)
+        {
+            double c = std::cos(2 * PI * double((long(n) * k) % N) / N), s = std::sin(2 * PI * double((long(n) * k) % N) / N);
+            xr += copy[2*n].toDouble() * c + copy[2*n + 1].toDouble() * s;
+            xi += copy[2*n + 1].toDouble() * c - copy[2*n].toDouble() * s;
+        }
+        error = std::fmax(error, std::fabs(data[2*k].toDouble() * std::ldexp(1.0, e) - xr) / lsb);
+        error = std::fmax(error, std::fabs(data[2*k + 1].toDouble() * std::ldexp(1.0, e) - xi) / lsb);
+        largest = std::fmax(largest, std::fmax(std::fabs(xr), std::fabs(xi)));
+    }
+    /* Each pass rounds, and the errors of the early passes add up in the later ones as sqrt(N) */
+    test_result("forward() error (LSB)", error, 0.0, std::sqrt(double(N)) / 2 + passes);
+    /* ... and the scaling used most of the range, without overflowing it */
+    test_result("forward() largest bin / range", largest / lsb / std::ldexp(1.0, 8*int(sizeof(storage_type)) - 1), 0.5625, 0.4375);
+
+    /*
+    * inverse(forward(x)) is N x. forward() kept 2^e times coarser bits than
+    * x had, which limits how closely x comes back.
+    */
+    int ei = inverse(data);
+    error = 0;
+    for (int i = 0; i < 2*N; i++)
+        error = std::fmax(error, std::fabs(data[i].toDouble() * std::ldexp(1.0, e + ei - log2n) - copy[i].toDouble()) / T::PRECISION().toDouble());
+    test_result("inverse(forward()) error (LSB)", error, 0.0, std::ldexp(2.0, e) + std::ldexp(1.0, e + ei - log2n));
+
+    /* An impulse is flat and, being small, is not scaled */
+    for (int i = 0; i < 2*N; i++)
+        data[i] = T::zero();
+    data[0] = T::PRECISION() << 4;
+    int mismatches = forward(data);     // the shift, which should be 0
+    for (int k = 0; k < N; k++)
+        if (data[2*k] != (T::PRECISION() << 4) || data[2*k + 1] != T::zero())
+            mismatches++;
+    test_result("impulse mismatches", mismatches, 0);
+
+    /* real_forward() gives the bins of forward() on the same values with im zero */
+    for (int i = N - 1; i >= 0; i--)
+    {
+        data[i] = copy[i];
+        copy[2*i] = copy[i];
+        copy[2*i + 1] = T::zero();
+    }
+    int er = real_forward(data);
+    int ec = forward(copy);
+    error = std::fabs(data[1].toDouble() * std::ldexp(1.0, er) - copy[N].toDouble() * std::ldexp(1.0, ec));
+    for (int k = 0; k < N/2; k++)
+    {
+        error = std::fmax(error, std::fabs(data[2*k].toDouble() * std::ldexp(1.0, er) - copy[2*k].toDouble() * std::ldexp(1.0, ec)));
+        if (k > 0)
+            error = std::fmax(error, std::fabs(data[2*k + 1].toDouble() * std::ldexp(1.0, er) - copy[2*k + 1].toDouble() * std::ldexp(1.0, ec)));
+    }
+    test_result("real_forward() error (LSB)", error / lsb, 0.0, std::sqrt(double(N)) / 2 + passes);
+}
+#endif
+
+#endif /* __FixedFFT__ */
@@ -0,0 +1,140 @@
+/*
+FixedFir.cpp. The sum of products kernels for FixedFir.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+#include "FixedFir.h"
+
+#ifndef FIXED_NO_SIMD
+    #if defined(__AVX2__)
+        #define FIXED_FIR_AVX2
+    #elif defined(__SSE4_1__)
+        #define FIXED_FIR_SSE41
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define FIXED_FIR_NEON
+    #endif
+#endif
+
+/*
+* Each kernel multiplies a register of 32 bit lanes at a time into 64 bit
+* lanes, sums those for the whole array, and adds up the lanes and the few
+* elements left over at the end. The sums are exact, so every kernel gives
+* the same bits.
+*/
+#if defined(FIXED_FIR_AVX2)
+
+#include <immintrin.h>
+
+f_int64 fixed_fir_dot(const f_int32* x, const f_int32* h, size_t n)
+{
+	__m256i even = _mm256_setzero_si256(), odd = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(h + i));
+		/* _mm256_mul_epi32 multiplies the even lanes, so shift the odd lanes down to meet it */
+		even = _mm256_add_epi64(even, _mm256_mul_epi32(a, b));
+		odd = _mm256_add_epi64(odd, _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+	}
+	alignas(32) int64_t lanes[4];
+	_mm256_store_si256((__m256i*)lanes, _mm256_add_epi64(even, odd));
+	int64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	for (; i < n; i++)
+		sum += int64_t(x[i]) * h[i];
+	return f_int64(f_int32(sum >> 32), f_uint32(sum));
+}
+
+#elif defined(FIXED_FIR_SSE41)
+
+#include <smmintrin.h>
+
+f_int64 fixed_fir_dot(const f_int32* x, const f_int32* h, size_t n)
+{
+	__m128i even = _mm_setzero_si128(), odd = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(h + i));
+		even = _mm_add_epi64(even, _mm_mul_epi32(a, b));
+		odd = _mm_add_epi64(odd, _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)));
+	}
+	alignas(16) int64_t lanes[2];
+	_mm_store_si128((__m128i*)lanes, _mm_add_epi64(even, odd));
+	int64_t sum = lanes[0] + lanes[1];
+	for (; i < n; i++)
+		sum += int64_t(x[i]) * h[i];
+	return f_int64(f_int32(sum >> 32), f_uint32(sum));
+}
+
+#elif defined(FIXED_FIR_NEON)
+
+#include <arm_neon.h>
+
+f_int64 fixed_fir_dot(const f_int32* x, const f_int32* h, size_t n)
+{
+	int64x2_t low = vdupq_n_s64(0), high = vdupq_n_s64(0);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		int32x4_t a = vld1q_s32(x + i);
+		int32x4_t b = vld1q_s32(h + i);
+		low = vmlal_s32(low, vget_low_s32(a), vget_low_s32(b));
+		high = vmlal_s32(high, vget_high_s32(a), vget_high_s32(b));
+	}
+	int64x2_t both = vaddq_s64(low, high);
+	int64_t sum = vgetq_lane_s64(both, 0) + vgetq_lane_s64(both, 1);
+	for (; i < n; i++)
+		sum += int64_t(x[i]) * h[i];
+	return f_int64(f_int32(sum >> 32), f_uint32(sum));
+}
+
+#else
+
+f_int64 fixed_fir_dot(const f_int32* x, const f_int32* h, size_t n)
+{
+	f_int64 sum;
+	for (size_t i = 0; i < n; i++)
+		sum += f_int64::mult32(x[i], h[i]);
+	return sum;
+}
+
+#endif
+
+const char* fixed_fir_kernel()
+{
+#if defined(FIXED_FIR_AVX2)
+	return "avx2";
+#elif defined(FIXED_FIR_SSE41)
+	return "sse4.1";
+#elif defined(FIXED_FIR_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,216 @@
+#ifndef __FixedFir__
+#define __FixedFir__
+/*
+FixedFir.h. Fixed point FIR filters.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedFir
+
+FixedQ1_15 h[5] = { ... };              // h[0] weights the newest sample
+FixedFir<5, FixedQ1_15> lowpass(h);     // or FixedFir<5> for Fixed16 taps
+
+Fixed16 y = lowpass.process(x);         // one sample at a time
+lowpass.process(in, out, 256);          // or a block at a time (in may be out)
+lowpass.reset();                        // forget the past samples
+
+Each output is y[n] = h[0] x[n] + h[1] x[n-1] + ... + h[Taps-1] x[n-Taps+1].
+The products are summed exactly in 64 bits and narrowed once at the end,
+as Fixed16::FromFixed32() narrows a single product, so a filter gives the
+same bits however the samples are split into blocks.
+
+The past samples are held in a circular delay line, stored twice over, so
+that the last Taps samples are always contiguous. The sum of products is
+then one pass over two arrays, which fixed_fir_dot() does with AVX2, SSE4.1
+or NEON when the compiler targets one of them, and with a plain loop
+otherwise. Define FIXED_NO_SIMD to always use the plain loop.
+
+The sum does not overflow while sum |h[k]| times the largest sample fits in
+a Fixed16. The final narrowing behaves as Fixed16's does, so it throws on
+overflow when IOSTREAMS is defined.
+*/
+
+#include <stddef.h>
+
+#include "Fixed.h"
+
+/*!\brief The exact sum x[0]*h[0] + ... + x[n-1]*h[n-1] of raw values.
+*/
+f_int64 fixed_fir_dot(const f_int32* x, const f_int32* h, size_t n);
+
+/*!\brief The instruction set that fixed_fir_dot() was built for: "avx2", "sse4.1", "neon" or "scalar"
+*/
+const char* fixed_fir_kernel();
+
+/*!\brief A Taps long FIR filter on Fixed16 samples, with Coeff coefficients
+    (Fixed16, FixedQ1_15 or any other Fixed format of up to 32 bits).
+*/
+template <int Taps, class Coeff = Fixed16> class FixedFir
+{
+    static_assert(Taps >= 1, "a FixedFir needs at least one tap");
+    static_assert(sizeof(typename Coeff::storage_type) <= sizeof(f_int32), "FixedFir coefficients are at most 32 bits");
+
+public:
+    typedef Coeff coeff_type;
+    static const int taps = Taps;
+
+    FixedFir() {    // all taps zero
+        for (int k = 0; k < Taps; k++)
+            m_h[k] = 0;
+        reset();
+    }
+
+    explicit FixedFir(const Coeff* h) {
+        set_coefficients(h);
+        reset();
+    }
+
+    /*!\brief h[0] weights the newest sample. The delay line is kept. */
+    void set_coefficients(const Coeff* h) {
+        /* Reversed, to match the delay line, which runs from oldest to newest */
+        for (int k = 0; k < Taps; k++)
+            m_h[Taps - 1 - k] = f_int32(h[k].Raw());
+    }
+
+    Coeff coefficient(int k) const {
+        return Coeff::FromRaw(typename Coeff::storage_type(m_h[Taps - 1 - k]));
+    }
+
+    /*!\brief Set every past sample to zero */
+    void reset() {
+        for (int k = 0; k < 2*Taps; k++)
+            m_x[k] = 0;
+        m_oldest = 0;
+    }
+
+    /*!\brief Filter one sample */
+    Fixed16 process(const Fixed16& x) {
+        push(x);
+        return narrow(fixed_fir_dot(m_x + m_oldest, m_h, Taps));
+    }
+
+    /*!\brief Filter n samples. in and out may be the same array. */
+    void process(const Fixed16* in, Fixed16* out, size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            push(in[i]);
+            out[i] = narrow(fixed_fir_dot(m_x + m_oldest, m_h, Taps));
+        }
+    }
+
+#ifdef IOSTREAMS
+    static void testharness();
+#endif
+
+private:
+    /* Overwrite the oldest sample, in both copies */
+    void push(const Fixed16& x) {
+        m_x[m_oldest] = x.Raw();
+        m_x[m_oldest + Taps] = x.Raw();
+        m_oldest = (m_oldest + 1 == Taps) ? 0 : m_oldest + 1;
+    }
+
+    /* The sum has Coeff::frac_bits more fractional bits than a Fixed16 */
+    static Fixed16 narrow(const f_int64& sum) {
+        typedef Fixed16::rounding_policy R;
+        typedef Fixed16::overflow_policy P;
+        const int F = Coeff::frac_bits;
+        return Fixed16::FromRaw(P::template narrow_shr<f_int32>(R::template add_bias<f_int32>(sum, F), F));
+    }
+
+    f_int32 m_h[Taps];      // raw coefficients, oldest sample's first
+    f_int32 m_x[2*Taps];    // the last Taps samples are m_x[m_oldest .. m_oldest + Taps - 1]
+    int m_oldest;
+};
+
+#ifdef IOSTREAMS
+template <int Taps, class Coeff> void FixedFir<Taps,Coeff>::testharness()
+{
+    cout << "FixedFir<" << Taps << "," << Coeff::int_bits << "." << Coeff::frac_bits << "> testharness (" << fixed_fir_kernel() << ")" << endl;
+
+    /* Pseudo-random taps between -1/Taps and 1/Taps, and samples between -64 and 64 */
+    Coeff h[Taps];
+    f_uint32 seed = 54321;
+    for (int k = 0; k < Taps; k++)
+        h[k] = Coeff::FromRaw(typename Coeff::storage_type(test_rand(seed) >> (32 - Coeff::frac_bits)) / Taps);
+
+    const int N = 3*Taps + 37;
+    Fixed16 in[N];
+    test_fill(in, N, seed, 9);
+
+    /* The definition, each output narrowed from its exact sum */
+    Fixed16 expected[N];
+    for (int i = 0; i < N; i++)
+    {
+        f_int64 sum;
+        for (int k = 0; k < Taps && k <= i; k++)
+            sum += f_int64::mult32(in[i - k].Raw(), f_int32(h[k].Raw()));
+        expected[i] = narrow(sum);
+    }
+
+    /* One sample at a time */
+    FixedFir fir(h);
+    Fixed16 out[N];
+    for (int i = 0; i < N; i++)
+        out[i] = fir.process(in[i]);
+    test_result("process(x) mismatches", test_mismatches(out, expected, N), 0);
+
+    /* Blocks of any size give the same bits, in place or not */
+    fir.reset();
+    fir.process(in, out, N);
+    fir.reset();
+    Fixed16 pieces[N];
+    test_in_blocks(N, 3, [&](int done, int n) {
+        for (int i = 0; i < n; i++)
+            pieces[done + i] = in[done + i];
+        fir.process(pieces + done, pieces + done, n);
+    });
+    test_result("process(in, out, n) mismatches", test_mismatches(out, expected, N) + test_mismatches(pieces, expected, N), 0);
+
+    /* The impulse response is the taps, narrowed to Fixed16, and a step settles at their sum */
+    fir.reset();
+    for (int k = 0; k < Taps; k++)
+    {
+        out[k] = fir.process((k == 0) ? Fixed16::one() : Fixed16::zero());
+        expected[k] = narrow(f_int64::mult32(Fixed16::one().Raw(), f_int32(h[k].Raw())));
+    }
+    test_result("impulse response mismatches", test_mismatches(out, expected, Taps), 0);
+
+    fir.reset();
+    Fixed16 step, total;
+    for (int k = 0; k < Taps; k++)
+    {
+        step = fir.process(Fixed16(4));
+        total += fixed_cast<Fixed16>(h[k]) << 2;
+    }
+    test_result("step response", step, total, Fixed16::FromRaw(4 * Taps));
+    test_result("coefficient(Taps - 1)", fir.coefficient(Taps - 1), h[Taps - 1]);
+}
+#endif
+
+#endif /* __FixedFir__ */
@@ -57,6 +57,13 @@ bool FixedMatrix::testharness()
 	cout << "dot(a,b) " << dot(a,b) << endl;
 	cout << "det(a) " << det(a) << endl;
 	cout << "inv(a) " << inv(a) << endl;
+	{
+		FixedVector x;
+		test_result("solve(a, c, x) status", int(solve(a, c, x)), int(FIXED_SOLVE_OK));
+		test_result("a*x - c", norm(a*x - c), Fixed16(0), Fixed16::FromRaw(8));
+		FixedMatrix singular(1,2,3, 2,4,6, 1,4,6);
+		test_result("inv(singular) status", int(inv(singular, singular)), int(FIXED_SOLVE_SINGULAR));
+	}
 	cout << "trans(a) " << trans(a) << endl;
 	cout << "cofact(a) " << cofact(a) << endl;
 	
@@ -65,6 +72,15 @@ bool FixedMatrix::testharness()
 	
 	cout << "c*a " << (c * a) << endl;		
 	cout << "a*c " << (a * c) << endl;		
+
+	{
+		FixedMatrix n(a.toN() * b.toN());
+		int mismatches = 0;
+		if (n.m11 != d.m11 || n.m12 != d.m12 || n.m13 != d.m13) mismatches++;
+		if (n.m21 != d.m21 || n.m22 != d.m22 || n.m23 != d.m23) mismatches++;
+		if (n.m31 != d.m31 || n.m32 != d.m32 || n.m33 != d.m33) mismatches++;
+		test_result("FixedMatrixN<3,3> a*b mismatched rows", mismatches, 0);
+	}
 		
 	cout << "a*f " << a*f << endl;	
 	cout << "a/f " << a/f << endl;	
@@ -79,7 +95,8 @@ bool FixedMatrix::testharness()
 		FixedMatrix m(3,4,5, 3,4,5, 3,4,5);
 		cout << "m " << m << endl;
 
-		m = m / Fixed16(10);
+		m = div_by<10>(m);
+		test_result("div_by<10>(FixedMatrix)", m.m23, Fixed16::FromRaw(32768));
 
 	}
 	cout << endl << "FixedMatrix TestHarness Complete" << endl << endl;
@@ -106,11 +123,16 @@ FixedMatrix operator+(const FixedMatrix& a, const FixedMatrix& b)
 				a.m31 + b.m31, a.m32 + b.m32, a.m33 + b.m33);
 }
 
-FixedMatrix operator/(const FixedMatrix& a, const Fixed16& b)
+FixedMatrix operator/(const FixedMatrix& a, const Fixed16Divider& b)
 {
 	return FixedMatrix(a.m11 /b, a.m12 /b , a.m13 /b , a.m21 /b , a.m22 /b , a.m23 /b , a.m31 /b , a.m32 /b , a.m33 /b);
 }
 
+FixedMatrix operator/(const FixedMatrix& a, const Fixed16& b)
+{
+	return a / Fixed16Divider(b);
+}
+
 FixedMatrix operator*(const FixedMatrix& a, const Fixed16& b)
 {
 	return FixedMatrix(a.m11 *b, a.m12 *b , a.m13 *b , a.m21 *b , a.m22 *b , a.m23 *b , a.m31 *b , a.m32 *b , a.m33 *b);
@@ -120,19 +142,29 @@ FixedMatrix operator*(const Fixed16& b, const FixedMatrix& a)
 	return FixedMatrix(a.m11 *b, a.m12 *b , a.m13 *b , a.m21 *b , a.m22 *b , a.m23 *b , a.m31 *b , a.m32 *b , a.m33 *b);
 }
 
+/*!\brief a1*b1 + a2*b2 + a3*b3, rounded once
+*/
+static Fixed16 dot3(const Fixed16& a1, const Fixed16& a2, const Fixed16& a3,
+		const Fixed16& b1, const Fixed16& b2, const Fixed16& b3)
+{
+	Fixed32 acc;
+	Fixed16::mac(acc, a1, b1);
+	Fixed16::mac(acc, a2, b2);
+	Fixed16::mac(acc, a3, b3);
+	return Fixed16::FromAccumulator(acc);
+}
+
 FixedMatrix operator*(const FixedMatrix& a, const FixedMatrix& b)
 {
-	FixedVector a1(a.m11, a.m12, a.m13);
-	FixedVector a2(a.m21, a.m22, a.m23);
-	FixedVector a3(a.m31, a.m32, a.m33);
-	
-	FixedVector b1(b.m11, b.m21, b.m31);
-	FixedVector b2(b.m12, b.m22, b.m32);
-	FixedVector b3(b.m13, b.m23, b.m33);
-	
-	return FixedMatrix(	dot(a1, b1), dot(a1, b2), dot(a1, b3), 
-				dot(a2, b1), dot(a2, b2), dot(a2, b3), 
-				dot(a3, b1), dot(a3, b2), dot(a3, b3));
+	return FixedMatrix(	dot3(a.m11, a.m12, a.m13, b.m11, b.m21, b.m31),
+				dot3(a.m11, a.m12, a.m13, b.m12, b.m22, b.m32),
+				dot3(a.m11, a.m12, a.m13, b.m13, b.m23, b.m33),
+				dot3(a.m21, a.m22, a.m23, b.m11, b.m21, b.m31),
+				dot3(a.m21, a.m22, a.m23, b.m12, b.m22, b.m32),
+				dot3(a.m21, a.m22, a.m23, b.m13, b.m23, b.m33),
+				dot3(a.m31, a.m32, a.m33, b.m11, b.m21, b.m31),
+				dot3(a.m31, a.m32, a.m33, b.m12, b.m22, b.m32),
+				dot3(a.m31, a.m32, a.m33, b.m13, b.m23, b.m33));
 }
 
 /*!\brief multiply a vector by a matrix returning a vector
@@ -140,11 +172,9 @@ FixedMatrix operator*(const FixedMatrix& a, const FixedMatrix& b)
 */
 FixedVector operator*(const FixedVector& a, const FixedMatrix& b)
 {
-	FixedVector b1(b.m11, b.m21, b.m31);
-	FixedVector b2(b.m12, b.m22, b.m32);
-	FixedVector b3(b.m13, b.m23, b.m33);
-	
-	return FixedVector(dot(a, b1), dot(a, b2), dot(a, b3));
+	return FixedVector(	dot3(a.x, a.y, a.z, b.m11, b.m21, b.m31),
+				dot3(a.x, a.y, a.z, b.m12, b.m22, b.m32),
+				dot3(a.x, a.y, a.z, b.m13, b.m23, b.m33));
 }
 
 /*!\brief multiply a matrix by a vector returning a vector
@@ -152,11 +182,9 @@ FixedVector operator*(const FixedVector& a, const FixedMatrix& b)
 */
 FixedVector operator*(const FixedMatrix& b, const FixedVector& a)
 {
-	FixedVector b1(b.m11, b.m12, b.m13);
-	FixedVector b2(b.m21, b.m22, b.m23);
-	FixedVector b3(b.m31, b.m32, b.m33);
-	
-	return FixedVector(dot(a, b1), dot(a, b2), dot(a, b3));
+	return FixedVector(	dot3(b.m11, b.m12, b.m13, a.x, a.y, a.z),
+				dot3(b.m21, b.m22, b.m23, a.x, a.y, a.z),
+				dot3(b.m31, b.m32, b.m33, a.x, a.y, a.z));
 }
 
 FixedMatrix operator-(const FixedMatrix& a, const FixedMatrix& b)
@@ -168,27 +196,28 @@ FixedMatrix operator-(const FixedMatrix& a, const FixedMatrix& b)
 
 FixedVector dot(const FixedMatrix& a, const FixedMatrix& b)
 {
-	FixedVector a1(a.m11, a.m12, a.m13);
-	FixedVector a2(a.m21, a.m22, a.m23);
-	FixedVector a3(a.m31, a.m32, a.m33);
-	
-	FixedVector b1(b.m11, b.m12, b.m13);
-	FixedVector b2(b.m21, b.m22, b.m23);
-	FixedVector b3(b.m31, b.m32, b.m33);
-	
-	return FixedVector(dot(a1, b1), dot(a2, b2), dot(a3, b3));
+	return FixedVector(	dot3(a.m11, a.m12, a.m13, b.m11, b.m12, b.m13),
+				dot3(a.m21, a.m22, a.m23, b.m21, b.m22, b.m23),
+				dot3(a.m31, a.m32, a.m33, b.m31, b.m32, b.m33));
 }
 
+/*!\brief Expand along the first row. The 2x2 minors are rounded once
+	each, and the final sum once more.
+*/
 Fixed16 det(const FixedMatrix& a)
 {
-	return Fixed16 (a.m11*a.m22*a.m33 - a.m13*a.m22*a.m31 + 
-			a.m12*a.m23*a.m31 - a.m12*a.m21*a.m33 + 
-			a.m13*a.m21*a.m32 - a.m11*a.m23*a.m32);
+	return dot3(a.m11, a.m12, a.m13,
+		det2by2(a.m22, a.m23, a.m32, a.m33),
+		det2by2(a.m23, a.m21, a.m33, a.m31),
+		det2by2(a.m21, a.m22, a.m31, a.m32));
 }
 
 Fixed16 det2by2(const Fixed16& a, const Fixed16& b, const Fixed16& c, const Fixed16& d)
 {
-	return Fixed16 (a*d - c*b);
+	Fixed32 acc;
+	Fixed16::mac(acc, a, d);
+	Fixed16::msub(acc, c, b);
+	return Fixed16::FromAccumulator(acc);
 }
 
 FixedMatrix cofact(const FixedMatrix& a)
@@ -200,14 +229,30 @@ FixedMatrix cofact(const FixedMatrix& a)
 
 FixedMatrix inv(const FixedMatrix& a)
 {
-	Fixed16 determ = det(a);
-	if (determ != Fixed16(0)) //TODO it might not actually return zero due to rounding but be close to zero need to check
-	{
-		return (trans(cofact(a))/determ);	
-	}
-	else
-		return FixedMatrix(0,0,0, 0,0,0, 0,0,0); //TODO this could be better, due to non-invertable matrix
-	
+	FixedMatrix r;
+	inv(a, r);
+	return r;
+}
+
+FixedSolveStatus inv(const FixedMatrix& a, FixedMatrix& r)
+{
+	FixedMatrixN<3,3> n;
+	FixedSolveStatus status = FixedLU<3>(a.toN()).inverse(n);
+	if (status == FIXED_SOLVE_OK)
+		r = FixedMatrix(n);
+	return status;
+}
+
+FixedSolveStatus solve(const FixedMatrix& a, const FixedVector& b, FixedVector& x)
+{
+	FixedMatrixN<3,1> n;
+	n(0,0) = b.x;
+	n(1,0) = b.y;
+	n(2,0) = b.z;
+	FixedSolveStatus status = FixedLU<3>(a.toN()).solve(n, n);
+	if (status == FIXED_SOLVE_OK)
+		x = FixedVector(n(0,0), n(1,0), n(2,0));
+	return status;
 }
 
 FixedMatrix trans(const FixedMatrix& a)
@@ -222,11 +267,16 @@ FixedMatrix trans(const FixedMatrix& a)
 
 FixedMatrix getrotmat(Fixed16& theta, Fixed16& phi, Fixed16& psi)
 {
-	FixedMatrix Rr (one_f16,zero_f16,zero_f16, zero_f16,cos(theta),-sin(theta), zero_f16,sin(theta),cos(theta));
+	Fixed16 sr, cr, sp, cp, sy, cy;
+	sincos(theta, sr, cr);
+	sincos(phi, sp, cp);
+	sincos(psi, sy, cy);
+
+	FixedMatrix Rr (one_f16,zero_f16,zero_f16, zero_f16,cr,-sr, zero_f16,sr,cr);
 	
-	FixedMatrix Rp (cos(phi),zero_f16,sin(phi), zero_f16,one_f16,zero_f16, -sin(phi),zero_f16,cos(phi));
+	FixedMatrix Rp (cp,zero_f16,sp, zero_f16,one_f16,zero_f16, -sp,zero_f16,cp);
 	
-	FixedMatrix Ry (cos(psi),-sin(psi),zero_f16, sin(psi),cos(psi),zero_f16, zero_f16,zero_f16,one_f16);
+	FixedMatrix Ry (cy,-sy,zero_f16, sy,cy,zero_f16, zero_f16,zero_f16,one_f16);
 	
 	return ( Ry*Rp*Rr );
 }
@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 #include "Fixed.h"
 #include "FixedVector.h"
+#include "FixedMatrixN.h"
+#include "FixedSolve.h"
 
 //class Quaternion;
 // #include "Quaternion.h"
@@ -90,6 +92,24 @@ public:
 			m31(in_m31),m32(in_m32),m33(in_m33)
 	{
 	}
+
+	/*!\brief The same matrix with named elements */
+	explicit FixedMatrix(const FixedMatrixN<3,3>& m)
+		: 	m11(m(0,0)), m12(m(0,1)), m13(m(0,2)),
+			m21(m(1,0)), m22(m(1,1)), m23(m(1,2)),
+			m31(m(2,0)), m32(m(2,1)), m33(m(2,2))
+	{
+	}
+
+	/*!\brief The same matrix as a FixedMatrixN<3,3> */
+	FixedMatrixN<3,3> toN() const
+	{
+		FixedMatrixN<3,3> r;
+		r(0,0) = m11; r(0,1) = m12; r(0,2) = m13;
+		r(1,0) = m21; r(1,1) = m22; r(1,2) = m23;
+		r(2,0) = m31; r(2,1) = m32; r(2,2) = m33;
+		return r;
+	}
 	
 //	this is now a for rotating a vector using a rotation matrix, but probably not right yet
 //	/*!\brief Rotate a vector using the Matrix m
@@ -113,6 +133,16 @@ FixedMatrix operator*(const FixedMatrix& a, const FixedMatrix& b);
 FixedVector operator*(const FixedVector& a, const FixedMatrix& b);
 FixedVector operator*(const FixedMatrix& b, const FixedVector& a);
 FixedMatrix operator/(const FixedMatrix& a, const Fixed16& b);
+FixedMatrix operator/(const FixedMatrix& a, const Fixed16Divider& b);
+
+/*!\brief a / N for a constant integer N, see div_by(Fixed16)
+*/
+template <f_int32 N> FixedMatrix div_by(const FixedMatrix& a)
+{
+	return FixedMatrix(div_by<N>(a.m11), div_by<N>(a.m12), div_by<N>(a.m13),
+			div_by<N>(a.m21), div_by<N>(a.m22), div_by<N>(a.m23),
+			div_by<N>(a.m31), div_by<N>(a.m32), div_by<N>(a.m33));
+}
 
 /*!\brief returns the inner dot product for each of the rows of a and b (opposite to matlab which uses the columbs)
 	same as the diagonal elements of (a*transpose(b))
@@ -124,11 +154,19 @@ FixedVector dot(const FixedMatrix& a, const FixedMatrix& b);
 */
 Fixed16 det(const FixedMatrix& a);
 
-/*!\brief returns the inverse of a matrix
+/*!\brief returns the inverse of a matrix, or the zero matrix if it is singular
 	
 */
 FixedMatrix inv(const FixedMatrix& a);
 
+/*!\brief r = the inverse of a, by LU decomposition. r is left alone if a is singular.
+*/
+FixedSolveStatus inv(const FixedMatrix& a, FixedMatrix& r);
+
+/*!\brief x = inv(a) * b, by LU decomposition without forming the inverse
+*/
+FixedSolveStatus solve(const FixedMatrix& a, const FixedVector& b, FixedVector& x);
+
 /*!\brief returns the transpose of a matrix
 	
 */
@@ -0,0 +1,296 @@
+#ifndef __FixedMatrixN__
+#define __FixedMatrixN__
+/*
+FixedMatrixN.h. Fixed point matrices of any size known at compile time.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedMatrixN
+
+FixedMatrixN<6,6> P = FixedMatrixN<6,6>::identity();   // Fixed16 elements
+FixedMatrixN<6,3> K;
+K(0,2) = Fixed16(3);
+FixedMatrixN<6,6> Q = K * trans(K) + P * Fixed16::one();
+FixedMatrixN<3,3,FixedQ8_24> S;                       // any Fixed<> format
+
+The elements are held in a plain row-major array, so a matrix is the same
+size as R*C numbers and nothing is allocated. Each element of a product is
+the exact sum of its products, rounded once by FromAccumulator(), as for
+FixedMatrix. Products with a short inner dimension are unrolled at compile
+time; longer ones work on 2x2 blocks of the result, so that each element
+loaded is used twice. Both give the same bits.
+
+FixedMatrix is still the 3x3 Fixed16 matrix with named elements. It
+converts to and from FixedMatrixN<3,3> with FixedMatrix::toN() and
+FixedMatrix(const FixedMatrixN<3,3>&).
+*/
+
+#include <type_traits>
+
+#include "Fixed.h"
+
+/*!\brief An R x C matrix of Q numbers, stored row by row.
+*/
+template <int R, int C, class Q = Fixed16> class FixedMatrixN
+{
+    static_assert(R >= 1 && C >= 1, "FixedMatrixN must have at least one row and column");
+
+public:
+    typedef Q value_type;
+    typedef typename Q::product_type accumulator_type;
+
+    static const int rows = R;
+    static const int cols = C;
+
+    FixedMatrixN() {}   // all zero
+
+    static FixedMatrixN identity() {
+        FixedMatrixN r;
+        for (int i = 0; i < R && i < C; i++)
+            r(i, i) = Q::one();
+        return r;
+    }
+
+    Q& operator()(int r, int c) { return m_data[r*C + c]; }
+    const Q& operator()(int r, int c) const { return m_data[r*C + c]; }
+
+    Q* data() { return m_data; }
+    const Q* data() const { return m_data; }
+
+#ifdef IOSTREAMS
+    static void testharness();
+#endif
+
+private:
+    Q m_data[R*C];
+};
+
+/*!\brief acc += a[0]*b[0] + a[1]*b[stride] + ... + a[K-1]*b[(K-1)*stride], unrolled
+*/
+template <int K> struct fixed_matrix_unroll
+{
+    template <class Q> static void mac(typename Q::product_type& acc, const Q* a, const Q* b, int stride) {
+        fixed_matrix_unroll<K - 1>::mac(acc, a, b, stride);
+        Q::mac(acc, a[K - 1], b[(K - 1)*stride]);
+    }
+};
+
+template <> struct fixed_matrix_unroll<0>
+{
+    template <class Q> static void mac(typename Q::product_type&, const Q*, const Q*, int) {}
+};
+
+template <int R, int C, class Q>
+FixedMatrixN<R,C,Q> operator+(const FixedMatrixN<R,C,Q>& a, const FixedMatrixN<R,C,Q>& b)
+{
+    FixedMatrixN<R,C,Q> r;
+    for (int i = 0; i < R*C; i++)
+        r.data()[i] = a.data()[i] + b.data()[i];
+    return r;
+}
+
+template <int R, int C, class Q>
+FixedMatrixN<R,C,Q> operator-(const FixedMatrixN<R,C,Q>& a, const FixedMatrixN<R,C,Q>& b)
+{
+    FixedMatrixN<R,C,Q> r;
+    for (int i = 0; i < R*C; i++)
+        r.data()[i] = a.data()[i] - b.data()[i];
+    return r;
+}
+
+/*!\brief Scale every element, truncating each product as FixedMatrix * Fixed16 does
+*/
+template <int R, int C, class Q>
+FixedMatrixN<R,C,Q> operator*(const FixedMatrixN<R,C,Q>& a, const Q& s)
+{
+    FixedMatrixN<R,C,Q> r;
+    for (int i = 0; i < R*C; i++)
+        r.data()[i] = Q(a.data()[i] * s);
+    return r;
+}
+
+template <int R, int C, class Q>
+FixedMatrixN<R,C,Q> operator*(const Q& s, const FixedMatrixN<R,C,Q>& a)
+{
+    return a * s;
+}
+
+template <int R, int C, class Q>
+FixedMatrixN<C,R,Q> trans(const FixedMatrixN<R,C,Q>& a)
+{
+    FixedMatrixN<C,R,Q> r;
+    for (int i = 0; i < R; i++)
+        for (int j = 0; j < C; j++)
+            r(j, i) = a(i, j);
+    return r;
+}
+
+/*!\brief The matrix product a * b, each element rounded once.
+*/
+template <int R, int K, int C, class Q>
+FixedMatrixN<R,C,Q> operator*(const FixedMatrixN<R,K,Q>& a, const FixedMatrixN<K,C,Q>& b)
+{
+    typedef typename Q::product_type acc_type;
+    FixedMatrixN<R,C,Q> r;
+    const Q* pa = a.data();
+    const Q* pb = b.data();
+
+    if (K <= 4)
+    {
+        for (int i = 0; i < R; i++)
+            for (int j = 0; j < C; j++)
+            {
+                acc_type acc;
+                fixed_matrix_unroll<K>::mac(acc, pa + i*K, pb + j, C);
+                r(i, j) = Q::FromAccumulator(acc);
+            }
+        return r;
+    }
+
+    /* Each pass over k forms a 2x2 block of the result */
+    int i = 0;
+    for (; i + 1 < R; i += 2)
+    {
+        const Q* a0 = pa + i*K;
+        const Q* a1 = a0 + K;
+        int j = 0;
+        for (; j + 1 < C; j += 2)
+        {
+            acc_type c00, c01, c10, c11;
+            for (int k = 0; k < K; k++)
+            {
+                const Q& b0 = pb[k*C + j];
+                const Q& b1 = pb[k*C + j + 1];
+                Q::mac(c00, a0[k], b0);
+                Q::mac(c01, a0[k], b1);
+                Q::mac(c10, a1[k], b0);
+                Q::mac(c11, a1[k], b1);
+            }
+            r(i, j) = Q::FromAccumulator(c00);
+            r(i, j + 1) = Q::FromAccumulator(c01);
+            r(i + 1, j) = Q::FromAccumulator(c10);
+            r(i + 1, j + 1) = Q::FromAccumulator(c11);
+        }
+        if (j < C)
+        {
+            acc_type c0, c1;
+            for (int k = 0; k < K; k++)
+            {
+                Q::mac(c0, a0[k], pb[k*C + j]);
+                Q::mac(c1, a1[k], pb[k*C + j]);
+            }
+            r(i, j) = Q::FromAccumulator(c0);
+            r(i + 1, j) = Q::FromAccumulator(c1);
+        }
+    }
+    if (i < R)
+    {
+        const Q* a0 = pa + i*K;
+        for (int j = 0; j < C; j++)
+        {
+            acc_type acc;
+            for (int k = 0; k < K; k++)
+                Q::mac(acc, a0[k], pb[k*C + j]);
+            r(i, j) = Q::FromAccumulator(acc);
+        }
+    }
+    return r;
+}
+
+#ifdef IOSTREAMS
+template <int R, int C, class Q>
+std::ostream& operator<<(std::ostream& os, const FixedMatrixN<R,C,Q>& m)
+{
+    os << "[";
+    for (int i = 0; i < R; i++)
+    {
+        os << "(";
+        for (int j = 0; j < C; j++)
+            os << m(i, j) << ((j + 1 < C) ? "," : "");
+        os << ")" << ((i + 1 < R) ? ", " : "");
+    }
+    os << "]";
+    return os;
+}
+
+template <int R, int C, class Q> void FixedMatrixN<R,C,Q>::testharness()
+{
+    cout << "FixedMatrixN<" << R << "," << C << "> testharness" << endl;
+
+    /* Pseudo-random elements between -2 and 2, using every fractional bit */
+    FixedMatrixN<R,C,Q> a;
+    FixedMatrixN<C,R,Q> b;
+    f_uint32 seed = 12345;
+    for (int i = 0; i < R*C; i++)
+    {
+        a.data()[i] = Q::FromRaw(typename Q::storage_type(test_rand(seed) >> (30 - Q::frac_bits)));
+        b.data()[i] = Q::FromRaw(typename Q::storage_type(test_rand(seed) >> (30 - Q::frac_bits)));
+    }
+
+    /* The products against one sum of products per element, the plain way */
+    FixedMatrixN<R,R,Q> p;
+    for (int i = 0; i < R; i++)
+        for (int j = 0; j < R; j++)
+        {
+            typename Q::product_type acc;
+            for (int k = 0; k < C; k++)
+                Q::mac(acc, a(i, k), b(k, j));
+            p(i, j) = Q::FromAccumulator(acc);
+        }
+    test_result("a * b mismatches", test_mismatches((a * b).data(), p.data(), R*R), 0);
+
+    FixedMatrixN<C,C,Q> q;
+    for (int i = 0; i < C; i++)
+        for (int j = 0; j < C; j++)
+        {
+            typename Q::product_type acc;
+            for (int k = 0; k < R; k++)
+                Q::mac(acc, b(i, k), a(k, j));
+            q(i, j) = Q::FromAccumulator(acc);
+        }
+    test_result("b * a mismatches", test_mismatches((b * a).data(), q.data(), C*C), 0);
+
+    FixedMatrixN<R,C,Q> ia = FixedMatrixN<R,R,Q>::identity() * a;
+    FixedMatrixN<R,C,Q> ai = a * FixedMatrixN<C,C,Q>::identity();
+    FixedMatrixN<R,C,Q> tt = trans(trans(a));
+    FixedMatrixN<R,C,Q> bt = trans(b);
+    FixedMatrixN<R,C,Q> s = (a + bt) - bt;
+    int mismatches = test_mismatches(ia.data(), a.data(), R*C) + test_mismatches(ai.data(), a.data(), R*C)
+                   + test_mismatches(tt.data(), a.data(), R*C) + test_mismatches(s.data(), a.data(), R*C);
+    test_result("identity, trans and add mismatches", mismatches, 0);
+
+    /* Halving truncates like >> 1, unless Q rounds its products some other way */
+    const bool truncates = std::is_same<typename Q::rounding_policy, fixed_truncate>::value;
+    FixedMatrixN<R,C,Q> h;
+    for (int i = 0; i < R*C; i++)
+        h.data()[i] = truncates ? (a.data()[i] >> 1) : Q(a.data()[i] * (Q::one() >> 1));
+    test_result("a * 0.5 mismatches", test_mismatches((a * (Q::one() >> 1)).data(), h.data(), R*C), 0);
+}
+#endif
+
+#endif /* __FixedMatrixN__ */
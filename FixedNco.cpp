@@ -0,0 +1,190 @@
+/*
+FixedNco.cpp. A numerically controlled oscillator, for fixed point carriers.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include "FixedNco.h"
+
+/* The blocks are turned into phases this many at a time, on the stack */
+static const size_t PHASE_BLOCK = 64;
+
+/*
+* A radian is 1/(2 PI) = 0.1591549... turns, which is 2^32 / (2 PI) =
+* 683565275.58 in Q32, rounded to 683565276. That is also the phase
+* accumulator's steps per radian, as a turn is 2^32 steps.
+*/
+static const f_int32 TURNS_PER_RADIAN_Q32 = 683565276;
+
+f_uint32 FixedNco::from_radians(const Fixed16& radians)
+{
+	/* Turns in Q48, of which we want bits 16 to 47, wrapped */
+	f_int64 p = f_int64::mult32(radians.Raw(), TURNS_PER_RADIAN_Q32);
+	p += f_int64(f_int32(1) << 15);
+	return (f_uint32(p.GetHi()) << 16) | (p.GetLo() >> 16);
+}
+
+void FixedNco::generate(Fixed16* s, Fixed16* c, size_t n)
+{
+	f_uint32 phase[PHASE_BLOCK];
+	for (size_t done = 0; done < n; done += PHASE_BLOCK)
+	{
+		size_t m = (n - done < PHASE_BLOCK) ? n - done : PHASE_BLOCK;
+		for (size_t i = 0; i < m; i++)
+		{
+			phase[i] = m_phase;
+			m_phase += m_step;
+		}
+		sincos_turns(phase, s ? s + done : 0, c ? c + done : 0, m);
+	}
+}
+
+void FixedNco::generate_fm(const f_int32* fm, Fixed16* s, Fixed16* c, size_t n)
+{
+	f_uint32 phase[PHASE_BLOCK];
+	for (size_t done = 0; done < n; done += PHASE_BLOCK)
+	{
+		size_t m = (n - done < PHASE_BLOCK) ? n - done : PHASE_BLOCK;
+		for (size_t i = 0; i < m; i++)
+		{
+			phase[i] = m_phase;
+			m_phase += m_step + f_uint32(fm[done + i]);
+		}
+		sincos_turns(phase, s ? s + done : 0, c ? c + done : 0, m);
+	}
+}
+
+void FixedNco::generate_pm(const f_int32* pm, Fixed16* s, Fixed16* c, size_t n)
+{
+	f_uint32 phase[PHASE_BLOCK];
+	for (size_t done = 0; done < n; done += PHASE_BLOCK)
+	{
+		size_t m = (n - done < PHASE_BLOCK) ? n - done : PHASE_BLOCK;
+		for (size_t i = 0; i < m; i++)
+		{
+			phase[i] = m_phase + f_uint32(pm[done + i]);
+			m_phase += m_step;
+		}
+		sincos_turns(phase, s ? s + done : 0, c ? c + done : 0, m);
+	}
+}
+
+
+#ifdef IOSTREAMS
+
+bool FixedNco::testharness()
+{
+	cout << "FixedNco testharness (" << kernel() << ")" << endl;
+
+	const double pi = 3.14159265358979323846;
+
+	test_result("step_for(0.25)", f_int32(step_for(Fixed16::one() >> 2)), f_int32(0x40000000));
+	test_result("step_for(-0.25)", f_int32(step_for(-(Fixed16::one() >> 2))), f_int32(0xC0000000));
+	test_result("from_radians(PI)", f_int32(from_radians(Fixed16::PI()) - 0x80000000u), 0, 1 << 15);
+	test_result("from_radians(-PI/2)", f_int32(from_radians(-Fixed16::PI_OVER_2()) - 0xC0000000u), 0, 1 << 15);
+	test_result("from_radians(4 PI)", f_int32(from_radians(Fixed16::PI() << 2)), 0, 1 << 16);
+
+	/* An awkward frequency, against libm, and the phase after n steps */
+	const size_t n = 1003;
+	const f_uint32 step = 0x2F1B7759u;   // about 0.184 cycles a sample
+	FixedNco nco(step, 0x12345678);
+	f_int32 worst = 0;
+	f_int32 power = 0;
+	Fixed16 s1[n], c1[n];
+	for (size_t i = 0; i < n; i++)
+	{
+		f_uint32 p = f_uint32(0x12345678u + f_uint32(i) * step);
+		nco.next(s1[i], c1[i]);
+
+		double x = 2 * pi * (p / 4294967296.0);
+		f_int32 es = std::abs(s1[i].Raw() - f_int32(std::floor(std::sin(x) * 65536.0 + 0.5)));
+		f_int32 ec = std::abs(c1[i].Raw() - f_int32(std::floor(std::cos(x) * 65536.0 + 0.5)));
+		if (es > worst) worst = es;
+		if (ec > worst) worst = ec;
+
+		/* sin^2 + cos^2 stays at one */
+		Fixed32 acc;
+		Fixed16::mac(acc, s1[i], s1[i]);
+		Fixed16::mac(acc, c1[i], c1[i]);
+		f_int32 ep = std::abs(Fixed16::FromAccumulator(acc).Raw() - Fixed16::one().Raw());
+		if (ep > power) power = ep;
+	}
+	test_result("next() error", worst, 0, 2);
+	test_result("sin^2 + cos^2 error", power, 0, 6);
+	test_result("phase after n steps", f_int32(nco.phase()), f_int32(0x12345678u + f_uint32(n) * step));
+
+	/* Blocks give the same bits as next(), however they are split */
+	Fixed16 s2[n], c2[n], s3[n];
+	nco.set_phase(0x12345678);
+	nco.generate(s2, c2, 100);
+	nco.generate(s2 + 100, c2 + 100, n - 100);
+	nco.set_phase(0x12345678);
+	nco.generate(s3, 0, n);
+	test_result("generate() mismatches", test_mismatches(s2, s1, n) + test_mismatches(c2, c1, n) + test_mismatches(s3, s1, n), 0);
+	test_result("phase after generate()", f_int32(nco.phase()), f_int32(0x12345678u + f_uint32(n) * step));
+
+	/* 64 samples a cycle come back round exactly */
+	FixedNco ring(step_for(Fixed16::FromRaw(1024)));
+	ring.generate(s2, c2, 65);
+	test_result("sample 64 == sample 0", s2[64], s2[0]);
+	test_result("sin(a quarter of the way round)", s2[16], Fixed16::one());
+	test_result("cos(half of the way round)", c2[32], -Fixed16::one());
+
+	/* FM by a constant is a change of frequency, and FM and PM agree with next() */
+	f_int32 fm[n], pm[n];
+	f_uint32 seed = 2468;
+	for (size_t i = 0; i < n; i++)
+	{
+		pm[i] = test_rand(seed);
+		fm[i] = pm[i] >> 4;
+	}
+	FixedNco a(step), b(step);
+	a.generate_fm(fm, s2, c2, n);
+	for (size_t i = 0; i < n; i++)
+	{
+		b.next(s1[i], c1[i]);
+		b.shift_phase(f_uint32(fm[i]));
+	}
+	test_result("generate_fm() mismatches", test_mismatches(s2, s1, n) + test_mismatches(c2, c1, n), 0);
+	test_result("phase after generate_fm()", f_int32(a.phase()), f_int32(b.phase()));
+
+	a.set_phase(0);
+	b.set_phase(0);
+	a.generate_pm(pm, s2, c2, n);
+	for (size_t i = 0; i < n; i++)
+	{
+		sincos_turns(b.phase() + f_uint32(pm[i]), s1[i], c1[i]);
+		b.shift_phase(b.step());
+	}
+	test_result("generate_pm() mismatches", test_mismatches(s2, s1, n) + test_mismatches(c2, c1, n), 0);
+	test_result("phase after generate_pm()", f_int32(a.phase()), f_int32(b.phase()));
+
+	return true;
+}
+
+#endif /* IOSTREAMS */
@@ -0,0 +1,140 @@
+#ifndef __FixedNco__
+#define __FixedNco__
+/*
+FixedNco.h. A numerically controlled oscillator, for fixed point carriers.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedNco
+
+FixedNco lo(FixedNco::step_for(Fixed16::FromRaw(6554)));   // 0.1 cycles a sample
+Fixed16 s, c;
+lo.next(s, c);                  // sin and cos of the phase, then step it on
+lo.generate(s_out, c_out, 256); // a block at a time (either array may be 0)
+lo.generate_fm(fm, s_out, c_out, 256);  // step by step() + fm[i] instead
+lo.generate_pm(pm, s_out, c_out, 256);  // output at phase() + pm[i]
+lo.shift_phase(FixedNco::from_radians(Fixed16::PI()));      // turn it over
+
+The phase is a 32 bit accumulator in which 2^32 is a whole turn, so it
+wraps round by itself and never needs reducing, and the frequency
+resolution is 2^-32 cycles a sample. The outputs are looked up with
+sincos_turns(), in the same tables as sin_lut(), so they are within
+one or two PRECISION() of sin() and cos() (see FixedTrig.h). The blocks are
+turned into phases first and then looked up with the block
+sincos_turns(), which uses AVX2 when the compiler targets it. Either way a
+block gives the same bits as calling next() for each sample.
+
+The modulation inputs are signed and in the same units as the phase:
+fm[i] is added to the step for sample i alone, and pm[i] offsets the phase
+of sample i alone, without moving the accumulator.
+*/
+
+#include <stddef.h>
+
+#include "Fixed.h"
+#include "FixedTrig.h"
+
+
+/*!\brief A numerically controlled oscillator, with a 32 bit phase accumulator
+	that wraps at a whole turn and table lookup sin and cos outputs.
+*/
+class FixedNco
+{
+public:
+	FixedNco()
+		: m_phase(0), m_step(0)
+	{
+	}
+
+	explicit FixedNco(f_uint32 step, f_uint32 phase = 0)
+		: m_phase(phase), m_step(step)
+	{
+	}
+
+	/*!\brief The step for a frequency in cycles a sample, which is wrapped into [0, 1)
+	*/
+	static f_uint32 step_for(const Fixed16& cycles) {
+		return f_uint32(cycles.Raw()) << 16;
+	}
+
+	/*!\brief An angle in radians as a phase, rounded to the nearest 2^-32 of a turn
+	*/
+	static f_uint32 from_radians(const Fixed16& radians);
+
+	f_uint32 step() const { return m_step; }
+	void set_step(f_uint32 step) { m_step = step; }
+
+	f_uint32 phase() const { return m_phase; }
+	void set_phase(f_uint32 phase) { m_phase = phase; }
+
+	/*!\brief Move the phase on by delta (which may be negative, as a two's complement f_uint32)
+	*/
+	void shift_phase(f_uint32 delta) { m_phase += delta; }
+
+	/*!\brief sin and cos of the phase, which then moves on by step()
+	*/
+	void next(Fixed16& s, Fixed16& c) {
+		sincos_turns(m_phase, s, c);
+		m_phase += m_step;
+	}
+
+	/*!\brief sin of the phase, which then moves on by step()
+	*/
+	Fixed16 next() {
+		Fixed16 s = sin_turns(m_phase);
+		m_phase += m_step;
+		return s;
+	}
+
+	/*!\brief n samples of sin into s and cos into c, as next() would give them.
+		Either may be 0.
+	*/
+	void generate(Fixed16* s, Fixed16* c, size_t n);
+
+	/*!\brief The same, with step() + fm[i] as the step after sample i
+	*/
+	void generate_fm(const f_int32* fm, Fixed16* s, Fixed16* c, size_t n);
+
+	/*!\brief The same, with sample i taken at phase() + pm[i]. The accumulator
+		moves on by step() as usual.
+	*/
+	void generate_pm(const f_int32* pm, Fixed16* s, Fixed16* c, size_t n);
+
+	/*!\brief The instruction set the blocks are looked up with: "avx2" or "scalar" */
+	static const char* kernel() { return fixed_trig_kernel(); }
+
+#ifdef IOSTREAMS
+	static bool testharness();
+#endif
+
+private:
+	f_uint32 m_phase;
+	f_uint32 m_step;
+};
+
+#endif /* __FixedNco__ */
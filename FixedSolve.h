@@ -0,0 +1,407 @@
+#ifndef __FixedSolve__
+#define __FixedSolve__
+/*
+FixedSolve.h. LU and Cholesky solvers for FixedMatrixN.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the solvers
+
+FixedMatrixN<6,6> A, Ainv;
+FixedMatrixN<6,1> b, x;
+if (solve(A, b, x) != FIXED_SOLVE_OK)       // x = A^-1 b, without forming A^-1
+    ...
+FixedLU<6> lu(A);                            // factor once ...
+lu.solve(b, x);                              // ... and solve for many right hand sides
+lu.inverse(Ainv);
+
+FixedCholesky<6> chol(P);                    // P symmetric positive definite
+chol.solve(b, x);
+solve_spd(P, b, x);                          // the same thing
+
+Every element of the factors and of the solution is an exact sum of
+products, rounded once, and is then divided by its pivot. Each pivot is
+held in a FixedDivider, so it is inverted once and dividing by it is a
+multiply and a shift, rounded to nearest. Cholesky takes the square root
+of each pivot exactly from its accumulator, and only reads the lower
+triangle of the matrix.
+
+Singular matrices, and matrices that are not positive definite for
+Cholesky, are reported by the status rather than by throwing. Results
+that do not fit the format still throw when IOSTREAMS is defined.
+*/
+
+#include "FixedMatrixN.h"
+#include <type_traits>
+
+enum FixedSolveStatus {
+    FIXED_SOLVE_OK = 0,
+    FIXED_SOLVE_SINGULAR,               // a zero pivot
+    FIXED_SOLVE_NOT_POSITIVE_DEFINITE   // Cholesky met a pivot <= 0
+};
+
+/*!\brief The square root of a non-negative accumulator, rounded to nearest.
+    The accumulator holds twice the fractional bits, so this is the Fixed value.
+*/
+inline f_uint32 fixed_isqrt(const f_uint64& x)
+{
+    f_uint64 rem = x;
+    f_uint64 root;
+
+    /* Start from the highest power of four that is no more than x */
+    f_uint64 bit;
+    if (x.GetHi() != 0)
+        bit = f_uint64(f_uint32(1) << ((31 - f_clz32(x.GetHi())) & ~1), 0);
+    else if (x.GetLo() != 0)
+        bit = f_uint64(f_uint32(1) << ((31 - f_clz32(x.GetLo())) & ~1));
+    while (bit != f_uint64())
+    {
+        f_uint64 t = root + bit;
+        root >>= 1;
+        if (rem >= t)
+        {
+            rem -= t;
+            root += bit;
+        }
+        bit >>= 2;
+    }
+    /* rem = x - root^2, so round up when x > root^2 + root */
+    if (rem > root)
+        root += 1u;
+    return root.GetLo();
+}
+
+/*!\brief The LU decomposition, with partial pivoting, of an N x N matrix.
+    The factors are computed when it is constructed.
+*/
+template <int N, class Q = Fixed16> class FixedLU
+{
+    typedef typename Q::product_type acc_type;
+
+public:
+    explicit FixedLU(const FixedMatrixN<N,N,Q>& a)
+        : m_lu(a), m_status(FIXED_SOLVE_OK), m_odd(false)
+    {
+        for (int i = 0; i < N; i++)
+            m_perm[i] = i;
+
+        for (int k = 0; k < N; k++)
+        {
+            /* Column k of L and the pivot, before dividing by the pivot */
+            for (int i = k; i < N; i++)
+            {
+                acc_type acc = Q::ToAccumulator(m_lu(i, k));
+                for (int m = 0; m < k; m++)
+                    Q::msub(acc, m_lu(i, m), m_lu(m, k));
+                m_lu(i, k) = Q::FromAccumulator(acc);
+            }
+
+            int p = k;
+            for (int i = k + 1; i < N; i++)
+                if (abs(m_lu(i, k)) > abs(m_lu(p, k)))
+                    p = i;
+            if (p != k)
+            {
+                for (int j = 0; j < N; j++)
+                {
+                    Q t = m_lu(p, j);
+                    m_lu(p, j) = m_lu(k, j);
+                    m_lu(k, j) = t;
+                }
+                int t = m_perm[p];
+                m_perm[p] = m_perm[k];
+                m_perm[k] = t;
+                m_odd = !m_odd;
+            }
+
+            if (m_lu(k, k) == Q::zero())
+            {
+                m_status = FIXED_SOLVE_SINGULAR;
+                return;
+            }
+            m_pivot[k] = FixedDivider<Q>(m_lu(k, k));
+            for (int i = k + 1; i < N; i++)
+                m_lu(i, k) = m_pivot[k].divide(m_lu(i, k));
+
+            /* Row k of U */
+            for (int j = k + 1; j < N; j++)
+            {
+                acc_type acc = Q::ToAccumulator(m_lu(k, j));
+                for (int m = 0; m < k; m++)
+                    Q::msub(acc, m_lu(k, m), m_lu(m, j));
+                m_lu(k, j) = Q::FromAccumulator(acc);
+            }
+        }
+    }
+
+    FixedSolveStatus status() const { return m_status; }
+
+    /*!\brief x = A^-1 b for each column of b. x may be b. */
+    template <int M> FixedSolveStatus solve(const FixedMatrixN<N,M,Q>& b, FixedMatrixN<N,M,Q>& x) const {
+        if (m_status != FIXED_SOLVE_OK)
+            return m_status;
+
+        for (int c = 0; c < M; c++)
+        {
+            Q y[N];
+            for (int i = 0; i < N; i++)
+            {
+                acc_type acc = Q::ToAccumulator(b(m_perm[i], c));
+                for (int m = 0; m < i; m++)
+                    Q::msub(acc, m_lu(i, m), y[m]);
+                y[i] = Q::FromAccumulator(acc);
+            }
+            for (int i = N - 1; i >= 0; i--)
+            {
+                acc_type acc = Q::ToAccumulator(y[i]);
+                for (int m = i + 1; m < N; m++)
+                    Q::msub(acc, m_lu(i, m), y[m]);
+                y[i] = m_pivot[i].divide(Q::FromAccumulator(acc));
+            }
+            for (int i = 0; i < N; i++)
+                x(i, c) = y[i];
+        }
+        return FIXED_SOLVE_OK;
+    }
+
+    /*!\brief r = A^-1 */
+    FixedSolveStatus inverse(FixedMatrixN<N,N,Q>& r) const {
+        return solve(FixedMatrixN<N,N,Q>::identity(), r);
+    }
+
+    /*!\brief The determinant, the product of the pivots. Zero if A is singular. */
+    Q det() const {
+        if (m_status != FIXED_SOLVE_OK)
+            return Q::zero();
+        Q d = m_lu(0, 0);
+        for (int k = 1; k < N; k++)
+        {
+            acc_type acc;
+            Q::mac(acc, d, m_lu(k, k));
+            d = Q::FromAccumulator(acc);
+        }
+        return m_odd ? -d : d;
+    }
+
+#ifdef IOSTREAMS
+    static void testharness();
+#endif
+
+private:
+    FixedMatrixN<N,N,Q> m_lu;   // L below the diagonal (its diagonal is 1), U on and above
+    FixedDivider<Q> m_pivot[N];
+    int m_perm[N];              // row i of LU is row m_perm[i] of A
+    FixedSolveStatus m_status;
+    bool m_odd;                 // an odd number of row swaps
+};
+
+/*!\brief The Cholesky decomposition A = L L^T of a symmetric positive
+    definite N x N matrix. Only the lower triangle of A is used.
+*/
+template <int N, class Q = Fixed16> class FixedCholesky
+{
+    typedef typename Q::product_type acc_type;
+
+    /* The pivots are the square roots of the f_int64 accumulators, read as raw f_int32 values */
+    static_assert(sizeof(typename Q::storage_type) == sizeof(f_int32), "FixedCholesky is for 32 bit Fixed formats");
+    static_assert(std::is_same<typename acc_type::storage_type, f_int64>::value, "FixedCholesky needs an f_int64 accumulator");
+
+public:
+    explicit FixedCholesky(const FixedMatrixN<N,N,Q>& a)
+        : m_status(FIXED_SOLVE_OK)
+    {
+        for (int j = 0; j < N; j++)
+        {
+            acc_type acc = Q::ToAccumulator(a(j, j));
+            for (int m = 0; m < j; m++)
+                Q::msub(acc, m_l(j, m), m_l(j, m));
+
+            f_uint32 d = (acc.Raw().GetHi() < 0) ? 0 : fixed_isqrt(f_uint64(acc.Raw()));
+            if (d == 0)
+            {
+                m_status = FIXED_SOLVE_NOT_POSITIVE_DEFINITE;
+                return;
+            }
+            m_l(j, j) = Q::FromRaw(f_int32(d));
+            m_pivot[j] = FixedDivider<Q>(m_l(j, j));
+
+            for (int i = j + 1; i < N; i++)
+            {
+                acc = Q::ToAccumulator(a(i, j));
+                for (int m = 0; m < j; m++)
+                    Q::msub(acc, m_l(i, m), m_l(j, m));
+                m_l(i, j) = m_pivot[j].divide(Q::FromAccumulator(acc));
+            }
+        }
+    }
+
+    FixedSolveStatus status() const { return m_status; }
+
+    /*!\brief The lower triangular factor L */
+    const FixedMatrixN<N,N,Q>& L() const { return m_l; }
+
+    /*!\brief x = A^-1 b for each column of b. x may be b. */
+    template <int M> FixedSolveStatus solve(const FixedMatrixN<N,M,Q>& b, FixedMatrixN<N,M,Q>& x) const {
+        if (m_status != FIXED_SOLVE_OK)
+            return m_status;
+
+        for (int c = 0; c < M; c++)
+        {
+            Q y[N];
+            for (int i = 0; i < N; i++)
+            {
+                acc_type acc = Q::ToAccumulator(b(i, c));
+                for (int m = 0; m < i; m++)
+                    Q::msub(acc, m_l(i, m), y[m]);
+                y[i] = m_pivot[i].divide(Q::FromAccumulator(acc));
+            }
+            for (int i = N - 1; i >= 0; i--)
+            {
+                acc_type acc = Q::ToAccumulator(y[i]);
+                for (int m = i + 1; m < N; m++)
+                    Q::msub(acc, m_l(m, i), y[m]);
+                y[i] = m_pivot[i].divide(Q::FromAccumulator(acc));
+            }
+            for (int i = 0; i < N; i++)
+                x(i, c) = y[i];
+        }
+        return FIXED_SOLVE_OK;
+    }
+
+    /*!\brief r = A^-1 */
+    FixedSolveStatus inverse(FixedMatrixN<N,N,Q>& r) const {
+        return solve(FixedMatrixN<N,N,Q>::identity(), r);
+    }
+
+private:
+    FixedMatrixN<N,N,Q> m_l;
+    FixedDivider<Q> m_pivot[N];
+    FixedSolveStatus m_status;
+};
+
+/*!\brief x = A^-1 b by LU decomposition. x may be b. */
+template <int N, int M, class Q>
+FixedSolveStatus solve(const FixedMatrixN<N,N,Q>& a, const FixedMatrixN<N,M,Q>& b, FixedMatrixN<N,M,Q>& x)
+{
+    return FixedLU<N,Q>(a).solve(b, x);
+}
+
+/*!\brief x = A^-1 b by Cholesky decomposition, for symmetric positive definite A. x may be b. */
+template <int N, int M, class Q>
+FixedSolveStatus solve_spd(const FixedMatrixN<N,N,Q>& a, const FixedMatrixN<N,M,Q>& b, FixedMatrixN<N,M,Q>& x)
+{
+    return FixedCholesky<N,Q>(a).solve(b, x);
+}
+
+/*!\brief r = A^-1 by LU decomposition. r is left alone if A is singular. */
+template <int N, class Q>
+FixedSolveStatus inv(const FixedMatrixN<N,N,Q>& a, FixedMatrixN<N,N,Q>& r)
+{
+    return FixedLU<N,Q>(a).inverse(r);
+}
+
+#ifdef IOSTREAMS
+template <int N, class Q> void FixedLU<N,Q>::testharness()
+{
+    cout << "FixedLU<" << N << "> and FixedCholesky<" << N << "> testharness" << endl;
+
+    /*
+        A = B B^T + N I is symmetric, and its smallest eigenvalue is at least
+        N, so the elements of its inverse are at most 1/N
+    */
+    FixedMatrixN<N,N,Q> b;
+    f_uint32 seed = 54321;
+    test_fill(b.data(), N*N, seed, 31 - Q::frac_bits);
+    FixedMatrixN<N,N,Q> a = b * trans(b);
+    for (int i = 0; i < N; i++)
+        a(i, i) = a(i, i) + Q(N);
+
+    FixedMatrixN<N,1,Q> x_true;
+    for (int i = 0; i < N; i++)
+        x_true(i, 0) = Q::FromRaw(f_int32((i * 40503) & 0x1FFFF) - 0x10000);
+    FixedMatrixN<N,1,Q> rhs = a * x_true;
+
+    /* The residual of each solution against the right hand side, in PRECISION() units */
+    FixedMatrixN<N,1,Q> x;
+    test_result("solve() status", int(::solve(a, rhs, x)), int(FIXED_SOLVE_OK));
+    FixedMatrixN<N,1,Q> r = a * x - rhs;
+    f_int32 worst = 0;
+    for (int i = 0; i < N; i++)
+        if (abs(r(i, 0).Raw()) > worst) worst = abs(r(i, 0).Raw());
+    test_result("LU residual (LSB)", worst, 0, f_int32(4*N));
+
+    test_result("solve_spd() status", int(solve_spd(a, rhs, x)), int(FIXED_SOLVE_OK));
+    r = a * x - rhs;
+    worst = 0;
+    for (int i = 0; i < N; i++)
+        if (abs(r(i, 0).Raw()) > worst) worst = abs(r(i, 0).Raw());
+    test_result("Cholesky residual (LSB)", worst, 0, f_int32(4*N));
+
+    /* L L^T gives back A */
+    FixedCholesky<N,Q> chol(a);
+    FixedMatrixN<N,N,Q> llt = chol.L() * trans(chol.L());
+    worst = 0;
+    for (int i = 0; i < N*N; i++)
+        if (abs((llt.data()[i] - a.data()[i]).Raw()) > worst) worst = abs((llt.data()[i] - a.data()[i]).Raw());
+    test_result("L L^T - A (LSB)", worst, 0, f_int32(2*N));
+
+    /* A A^-1 is the identity */
+    FixedMatrixN<N,N,Q> ainv;
+    test_result("inv() status", int(inv(a, ainv)), int(FIXED_SOLVE_OK));
+    FixedMatrixN<N,N,Q> e = a * ainv - FixedMatrixN<N,N,Q>::identity();
+    worst = 0;
+    for (int i = 0; i < N*N; i++)
+        if (abs(e.data()[i].Raw()) > worst) worst = abs(e.data()[i].Raw());
+    test_result("A inv(A) - I (LSB)", worst, 0, f_int32(4*N));
+
+    /* A needs row swaps, and its determinant is known */
+    FixedMatrixN<N,N,Q> p;
+    f_int32 product = 1;
+    for (int i = 0; i < N; i++)
+    {
+        p(i, (i + 1) % N) = Q(1 + (i & 1));
+        product *= 1 + (i & 1);
+    }
+    FixedLU<N,Q> lu(p);
+    /* A cyclic shift of N rows is N-1 swaps */
+    test_result("det(permutation)", lu.det(), Q((N % 2) ? product : -product));
+    FixedMatrixN<N,N,Q> ident;
+    lu.solve(p, ident);
+    test_result("solve(P, P) mismatches", test_mismatches(ident.data(), FixedMatrixN<N,N,Q>::identity().data(), N*N), 0);
+
+    /* Singular and indefinite matrices are reported, not thrown */
+    FixedMatrixN<N,N,Q> z = a;
+    for (int j = 0; j < N; j++)
+        z(N - 1, j) = z(0, j);
+    test_result("singular status", int(FixedLU<N,Q>(z).status()), int(FIXED_SOLVE_SINGULAR));
+    test_result("singular inv() status", int(inv(z, ainv)), int(FIXED_SOLVE_SINGULAR));
+    test_result("indefinite status", int(FixedCholesky<N,Q>(FixedMatrixN<N,N,Q>() - a).status()), int(FIXED_SOLVE_NOT_POSITIVE_DEFINITE));
+}
+#endif
+
+#endif /* __FixedSolve__ */
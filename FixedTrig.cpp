@@ -0,0 +1,365 @@
+/*
+FixedTrig.cpp. Table-driven trigonometry for the Fixed16 class.
+
+Copyright (C) 2005-2006  Tim Molteno tim@physics.otago.ac.nz
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+#include "FixedTrig.h"
+
+#if !defined(FIXED_NO_SIMD) && defined(__AVX2__)
+    #define FIXED_TRIG_AVX2
+    #include <immintrin.h>
+#endif
+
+static constexpr fixed_trig_table<FIXED_TRIG_LUT_BITS> trig_table = fixed_trig_table<FIXED_TRIG_LUT_BITS>();
+
+static const int LUT_BITS = FIXED_TRIG_LUT_BITS;
+
+/* The end of the table, as a Q16 position */
+static const f_uint32 LUT_END = f_uint32(1) << (LUT_BITS + 16);
+
+/* 2/PI in Q30 and 4/PI in Q29 */
+static const f_int32 TWO_OVER_PI_Q30 = 683565276;
+static const f_int32 FOUR_OVER_PI_Q29 = 683565276;
+
+/*!\brief The low 32 bits of p >> n, for 0 < n < 32
+*/
+static inline f_uint32 shr32(const f_int64& p, int n)
+{
+    return (f_uint32(p.GetHi()) << (32 - n)) | (p.GetLo() >> n);
+}
+
+/*!\brief Interpolate linearly in table at the Q16 position pos
+*/
+static inline f_int32 interpolate(const f_int32* table, f_uint32 pos)
+{
+    f_uint32 i = pos >> 16;
+    f_int32 t = f_int32(pos & 0xFFFF);
+    return table[i] + (((table[i + 1] - table[i]) * t + 0x8000) >> 16);
+}
+
+/*!\brief Split the angle x into a quadrant (0..3) and the Q16 position
+    within the quarter-wave table. Any angle can be reduced this way.
+*/
+static inline void quarter_wave(const Fixed16& x, f_int32& quadrant, f_uint32& pos)
+{
+    f_int64 p = f_int64::mult32(x.Raw(), TWO_OVER_PI_Q30);  // quarter waves in Q46
+    quadrant = (p.GetHi() >> 14) & 3;
+    pos = shr32(p, 14) >> (16 - LUT_BITS);
+}
+
+/*!\brief sin() at a position in the quarter-wave table, mirrored into the given quadrant
+*/
+static inline f_int32 sin_quadrant(f_int32 quadrant, f_uint32 pos)
+{
+    f_int32 s = interpolate(trig_table.sin, (quadrant & 1) ? LUT_END - pos : pos);
+    return (quadrant & 2) ? -s : s;
+}
+
+/*!\brief Calculate sin(x) by table lookup, x in radians (any value)
+*/
+Fixed16 sin_lut(const Fixed16& x)
+{
+    f_int32 quadrant;
+    f_uint32 pos;
+    quarter_wave(x, quadrant, pos);
+    return Fixed16::FromRaw(sin_quadrant(quadrant, pos));
+}
+
+/*!\brief Calculate cos(x) by table lookup, x in radians (any value)
+*/
+Fixed16 cos_lut(const Fixed16& x)
+{
+    f_int32 quadrant;
+    f_uint32 pos;
+    quarter_wave(x, quadrant, pos);
+    return Fixed16::FromRaw(sin_quadrant(quadrant + 1, pos));
+}
+
+/*!\brief Calculate sin(x) and cos(x) by table lookup, sharing the range reduction
+*/
+void sincos_lut(const Fixed16& x, Fixed16& s, Fixed16& c)
+{
+    f_int32 quadrant;
+    f_uint32 pos;
+    quarter_wave(x, quadrant, pos);
+    s = Fixed16::FromRaw(sin_quadrant(quadrant, pos));
+    c = Fixed16::FromRaw(sin_quadrant(quadrant + 1, pos));
+}
+
+/*!\brief Split a phase into a quadrant (0..3) and the Q16 position within
+    the quarter-wave table. A whole turn is 2^32, so this is just bit fields.
+*/
+static inline void quarter_turn(f_uint32 phase, f_int32& quadrant, f_uint32& pos)
+{
+    quadrant = f_int32(phase >> 30);
+    pos = (phase & 0x3FFFFFFF) >> (14 - LUT_BITS);
+}
+
+/*!\brief Calculate sin() of a phase by table lookup, 2^32 to a turn
+*/
+Fixed16 sin_turns(f_uint32 phase)
+{
+    f_int32 quadrant;
+    f_uint32 pos;
+    quarter_turn(phase, quadrant, pos);
+    return Fixed16::FromRaw(sin_quadrant(quadrant, pos));
+}
+
+/*!\brief Calculate cos() of a phase by table lookup, 2^32 to a turn
+*/
+Fixed16 cos_turns(f_uint32 phase)
+{
+    f_int32 quadrant;
+    f_uint32 pos;
+    quarter_turn(phase, quadrant, pos);
+    return Fixed16::FromRaw(sin_quadrant(quadrant + 1, pos));
+}
+
+/*!\brief Calculate sin() and cos() of a phase by table lookup, 2^32 to a turn
+*/
+void sincos_turns(f_uint32 phase, Fixed16& s, Fixed16& c)
+{
+    f_int32 quadrant;
+    f_uint32 pos;
+    quarter_turn(phase, quadrant, pos);
+    s = Fixed16::FromRaw(sin_quadrant(quadrant, pos));
+    c = Fixed16::FromRaw(sin_quadrant(quadrant + 1, pos));
+}
+
+#if defined(FIXED_TRIG_AVX2)
+/*!\brief sin_quadrant() of eight lanes, with two gathers for the interpolation
+*/
+static inline __m256i sin_quadrant_lanes(__m256i quadrant, __m256i pos)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+
+    /* Odd quadrants run back down the table, and the last two are negative */
+    __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one);
+    pos = _mm256_blendv_epi8(pos, _mm256_sub_epi32(_mm256_set1_epi32(LUT_END), pos), odd);
+
+    __m256i i = _mm256_srli_epi32(pos, 16);
+    __m256i t = _mm256_and_si256(pos, _mm256_set1_epi32(0xFFFF));
+    __m256i a = _mm256_i32gather_epi32((const int*)trig_table.sin, i, 4);
+    __m256i b = _mm256_i32gather_epi32((const int*)trig_table.sin + 1, i, 4);
+    __m256i d = _mm256_mullo_epi32(_mm256_sub_epi32(b, a), t);
+    __m256i s = _mm256_add_epi32(a, _mm256_srai_epi32(_mm256_add_epi32(d, _mm256_set1_epi32(0x8000)), 16));
+
+    __m256i negative = _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, two), two);
+    return _mm256_sub_epi32(_mm256_xor_si256(s, negative), negative);
+}
+#endif
+
+/*!\brief Calculate sin() and cos() of n phases by table lookup, 2^32 to a turn
+*/
+void sincos_turns(const f_uint32* phase, Fixed16* s, Fixed16* c, size_t n)
+{
+    static_assert(sizeof(Fixed16) == sizeof(f_int32), "Fixed16 must be a bare f_int32");
+
+    size_t i = 0;
+#if defined(FIXED_TRIG_AVX2)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(phase + i));
+        __m256i quadrant = _mm256_srli_epi32(p, 30);
+        __m256i pos = _mm256_srli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0x3FFFFFFF)), 14 - LUT_BITS);
+        if (s)
+            _mm256_storeu_si256((__m256i*)(s + i), sin_quadrant_lanes(quadrant, pos));
+        if (c)
+            _mm256_storeu_si256((__m256i*)(c + i), sin_quadrant_lanes(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), pos));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        f_int32 quadrant;
+        f_uint32 pos;
+        quarter_turn(phase[i], quadrant, pos);
+        if (s)
+            s[i] = Fixed16::FromRaw(sin_quadrant(quadrant, pos));
+        if (c)
+            c[i] = Fixed16::FromRaw(sin_quadrant(quadrant + 1, pos));
+    }
+}
+
+const char* fixed_trig_kernel()
+{
+#if defined(FIXED_TRIG_AVX2)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+/*!\brief Calculate tan(x) by table lookup, x in radians (-PI/4 <= x <= PI/4)
+*/
+Fixed16 tan_lut(const Fixed16& x)
+{
+#ifdef IOSTREAMS
+    double xd = x.toDouble();
+    if ((xd > 3.15/4) || (xd < -3.15/4))
+    {
+        cerr << "Fixed16::tan_lut(" << xd << ") out of range" << endl;
+        throw -1;
+    }
+#endif
+    f_int32 raw = x.Raw();
+    f_int64 p = f_int64::mult32((raw < 0) ? -raw : raw, FOUR_OVER_PI_Q29);   // eighth waves in Q45
+    f_uint32 pos = shr32(p, 29 - LUT_BITS);
+    if (pos > LUT_END)
+        pos = LUT_END;
+
+    f_int32 t = interpolate(trig_table.tan, pos);
+    return Fixed16::FromRaw((raw < 0) ? -t : t);
+}
+
+
+#ifdef IOSTREAMS
+
+/*!\brief Check that sincos_fn gives the same bits as sin_fn and cos_fn over [from, to]
+*/
+static f_int32 sincos_mismatches(void (*sincos_fn)(const Fixed16&, Fixed16&, Fixed16&),
+                Fixed16 (*sin_fn)(const Fixed16&), Fixed16 (*cos_fn)(const Fixed16&), double from, double to)
+{
+    f_int32 mismatches = 0;
+    for (f_int32 raw = Fixed16::FromDouble(from).Raw(); raw <= Fixed16::FromDouble(to).Raw(); raw += 3)
+    {
+        Fixed16 x = Fixed16::FromRaw(raw);
+        Fixed16 s, c;
+        sincos_fn(x, s, c);
+        if ((s != sin_fn(x)) || (c != cos_fn(x)))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+/*!\brief The largest error of f over [from, to], in units of Fixed16::PRECISION()
+*/
+static f_int32 max_error(Fixed16 (*f)(const Fixed16&), double (*ref)(double), double from, double to)
+{
+    f_int32 worst = 0;
+    for (f_int32 raw = Fixed16::FromDouble(from).Raw(); raw <= Fixed16::FromDouble(to).Raw(); raw += 3)
+    {
+        Fixed16 x = Fixed16::FromRaw(raw);
+        f_int32 err = f(x).Raw() - f_int32(floor(ref(x.toDouble()) * 65536.0 + 0.5));
+        if (err < 0)
+            err = -err;
+        if (err > worst)
+            worst = err;
+    }
+    return worst;
+}
+
+/*!\brief The largest error of sin_turns() and cos_turns() over phases a stride apart,
+    and the number of them that sincos_turns(), one at a time or a block at a time, does not match
+*/
+static void turns_errors(f_uint32 stride, f_int32& worst, f_int32& mismatches)
+{
+    const double pi = 3.14159265358979323846;
+    const size_t block = 37;    // not a multiple of a register
+    f_uint32 phase[block];
+    Fixed16 s[block], c[block];
+
+    worst = 0;
+    mismatches = 0;
+    f_uint32 p = 12345;
+    for (long k = 0; k < 2000; k++)
+    {
+        for (size_t i = 0; i < block; i++, p += stride)
+            phase[i] = p;
+        sincos_turns(phase, s, c, block);
+        for (size_t i = 0; i < block; i++)
+        {
+            double x = 2 * pi * (phase[i] / 4294967296.0);
+            Fixed16 s1, c1;
+            sincos_turns(phase[i], s1, c1);
+            if ((s1 != s[i]) || (c1 != c[i]) || (s1 != sin_turns(phase[i])) || (c1 != cos_turns(phase[i])))
+                mismatches++;
+
+            f_int32 es = std::abs(s1.Raw() - f_int32(floor(std::sin(x) * 65536.0 + 0.5)));
+            f_int32 ec = std::abs(c1.Raw() - f_int32(floor(std::cos(x) * 65536.0 + 0.5)));
+            if (es > worst) worst = es;
+            if (ec > worst) worst = ec;
+        }
+    }
+}
+
+static double std_sin(double x) { return std::sin(x); }
+static double std_cos(double x) { return std::cos(x); }
+static double std_tan(double x) { return std::tan(x); }
+
+void FixedTrig::testharness()
+{
+    cout << "FixedTrig testharness (" << (1 << LUT_BITS) << " entry tables, " << fixed_trig_kernel() << ")" << endl;
+
+    static_assert(trig_table.sin[0] == 0, "sin(0)");
+    static_assert(trig_table.sin[1 << LUT_BITS] == 65536, "sin(PI/2)");
+    static_assert(trig_table.tan[1 << LUT_BITS] == 65536, "tan(PI/4)");
+
+    const double pi = 3.14159265358979323846;
+
+    test_result("sin_lut(0)", sin_lut(Fixed16::zero()), Fixed16::zero());
+    test_result("sin_lut(PI/2)", sin_lut(Fixed16::PI_OVER_2()), Fixed16::one());
+    test_result("cos_lut(0)", cos_lut(Fixed16::zero()), Fixed16::one());
+    test_result("cos_lut(PI)", cos_lut(Fixed16::PI()), -Fixed16::one());
+    test_result("sin_lut(-PI/2)", sin_lut(-Fixed16::PI_OVER_2()), -Fixed16::one());
+
+    /*
+        Linear interpolation is out by at most h^2/8 max|f''|, plus the rounding
+        of the table. For sin, h = PI/2 / 2^BITS and max|f''| = 1. For tan, h is
+        half that and max|f''| = 4, which gives the same bound.
+    */
+    double h = pi / 2 / (1 << LUT_BITS);
+    f_int32 lut_bound = 2 + f_int32(65536.0 * h * h / 8);
+
+    test_result("sin_lut(100)", sin_lut(Fixed16(100)), Fixed16::FromDouble(std::sin(100.0)), Fixed16::FromRaw(lut_bound));
+
+    test_result("sin_lut error", max_error(sin_lut, std_sin, -2 * pi, 2 * pi), 0, lut_bound);
+    test_result("cos_lut error", max_error(cos_lut, std_cos, -2 * pi, 2 * pi), 0, lut_bound);
+    test_result("tan_lut error", max_error(tan_lut, std_tan, -pi / 4, pi / 4), 0, lut_bound);
+
+    test_result("sincos_lut == sin_lut, cos_lut", sincos_mismatches(sincos_lut, sin_lut, cos_lut, -2 * pi, 2 * pi), 0);
+    test_result("sin_turns(quarter turn)", sin_turns(0x40000000), Fixed16::one());
+    test_result("cos_turns(half turn)", cos_turns(0x80000000), -Fixed16::one());
+    test_result("sin_turns(three quarter turns)", sin_turns(0xC0000000), -Fixed16::one());
+
+    f_int32 worst, mismatches;
+    turns_errors(58301, worst, mismatches);      // once round, in small steps
+    test_result("sincos_turns mismatches", mismatches, 0);
+    test_result("sin_turns, cos_turns error", worst, 0, lut_bound);
+    turns_errors(0x9E3779B9, worst, mismatches); // all over the circle
+    test_result("sincos_turns mismatches, scattered", mismatches, 0);
+    test_result("sin_turns, cos_turns error, scattered", worst, 0, lut_bound);
+
+    test_result("sincos_poly == sin_poly, cos_poly", sincos_mismatches(sincos_poly, sin_poly, cos_poly, -6.28, 6.28), 0);
+
+    /* The polynomial versions, to compare against */
+    test_result("sin_poly error", max_error(sin_poly, std_sin, -6.28, 6.28), 0, 24);
+    test_result("cos_poly error", max_error(cos_poly, std_cos, -2 * pi, 2 * pi), 0, 96);
+    test_result("tan_poly error", max_error(tan_poly, std_tan, 0, pi / 4), 0, 64);
+}
+
+#endif /* IOSTREAMS */
@@ -0,0 +1,153 @@
+#ifndef __FixedTrig_h__
+#define __FixedTrig_h__
+/*
+FixedTrig.h. Table-driven trigonometry for the Fixed16 class.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the lookup table trigonometry
+
+Fixed16 s = sin_lut(x);     // always the table
+Fixed16 c = cos_poly(x);    // always the polynomial
+Fixed16 t = tan(x);         // the table if FIXED_TRIG_LUT is defined
+sincos(x, s, c);            // both at once, for the cost of about one
+
+f_uint32 phase = 0x40000000;            // a quarter turn, 2^32 is a whole one
+s = sin_turns(phase);                   // the same tables, with no range reduction
+sincos_turns(phases, s_out, c_out, n);  // n phases at once (AVX2 when targeted)
+
+sin_lut() and cos_lut() look up a quarter-wave table of
+2^FIXED_TRIG_LUT_BITS + 1 entries and interpolate linearly between them.
+They accept any Fixed16 angle. tan_lut() uses an eighth-wave table of tan()
+of the same size and, like tan(), expects -PI/4 <= x <= PI/4.
+
+The _turns functions take the angle as a phase that wraps at a whole turn,
+as a phase accumulator does (see FixedNco). The top two bits are the
+quadrant and the rest the position in the table, so they need neither a
+multiply nor a range check. The block version looks up each register of
+eight phases with AVX2 gathers when the compiler targets AVX2 (and
+FIXED_NO_SIMD is not defined), and gives the same bits as the others.
+
+The tables are computed by the compiler, and take 2 * 4 * (2^BITS + 2)
+bytes of read-only memory. The worst error found by FixedTrig::testharness()
+over a sweep of the whole range, in units of Fixed16::PRECISION() (1/65536):
+
+                      sin     cos     tan
+    polynomial        20      80      52
+    table, BITS=6      6       6       5
+    table, BITS=8      1       1       1    (the default)
+    table, BITS=10     1       1       1
+*/
+
+#include <stddef.h>
+
+#include "Fixed.h"
+
+/* Size of the tables, 2^FIXED_TRIG_LUT_BITS intervals per quarter (or eighth) wave */
+#ifndef FIXED_TRIG_LUT_BITS
+    #define FIXED_TRIG_LUT_BITS 8
+#endif
+
+/*!\brief Quarter-wave sin() and eighth-wave tan() tables in Q16, built at compile time.
+
+* sin[i] = sin(i * PI/2 / 2^Bits) and tan[i] = tan(i * PI/4 / 2^Bits) for
+* 0 <= i <= 2^Bits, plus one entry past the end so that interpolating at the
+* last point never reads outside the table.
+*/
+template <int Bits> struct fixed_trig_table
+{
+    static_assert(Bits >= 2 && Bits <= 14, "FIXED_TRIG_LUT_BITS must be between 2 and 14");
+
+    static const int size = 1 << Bits;
+
+    f_int32 sin[size + 2];
+    f_int32 tan[size + 2];
+
+    constexpr fixed_trig_table() : sin(), tan() {
+        const double pi = 3.14159265358979323846;
+        for (int i = 0; i < size + 2; i++)
+        {
+            double s = series_sin(i * pi / (2 * size));
+            sin[i] = f_int32(s * 65536.0 + 0.5);
+            double st = series_sin(i * pi / (4 * size));
+            double ct = series_sin(pi / 2 - i * pi / (4 * size));
+            tan[i] = f_int32(st / ct * 65536.0 + 0.5);
+        }
+    }
+
+private:
+    /* sin(x) by its Taylor series, which is accurate to double precision for |x| < PI/2 + PI/8 */
+    static constexpr double series_sin(double x) {
+        double term = x;
+        double sum = x;
+        for (int n = 1; n < 16; n++)
+        {
+            term *= -x * x / ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+};
+
+/* Trigonometry by table lookup and linear interpolation */
+Fixed16 sin_lut(const Fixed16& x);
+Fixed16 cos_lut(const Fixed16& x);
+Fixed16 tan_lut(const Fixed16& x);
+void sincos_lut(const Fixed16& x, Fixed16& s, Fixed16& c);
+
+/* Trigonometry by table lookup of a phase in turns, 2^32 to a turn */
+Fixed16 sin_turns(f_uint32 phase);
+Fixed16 cos_turns(f_uint32 phase);
+void sincos_turns(f_uint32 phase, Fixed16& s, Fixed16& c);
+
+/*!\brief s[i] = sin_turns(phase[i]) and c[i] = cos_turns(phase[i]) for i < n.
+    Either s or c may be null.
+*/
+void sincos_turns(const f_uint32* phase, Fixed16* s, Fixed16* c, size_t n);
+
+/*!\brief The instruction set the block sincos_turns() was built for: "avx2" or "scalar"
+*/
+const char* fixed_trig_kernel();
+
+/* Trigonometry by polynomial approximation */
+Fixed16 sin_poly(const Fixed16& x);
+Fixed16 cos_poly(const Fixed16& x);
+Fixed16 tan_poly(const Fixed16& x);
+void sincos_poly(const Fixed16& x, Fixed16& s, Fixed16& c);
+
+#ifdef IOSTREAMS
+/*!\brief Tests of the table-driven and polynomial trigonometry.
+*/
+class FixedTrig
+{
+public:
+    static void testharness();
+};
+#endif
+
+#endif /* __FixedTrig_h__ */
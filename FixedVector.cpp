@@ -60,7 +60,9 @@ bool FixedVector::testharness()
 		FixedVector mag_field(23,45,67);
 		cout << "mag_field " << mag_field << endl;
 
-		mag_field = mag_field / Fixed16(10);
+		mag_field = div_by<10>(mag_field);
+		test_result("div_by<10>(FixedVector).x", mag_field.x, Fixed16::FromRaw(150732));
+		test_result("div_by<10>(FixedVector).z", mag_field.z, Fixed16::FromRaw(439091));
 
 		UnitVector u(mag_field);
 
@@ -70,6 +72,61 @@ bool FixedVector::testharness()
 		cout << "UnitVector(mag_field) " << UnitVector(mag_field) << endl;
 		cout << "norm(UnitVector(mag_field)) " << norm(UnitVector(mag_field)) << endl;
 	}
+
+	/* The norms of vectors too long for norm2(), and of very short ones */
+	FixedVector big(105,105,105);
+	test_result("norm2_wide(105,105,105)", norm2_wide(big), Fixed32(33075));
+	test_result("norm(105,105,105)", norm(big), Fixed16::FromRaw(11918727));
+	test_result("norm(3,4,12)", norm(FixedVector(3,4,12)), Fixed16(13));
+	test_result("norm(tiny)", norm(FixedVector(Fixed16::FromRaw(3), Fixed16::FromRaw(4), Fixed16::zero())), Fixed16::FromRaw(5));
+	test_result("normalise(0,0,0)", normalise(FixedVector()).x, Fixed16::zero());
+
+	/* The longest vectors, whose squares would overflow the sum */
+	const f_int32 longest[][3] = {
+		{ 32767, 32767, 32767 }, { -32768, -32768, -32768 }, { 27000, 27000, 27000 },
+		{ 32767, -32768, 1 }, { -32768, 0, 0 }, { 16384, -16384, 3 }, { 0, 0, -32767 }
+	};
+	double worst_long = 0;
+	for (size_t i = 0; i < sizeof(longest) / sizeof(longest[0]); i++)
+	{
+		const f_int32* c = longest[i];
+		FixedVector u = normalise(FixedVector(Fixed16(c[0]), Fixed16(c[1]), Fixed16(c[2])));
+		double len = std::sqrt(double(c[0]) * c[0] + double(c[1]) * c[1] + double(c[2]) * c[2]);
+		Fixed16 uc[3] = { u.x, u.y, u.z };
+		for (int k = 0; k < 3; k++)
+		{
+			double e = std::fabs(uc[k].Raw() - c[k] / len * 65536.0);
+			if (e > worst_long) worst_long = e;
+		}
+	}
+	test_result("normalise() error, longest vectors (LSB)", worst_long, 0.0, 0.51);
+
+	/* normalise() against the true unit vector, over every length */
+	double worst = 0;
+	f_uint32 seed = 2468;
+	for (int i = 0; i < 3000; i++)
+	{
+		f_int32 c[3];
+		int size = 1 + i % 32;
+		for (int k = 0; k < 3; k++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			c[k] = f_int32(seed) >> (32 - size);
+		}
+		FixedVector v(Fixed16::FromRaw(c[0]), Fixed16::FromRaw(c[1]), Fixed16::FromRaw(c[2]));
+		double len = std::sqrt(double(c[0]) * c[0] + double(c[1]) * c[1] + double(c[2]) * c[2]);
+		if (len == 0)
+			continue;
+		FixedVector u = normalise(v);
+		Fixed16 uc[3] = { u.x, u.y, u.z };
+		for (int k = 0; k < 3; k++)
+		{
+			double e = std::fabs(uc[k].Raw() - c[k] / len * 65536.0);
+			if (e > worst) worst = e;
+		}
+	}
+	test_result("normalise() error (LSB)", worst, 0.0, 0.51);
+
 	cout << endl << "FixedVector TestHarness Complete" << endl << endl;
 	return true;
 }
@@ -88,11 +145,16 @@ FixedVector operator+(const FixedVector& a, const FixedVector& b)
 	return FixedVector(a.x + b.x, a.y + b.y, a.z + b.z);
 }
 
-FixedVector operator/(const FixedVector& a, const Fixed16& b)
+FixedVector operator/(const FixedVector& a, const Fixed16Divider& b)
 {
 	return FixedVector(a.x / b, a.y / b, a.z / b);
 }
 
+FixedVector operator/(const FixedVector& a, const Fixed16& b)
+{
+	return a / Fixed16Divider(b);
+}
+
 FixedVector operator*(const FixedVector& a, const Fixed16& b)
 {
 	return FixedVector(a.x * b, a.y * b, a.z * b);
@@ -106,12 +168,23 @@ FixedVector operator-(const FixedVector& a, const FixedVector& b)
 
 Fixed16 dot(const FixedVector& a, const FixedVector& b)
 {
-	return Fixed16::FromFixed32(a.x*b.x + a.y*b.y + a.z*b.z);
+	Fixed32 acc;
+	Fixed16::mac(acc, a.x, b.x);
+	Fixed16::mac(acc, a.y, b.y);
+	Fixed16::mac(acc, a.z, b.z);
+	return Fixed16::FromAccumulator(acc);
 }
 
 FixedVector cross(const FixedVector& u, const FixedVector& v)
 {
-	return FixedVector(u.y*v.z - u.z*v.y, u.z*v.x - u.x*v.z, u.x*v.y - u.y*v.x);
+	Fixed32 x, y, z;
+	Fixed16::mac(x, u.y, v.z);
+	Fixed16::msub(x, u.z, v.y);
+	Fixed16::mac(y, u.z, v.x);
+	Fixed16::msub(y, u.x, v.z);
+	Fixed16::mac(z, u.x, v.y);
+	Fixed16::msub(z, u.y, v.x);
+	return FixedVector(Fixed16::FromAccumulator(x), Fixed16::FromAccumulator(y), Fixed16::FromAccumulator(z));
 }
 
 
@@ -119,16 +192,25 @@ FixedVector cross(const FixedVector& u, const FixedVector& v)
 warning the dot product will easily overflow when converted back from Fixed32 to Fixed16 giving spurious results
 eg norm2(105,105,105) -> 33075
 
-Scale vector before taking the norm2 if appropriate
+Use norm2_wide(), which keeps the whole sum, if the vector may be that long
 */
 Fixed16 norm2(const FixedVector& a)
 {
 	return dot(a,a);
 }
 
+Fixed32 norm2_wide(const FixedVector& a)
+{
+	Fixed32 acc;
+	Fixed16::mac(acc, a.x, a.x);
+	Fixed16::mac(acc, a.y, a.y);
+	Fixed16::mac(acc, a.z, a.z);
+	return acc;
+}
+
 Fixed16 norm(const FixedVector& a)
 {
-	return sqrt(norm2(a));
+	return sqrt(norm2_wide(a));
 }
 
 /*!\brief Return the max element of a vector
@@ -157,11 +239,62 @@ Fixed16 maxElement(const FixedVector& v)
     }
 }
 
+/* A component of 16384 or more in size could overflow the sum of squares */
+static bool too_long(const Fixed16& x)
+{
+	return (x.Raw() >= (f_int32(1) << 30)) || (x.Raw() <= -(f_int32(1) << 30));
+}
+
+static bool too_long(const FixedVector& v)
+{
+	return too_long(v.x) || too_long(v.y) || too_long(v.z);
+}
+
+/* x * r * 2^-n rounded half up, where r is in Q30 and 14 <= n <= 47 */
+static Fixed16 scale_q30(const Fixed16& x, f_int32 r, int n)
+{
+	f_int64 p = f_int64::mult32(x.Raw(), r) + (f_int64(1) << (n - 1));
+	return Fixed16::FromRaw((p >> n).toInt32());
+}
+
+/* v / (sqrt(n2) * 2^extra), or zero if n2 is zero */
+static FixedVector scale_unit(const FixedVector& v, const Fixed32& n2, int extra)
+{
+	if (n2.Raw() <= f_int64(0))
+		return FixedVector();
+
+	int shift;
+	f_int32 r = invsqrt_wide(n2, shift);
+	int n = 30 - shift + extra;
+	return FixedVector(scale_q30(v.x, r, n), scale_q30(v.y, r, n), scale_q30(v.z, r, n));
+}
+
+/*!\brief Return a unit vector in the direction of v
+
+	The exact sum of squares goes to invsqrt_wide() once, which scales it by
+	the leading zeros of all 64 bits, so there is no division. Each component
+	is then multiplied by 1/norm(v) in Q30 and rounded once, to within a
+	little over half a PRECISION() of the true unit vector.
+
+	The squares of three components of 16384 or more could overflow the sum,
+	so for those vectors it is taken of v/4 instead, and 1/norm(v) is a
+	quarter of 1/norm(v/4). The components of v itself are still scaled.
+*/
 FixedVector normalise(const FixedVector& v)
 {
-    FixedVector ret = v / maxElement(v);
-    ret = ret * invsqrt(norm2(ret));
-    return ret; 
+	if (too_long(v))
+	{
+		FixedVector quarter(v.x >> 2, v.y >> 2, v.z >> 2);
+		return scale_unit(v, norm2_wide(quarter), 2);
+	}
+	return scale_unit(v, norm2_wide(v), 0);
+}
+
+FixedVector normalise(const FixedVector& v, const Fixed32& n2)
+{
+	if (too_long(v))
+		return normalise(v);
+	return scale_unit(v, n2, 0);
 }
 
 /*!\brief Return the angle in radians between two vectors
@@ -82,6 +82,14 @@ FixedVector operator+(const FixedVector& a, const FixedVector& b);
 FixedVector operator-(const FixedVector& a, const FixedVector& b);
 FixedVector operator*(const FixedVector& a, const Fixed16& b);
 FixedVector operator/(const FixedVector& a, const Fixed16& b);
+FixedVector operator/(const FixedVector& a, const Fixed16Divider& b);
+
+/*!\brief a / N for a constant integer N, see div_by(Fixed16)
+*/
+template <f_int32 N> FixedVector div_by(const FixedVector& a)
+{
+	return FixedVector(div_by<N>(a.x), div_by<N>(a.y), div_by<N>(a.z));
+}
 
 /*!\brief Inner (dot) product.
 */
@@ -91,24 +99,37 @@ Fixed16 dot(const FixedVector& a, const FixedVector& b);
 */
 FixedVector cross(const FixedVector& a, const FixedVector& b);
 
-/*!\brief Euclidean norm (length) of a vector
+/*!\brief Euclidean norm (length) of a vector, the square root of norm2_wide()
+	rounded to nearest. The length must fit a Fixed16, as for any result.
 */
 Fixed16 norm(const FixedVector& a);
 
 /*!\brief Euclidean norm (length) of a vector squared
+	Overflows once the length reaches 181, see norm2_wide()
 */
 Fixed16 norm2(const FixedVector& a);
 
+/*!\brief The exact Euclidean norm of a vector squared. It overflows once the
+	length reaches 46341, which a component below 26755 in size never reaches.
+*/
+Fixed32 norm2_wide(const FixedVector& a);
+
 /*!\brief Return the max element of a vector
 	can use as a scaling factor prior to normalising
 */
 Fixed16 maxElement(const FixedVector& v);
 
-/*!\brief Return a unit vector in the direction of v
-    Scales vector by max element prior to normalisation
+/*!\brief Return a unit vector in the direction of v, or the zero vector
+	if v is zero. Works for any v, see normalise(v, n2).
 */
 FixedVector normalise(const FixedVector& v);
 
+/*!\brief Return a unit vector in the direction of v, given n2 = norm2_wide(v).
+	n2 is only used while every component of v is below 16384 in size, so
+	that it cannot have overflowed. Longer vectors go through normalise(v).
+*/
+FixedVector normalise(const FixedVector& v, const Fixed32& n2);
+
 /*!\brief A UnitVector utility subclass of FixedVector.
 This class is used to automatically normalize vectors, for example
 when using the angle() function we can pass it some fixed vectors
@@ -118,7 +139,7 @@ class UnitVector : public FixedVector
 {
 public:
 	UnitVector(const FixedVector& v)
-		: FixedVector(v * invsqrt(norm2(v)))
+		: FixedVector(normalise(v))
 	{
 	}
 };
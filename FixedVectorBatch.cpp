@@ -0,0 +1,396 @@
+/*
+FixedVectorBatch.cpp. Structure-of-arrays batches of fixed point vectors.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#include "FixedVectorBatch.h"
+#include "FixedBatchLanes.h"
+#include "Quaternion.h"
+
+static void check_size(const char* name, const FixedVectorBatch& a, size_t n)
+{
+#ifdef IOSTREAMS
+	if (a.size() != n)
+	{
+		cerr << name << "(FixedVectorBatch) sizes differ: " << a.size() << " != " << n << endl;
+		throw -1;
+	}
+#endif
+}
+
+
+FixedVectorBatch::FixedVectorBatch(size_t n)
+	: m_size(n)
+{
+	/* Round each array up to whole 32 byte blocks, with room to align the first */
+	size_t stride = (n + 7) & ~size_t(7);
+	m_buffer = new f_int32[3 * stride + 8];
+	for (size_t i = 0; i < 3 * stride + 8; i++)
+		m_buffer[i] = 0;
+
+	size_t offset = ((32 - (uintptr_t(m_buffer) & 31)) & 31) / sizeof(f_int32);
+	m_x = m_buffer + offset;
+	m_y = m_x + stride;
+	m_z = m_y + stride;
+}
+
+FixedVectorBatch::~FixedVectorBatch()
+{
+	delete[] m_buffer;
+}
+
+const char* FixedVectorBatch::kernel()
+{
+	return batch_kernel();
+}
+
+void add(const FixedVectorBatch& a, const FixedVectorBatch& b, FixedVectorBatch& out)
+{
+	size_t n = a.size();
+	check_size("add", b, n);
+	check_size("add", out, n);
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		store(out.x() + i, add_lanes(load(a.x() + i), load(b.x() + i)));
+		store(out.y() + i, add_lanes(load(a.y() + i), load(b.y() + i)));
+		store(out.z() + i, add_lanes(load(a.z() + i), load(b.z() + i)));
+	}
+	for (; i < n; i++)
+		out.set(i, a.get(i) + b.get(i));
+}
+
+void scale(const FixedVectorBatch& a, const Fixed16& s, FixedVectorBatch& out)
+{
+	size_t n = a.size();
+	check_size("scale", out, n);
+
+	size_t i = 0;
+	lanes vs = broadcast(s.Raw());
+	for (; i + LANES <= n; i += LANES)
+	{
+		store(out.x() + i, mult_lanes(load(a.x() + i), vs));
+		store(out.y() + i, mult_lanes(load(a.y() + i), vs));
+		store(out.z() + i, mult_lanes(load(a.z() + i), vs));
+	}
+	for (; i < n; i++)
+		out.set(i, a.get(i) * s);
+}
+
+void dot(const FixedVectorBatch& a, const FixedVectorBatch& b, Fixed16* out)
+{
+	size_t n = a.size();
+	check_size("dot", b, n);
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		store(raw(out + i), dot_lanes(load(a.x() + i), load(b.x() + i),
+						load(a.y() + i), load(b.y() + i),
+						load(a.z() + i), load(b.z() + i)));
+	}
+	for (; i < n; i++)
+		out[i] = dot(a.get(i), b.get(i));
+}
+
+void cross(const FixedVectorBatch& a, const FixedVectorBatch& b, FixedVectorBatch& out)
+{
+	size_t n = a.size();
+	check_size("cross", b, n);
+	check_size("cross", out, n);
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		/* Load everything first, as out may be a or b */
+		lanes ax = load(a.x() + i), ay = load(a.y() + i), az = load(a.z() + i);
+		lanes bx = load(b.x() + i), by = load(b.y() + i), bz = load(b.z() + i);
+		store(out.x() + i, cross_lanes(ay, bz, az, by));
+		store(out.y() + i, cross_lanes(az, bx, ax, bz));
+		store(out.z() + i, cross_lanes(ax, by, ay, bx));
+	}
+	for (; i < n; i++)
+		out.set(i, cross(a.get(i), b.get(i)));
+}
+
+void norm2(const FixedVectorBatch& a, Fixed16* out)
+{
+	dot(a, a, out);
+}
+
+void norm(const FixedVectorBatch& a, Fixed16* out)
+{
+	size_t n = a.size();
+
+	size_t i = 0;
+	alignas(32) wide_raw t[LANES];
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes ax = load(a.x() + i), ay = load(a.y() + i), az = load(a.z() + i);
+		store_wide(t, add_wide(add_wide(mult_wide(ax, ax), mult_wide(ay, ay)), mult_wide(az, az)));
+		for (size_t k = 0; k < LANES; k++)
+			out[i + k] = sqrt(wide_value(t[k]));
+	}
+	for (; i < n; i++)
+		out[i] = norm(a.get(i));
+}
+
+/* Whether any component of vectors i to i + LANES - 1 is 16384 or more in size */
+static bool too_long(const FixedVectorBatch& a, size_t i)
+{
+	const f_int32* c[3] = { a.x() + i, a.y() + i, a.z() + i };
+	f_uint32 out_of_range = 0;
+	for (int j = 0; j < 3; j++)
+		for (size_t k = 0; k < LANES; k++)
+			out_of_range |= (f_uint32(c[j][k]) + 0x3FFFFFFFu > 0x7FFFFFFEu);
+	return out_of_range != 0;
+}
+
+/* The exact sums of squares come from the SIMD registers, and each lane is
+   then scaled by its own invsqrt_wide(), as normalise(v, n2) does. Blocks
+   with a component that could overflow the sum go to normalise(v), which
+   takes the sum of v/4 instead. */
+void normalise(const FixedVectorBatch& a, FixedVectorBatch& out)
+{
+	size_t n = a.size();
+	check_size("normalise", out, n);
+
+	size_t i = 0;
+	alignas(32) wide_raw t[LANES];
+	for (; i + LANES <= n; i += LANES)
+	{
+		if (too_long(a, i))
+		{
+			for (size_t k = 0; k < LANES; k++)
+				out.set(i + k, normalise(a.get(i + k)));
+			continue;
+		}
+		lanes ax = load(a.x() + i), ay = load(a.y() + i), az = load(a.z() + i);
+		store_wide(t, add_wide(add_wide(mult_wide(ax, ax), mult_wide(ay, ay)), mult_wide(az, az)));
+		for (size_t k = 0; k < LANES; k++)
+			out.set(i + k, normalise(a.get(i + k), wide_value(t[k])));
+	}
+	for (; i < n; i++)
+		out.set(i, normalise(a.get(i)));
+}
+
+void mult(const FixedMatrix& m, const FixedVectorBatch& a, FixedVectorBatch& out)
+{
+	size_t n = a.size();
+	check_size("mult", out, n);
+
+	size_t i = 0;
+	lanes m11 = broadcast(m.m11.Raw()), m12 = broadcast(m.m12.Raw()), m13 = broadcast(m.m13.Raw());
+	lanes m21 = broadcast(m.m21.Raw()), m22 = broadcast(m.m22.Raw()), m23 = broadcast(m.m23.Raw());
+	lanes m31 = broadcast(m.m31.Raw()), m32 = broadcast(m.m32.Raw()), m33 = broadcast(m.m33.Raw());
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes ax = load(a.x() + i), ay = load(a.y() + i), az = load(a.z() + i);
+		store(out.x() + i, dot_lanes(ax, m11, ay, m12, az, m13));
+		store(out.y() + i, dot_lanes(ax, m21, ay, m22, az, m23));
+		store(out.z() + i, dot_lanes(ax, m31, ay, m32, az, m33));
+	}
+	for (; i < n; i++)
+		out.set(i, m * a.get(i));
+}
+
+
+void rotate_many(const Quaternion& q, const FixedVectorBatch& in, FixedVectorBatch& out)
+{
+	size_t n = in.size();
+	check_size("rotate_many", out, n);
+
+	FixedQ2_30 r[3][3];
+	q.to_rotmat(r);
+
+	lanes r11 = broadcast(r[0][0].Raw()), r12 = broadcast(r[0][1].Raw()), r13 = broadcast(r[0][2].Raw());
+	lanes r21 = broadcast(r[1][0].Raw()), r22 = broadcast(r[1][1].Raw()), r23 = broadcast(r[1][2].Raw());
+	lanes r31 = broadcast(r[2][0].Raw()), r32 = broadcast(r[2][1].Raw()), r33 = broadcast(r[2][2].Raw());
+
+	size_t i = 0;
+	for (; i + LANES <= n; i += LANES)
+	{
+		lanes x = load(in.x() + i), y = load(in.y() + i), z = load(in.z() + i);
+		store(out.x() + i, narrow_q30(add_wide(add_wide(mult_wide(r11, x), mult_wide(r12, y)), mult_wide(r13, z))));
+		store(out.y() + i, narrow_q30(add_wide(add_wide(mult_wide(r21, x), mult_wide(r22, y)), mult_wide(r23, z))));
+		store(out.z() + i, narrow_q30(add_wide(add_wide(mult_wide(r31, x), mult_wide(r32, y)), mult_wide(r33, z))));
+	}
+	for (; i < n; i++)
+	{
+		FixedVector v = in.get(i);
+		rotate_many(q, &v, &v, 1);
+		out.set(i, v);
+	}
+}
+
+
+#ifdef IOSTREAMS
+
+/*!\brief The number of vectors in a and b that differ
+*/
+static f_int32 mismatches(const FixedVectorBatch& a, const FixedVectorBatch& b)
+{
+	f_int32 count = 0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		FixedVector u = a.get(i);
+		FixedVector v = b.get(i);
+		if ((u.x != v.x) || (u.y != v.y) || (u.z != v.z))
+			count++;
+	}
+	return count;
+}
+
+bool FixedVectorBatch::testharness()
+{
+	cout << "FixedVectorBatch testharness (" << kernel() << " kernels)" << endl;
+
+	/* An odd size, so that the scalar code finishes off every kernel */
+	const size_t n = 1003;
+	FixedVectorBatch a(n), b(n), out(n), expected(n);
+
+	test_result("x() aligned", f_int32(uintptr_t(a.x()) & 31), 0);
+	test_result("z() aligned", f_int32(uintptr_t(a.z()) & 31), 0);
+
+	/* Components up to 64, so that none of the scalar functions overflow */
+	for (size_t i = 0; i < n; i++)
+	{
+		a.set(i, FixedVector(Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9));
+		b.set(i, FixedVector(Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9, Fixed16::rand(0) >> 9));
+	}
+	/* Some awkward vectors to normalise */
+	a.set(0, FixedVector(0, 0, 0));
+	a.set(1, FixedVector(Fixed16::PRECISION(), Fixed16::zero(), -Fixed16::PRECISION()));
+	a.set(2, FixedVector(-64, 64, -64));
+
+	add(a, b, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, a.get(i) + b.get(i));
+	test_result("add mismatches", mismatches(out, expected), 0);
+
+	Fixed16 s = Fixed16::FromRaw(-98765);
+	scale(a, s, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, a.get(i) * s);
+	test_result("scale mismatches", mismatches(out, expected), 0);
+
+	Fixed16 d[n];
+	Fixed16 d2[n];
+	dot(a, b, d);
+	norm2(a, d2);
+	f_int32 dot_count = 0;
+	f_int32 norm2_count = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (d[i] != dot(a.get(i), b.get(i)))
+			dot_count++;
+		if (d2[i] != norm2(a.get(i)))
+			norm2_count++;
+	}
+	test_result("dot mismatches", dot_count, 0);
+	test_result("norm2 mismatches", norm2_count, 0);
+
+	cross(a, b, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, cross(a.get(i), b.get(i)));
+	test_result("cross mismatches", mismatches(out, expected), 0);
+
+	/* In place, out = cross(out, b) */
+	for (size_t i = 0; i < n; i++)
+		out.set(i, a.get(i));
+	cross(out, b, out);
+	test_result("cross in place mismatches", mismatches(out, expected), 0);
+
+	normalise(a, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, normalise(a.get(i)));
+	test_result("normalise mismatches", mismatches(out, expected), 0);
+
+	/* norm() and normalise() also take vectors far too long for norm2(), up to lengths that fit a Fixed16 */
+	FixedVectorBatch c(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		int shift = 1 + int(i % 16);
+		c.set(i, FixedVector(Fixed16::rand(0) >> shift, Fixed16::rand(0) >> shift, Fixed16::rand(0) >> shift));
+	}
+	norm(a, d);
+	norm(c, d2);
+	f_int32 norm_count = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (d[i] != norm(a.get(i)))
+			norm_count++;
+		if (d2[i] != norm(c.get(i)))
+			norm_count++;
+	}
+	test_result("norm mismatches", norm_count, 0);
+
+	/* normalise() takes any vector, up to components of -32768 */
+	for (size_t i = 0; i < n; i += 3)
+		c.set(i, FixedVector(Fixed16::rand(0), Fixed16::rand(0), Fixed16::rand(0)));
+	c.set(0, FixedVector(-32768, -32768, -32768));
+	c.set(1, FixedVector(32767, 32767, 32767));
+	c.set(2, FixedVector(32767, -32768, 1));
+	normalise(c, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, normalise(c.get(i)));
+	test_result("normalise, long vectors, mismatches", mismatches(out, expected), 0);
+	normalise(c, c);
+	test_result("normalise in place mismatches", mismatches(c, expected), 0);
+
+	Fixed16 theta(1), phi(-2), psi = Fixed16::FromRaw(12345);
+	FixedMatrix r = getrotmat(theta, phi, psi);
+	FixedMatrix m(Fixed16(2), Fixed16::FromRaw(-70000), Fixed16::PRECISION(),
+			Fixed16::zero(), Fixed16::FromRaw(99999), Fixed16(-2),
+			Fixed16::FromRaw(131071), Fixed16::FromRaw(-3), Fixed16::one());
+	mult(r, a, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, r * a.get(i));
+	test_result("mult(rotation) mismatches", mismatches(out, expected), 0);
+	mult(m, a, out);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, m * a.get(i));
+	test_result("mult mismatches", mismatches(out, expected), 0);
+
+	Fixed16 a1(1), a2(-2), a3 = Fixed16::FromRaw(12345);
+	Quaternion q = Quaternion::from_euler(a1, a2, a3);
+	FixedVector* v = new FixedVector[n];
+	for (size_t i = 0; i < n; i++)
+		v[i] = a.get(i);
+	rotate_many(q, v, v, n);
+	for (size_t i = 0; i < n; i++)
+		expected.set(i, v[i]);
+	delete[] v;
+	rotate_many(q, a, out);
+	test_result("rotate_many mismatches", mismatches(out, expected), 0);
+
+	return true;
+}
+
+#endif /* IOSTREAMS */
@@ -0,0 +1,153 @@
+#ifndef __FixedVectorBatch__
+#define __FixedVectorBatch__
+/*
+FixedVectorBatch.h. Structure-of-arrays batches of fixed point vectors.
+
+Copyright (C) 2005-2006  Tim Molteno tim@molteno.net
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+
+How to use the FixedVectorBatch
+
+FixedVectorBatch a(1000), b(1000), c(1000);
+a.set(0, FixedVector(1,2,3));       // or fill a.x(), a.y() and a.z() with raw values
+add(a, b, c);                       // c[i] = a[i] + b[i]
+mult(R, a, c);                      // c[i] = R * a[i]
+rotate_many(q, a, c);               // c[i] = a[i].Rotate3D(q), more or less
+Fixed16 d[1000];
+dot(a, b, d);                       // d[i] = dot(a[i], b[i])
+
+For complex samples see FixedComplexBatch.h.
+
+The kernels give the same bits as the FixedVector functions of the same
+name, so batches and single vectors can be mixed freely. They are built for
+AVX2, SSE4.1 or NEON when the compiler targets one of them (for example
+with -mavx2), and as plain loops otherwise. Define FIXED_NO_SIMD to always
+use the plain loops.
+
+Unlike the scalar functions, the kernels do not check for overflow when
+IOSTREAMS is defined. Results that overflow wrap around in the same way as
+the scalar functions do without IOSTREAMS. (The few vectors at the end of a
+batch that do not fill a SIMD register are handed to the scalar functions.)
+*/
+
+#include <stddef.h>
+
+#include "FixedVector.h"
+#include "FixedMatrix.h"
+
+class Quaternion;
+
+/*!\brief A batch of three dimensional vectors, stored as separate arrays of
+	the raw x, y and z values.
+
+* Each array is aligned to 32 bytes, so that it can be loaded a whole SIMD
+* register at a time.
+*/
+class FixedVectorBatch
+{
+public:
+	explicit FixedVectorBatch(size_t n);
+	~FixedVectorBatch();
+
+	size_t size() const { return m_size; }
+
+	f_int32* x() { return m_x; }
+	f_int32* y() { return m_y; }
+	f_int32* z() { return m_z; }
+	const f_int32* x() const { return m_x; }
+	const f_int32* y() const { return m_y; }
+	const f_int32* z() const { return m_z; }
+
+	FixedVector get(size_t i) const {
+		return FixedVector(Fixed16::FromRaw(m_x[i]), Fixed16::FromRaw(m_y[i]), Fixed16::FromRaw(m_z[i]));
+	}
+
+	void set(size_t i, const FixedVector& v) {
+		m_x[i] = v.x.Raw();
+		m_y[i] = v.y.Raw();
+		m_z[i] = v.z.Raw();
+	}
+
+	/*!\brief The instruction set the kernels were built for: "avx2", "sse4.1", "neon" or "scalar" */
+	static const char* kernel();
+
+#ifdef IOSTREAMS
+	static bool testharness();
+#endif
+
+private:
+	FixedVectorBatch(const FixedVectorBatch&) = delete;
+	FixedVectorBatch& operator=(const FixedVectorBatch&) = delete;
+
+	size_t m_size;
+	f_int32* m_buffer;
+	f_int32 *m_x, *m_y, *m_z;
+};
+
+/*
+* The output batch must be the same size as the inputs, and may be one of
+* them. Arrays of Fixed16 results must hold size() elements.
+*/
+
+/*!\brief out[i] = a[i] + b[i]
+*/
+void add(const FixedVectorBatch& a, const FixedVectorBatch& b, FixedVectorBatch& out);
+
+/*!\brief out[i] = a[i] * s
+*/
+void scale(const FixedVectorBatch& a, const Fixed16& s, FixedVectorBatch& out);
+
+/*!\brief out[i] = dot(a[i], b[i])
+*/
+void dot(const FixedVectorBatch& a, const FixedVectorBatch& b, Fixed16* out);
+
+/*!\brief out[i] = cross(a[i], b[i])
+*/
+void cross(const FixedVectorBatch& a, const FixedVectorBatch& b, FixedVectorBatch& out);
+
+/*!\brief out[i] = norm2(a[i])
+*/
+void norm2(const FixedVectorBatch& a, Fixed16* out);
+
+/*!\brief out[i] = norm(a[i])
+*/
+void norm(const FixedVectorBatch& a, Fixed16* out);
+
+/*!\brief out[i] = normalise(a[i])
+	The exact sums of squares are SIMD, the inverse square roots one vector at a time.
+*/
+void normalise(const FixedVectorBatch& a, FixedVectorBatch& out);
+
+/*!\brief out[i] = m * a[i]
+*/
+void mult(const FixedMatrix& m, const FixedVectorBatch& a, FixedVectorBatch& out);
+
+/*!\brief out[i] = in[i] rotated by q, the same as rotate_many(q, in, out, n) on arrays of FixedVector
+*/
+void rotate_many(const Quaternion& q, const FixedVectorBatch& in, FixedVectorBatch& out);
+
+#endif /* __FixedVectorBatch__ */
@@ -77,13 +77,13 @@ Quaternion Quaternion::conjugate(const Quaternion& q)
 */
 void Quaternion::get_euler(Fixed16& theta, Fixed16&phi, Fixed16& psi) const
 {
-	Fixed16 errorE = Fixed16(1)/1000; 				//TODO find the optimal and minimum one of these for a fixed16
+	Fixed16 errorE = div_by<1000>(Fixed16::one()); 				//TODO find the optimal and minimum one of these for a fixed16
 	
 	if (Quaternion::test_inRange(q0, q2, errorE) & Quaternion::test_inRange(q1, -q3, errorE))
 	{ 
 		//singularity at north pole
 		psi = -Fixed16(2) * arctan2(q1,q0);
-		phi = Fixed16::PI()/2;
+		phi = Fixed16::PI_OVER_2();
 		theta = Fixed16(0);
 		return;
 	}
@@ -91,7 +91,7 @@ void Quaternion::get_euler(Fixed16& theta, Fixed16&phi, Fixed16& psi) const
 	{
 		//singularity at south pole
 		psi = Fixed16(2) * arctan2(q1,q0);
-		phi = -Fixed16::PI()/2;
+		phi = -Fixed16::PI_OVER_2();
 		theta = Fixed16(0);
 		return;
 	}
@@ -129,12 +129,10 @@ void Quaternion::get_euler(Fixed16& theta, Fixed16&phi, Fixed16& psi) const
 // Construct a Quaternion from the Euler angles in radians NED Nasa standard aerospace
 Quaternion Quaternion::from_euler(Fixed16& theta, Fixed16& phi, Fixed16& psi)
 {
-	Fixed16 c1 = cos(theta/2);
-	Fixed16 s1 = sin(theta/2);
-	Fixed16 c2 = cos(phi/2);
-	Fixed16 s2 = sin(phi/2);
-	Fixed16 c3 = cos(psi/2);
-	Fixed16 s3 = sin(psi/2);
+	Fixed16 c1, s1, c2, s2, c3, s3;
+	sincos(div_by<2>(theta), s1, c1);
+	sincos(div_by<2>(phi), s2, c2);
+	sincos(div_by<2>(psi), s3, c3);
 
 	Fixed16 c1c2 = c1*c2;
 	Fixed16 s1s2 = s1*s2;
@@ -165,6 +163,89 @@ Quaternion Quaternion::from_euler(Fixed16& theta, Fixed16& phi, Fixed16& psi)
 }
 
 
+/*!\brief x >> n, rounded to nearest
+*/
+static f_int32 round_shr(const f_int64& x, int n)
+{
+	return ((x + f_int64(f_int32(1) << (n - 1))) >> n).toInt32();
+}
+
+/**
+	The products of the components are exact in Q32, and each entry is
+	rounded once, to Q30.
+*/
+void Quaternion::to_rotmat(FixedQ2_30 r[3][3]) const
+{
+	f_int32 w = q0.Raw(), x = q1.Raw(), y = q2.Raw(), z = q3.Raw();
+
+	f_int64 ww = f_int64::mult32(w, w), xx = f_int64::mult32(x, x);
+	f_int64 yy = f_int64::mult32(y, y), zz = f_int64::mult32(z, z);
+	f_int64 wx = f_int64::mult32(w, x), wy = f_int64::mult32(w, y), wz = f_int64::mult32(w, z);
+	f_int64 xy = f_int64::mult32(x, y), xz = f_int64::mult32(x, z), yz = f_int64::mult32(y, z);
+
+#ifdef IOSTREAMS
+	if (!((ww + xx + yy + zz) < (f_int64(2) << 32)))
+	{
+		cerr << "Quaternion::to_rotmat(" << *this << ") norm2() must be less than 2" << endl;
+		throw -1;
+	}
+#endif
+
+	/* Q32 to Q30, and 2 * Q32 to Q30 */
+	r[0][0] = FixedQ2_30::FromRaw(round_shr(ww + xx - yy - zz, 2));
+	r[0][1] = FixedQ2_30::FromRaw(round_shr(xy - wz, 1));
+	r[0][2] = FixedQ2_30::FromRaw(round_shr(xz + wy, 1));
+	r[1][0] = FixedQ2_30::FromRaw(round_shr(xy + wz, 1));
+	r[1][1] = FixedQ2_30::FromRaw(round_shr(ww - xx + yy - zz, 2));
+	r[1][2] = FixedQ2_30::FromRaw(round_shr(yz - wx, 1));
+	r[2][0] = FixedQ2_30::FromRaw(round_shr(xz - wy, 1));
+	r[2][1] = FixedQ2_30::FromRaw(round_shr(yz + wx, 1));
+	r[2][2] = FixedQ2_30::FromRaw(round_shr(ww - xx - yy + zz, 2));
+}
+
+FixedMatrix Quaternion::to_rotmat() const
+{
+	FixedQ2_30 r[3][3];
+	to_rotmat(r);
+
+	/* Q30 to Q16, rounded. Shifting twice keeps clear of overflow */
+	Fixed16 m[3][3];
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			m[i][j] = Fixed16::FromRaw(((r[i][j].Raw() >> 13) + 1) >> 1);
+
+	return FixedMatrix(m[0][0], m[0][1], m[0][2],
+			m[1][0], m[1][1], m[1][2],
+			m[2][0], m[2][1], m[2][2]);
+}
+
+/**
+	Each component is a sum of three Q30 x Q16 products, accumulated in an
+	f_int64 and rounded once to Fixed16.
+*/
+void rotate_many(const Quaternion& q, const FixedVector* in, FixedVector* out, size_t n)
+{
+	FixedQ2_30 rq[3][3];
+	q.to_rotmat(rq);
+
+	f_int32 r11 = rq[0][0].Raw(), r12 = rq[0][1].Raw(), r13 = rq[0][2].Raw();
+	f_int32 r21 = rq[1][0].Raw(), r22 = rq[1][1].Raw(), r23 = rq[1][2].Raw();
+	f_int32 r31 = rq[2][0].Raw(), r32 = rq[2][1].Raw(), r33 = rq[2][2].Raw();
+
+	for (size_t i = 0; i < n; i++)
+	{
+		f_int32 x = in[i].x.Raw(), y = in[i].y.Raw(), z = in[i].z.Raw();
+
+		f_int64 ox = f_int64::mult32(r11, x) + f_int64::mult32(r12, y) + f_int64::mult32(r13, z);
+		f_int64 oy = f_int64::mult32(r21, x) + f_int64::mult32(r22, y) + f_int64::mult32(r23, z);
+		f_int64 oz = f_int64::mult32(r31, x) + f_int64::mult32(r32, y) + f_int64::mult32(r33, z);
+
+		out[i] = FixedVector(Fixed16::FromRaw(round_shr(ox, 30)), Fixed16::FromRaw(round_shr(oy, 30)),
+				Fixed16::FromRaw(round_shr(oz, 30)));
+	}
+}
+
+
 bool operator!=(const Quaternion& a, const Quaternion& b)
 {
 	if (a.q0 != b.q0) return true;
@@ -177,12 +258,33 @@ bool operator!=(const Quaternion& a, const Quaternion& b)
 
 Quaternion operator*(const Quaternion& a, const Quaternion& b)
 {
-	Quaternion ret(0,0,0,0);
-	ret.q0 = -Fixed16(a.q1 * b.q1) - Fixed16(a.q2 * b.q2) - Fixed16(a.q3 * b.q3) + Fixed16(a.q0 * b.q0);
-	ret.q1 =  Fixed16(a.q1 * b.q0) + Fixed16(a.q2 * b.q3) - Fixed16(a.q3 * b.q2) + Fixed16(a.q0 * b.q1);
-	ret.q2 = -Fixed16(a.q1 * b.q3) + Fixed16(a.q2 * b.q0) + Fixed16(a.q3 * b.q1) + Fixed16(a.q0 * b.q2);
-	ret.q3 =  Fixed16(a.q1 * b.q2) - Fixed16(a.q2 * b.q1) + Fixed16(a.q3 * b.q0) + Fixed16(a.q0 * b.q3);
+	/* Each component is rounded once, from the exact sum of its four products */
+	Fixed32 r0, r1, r2, r3;
+	Fixed16::mac(r0, a.q0, b.q0);
+	Fixed16::msub(r0, a.q1, b.q1);
+	Fixed16::msub(r0, a.q2, b.q2);
+	Fixed16::msub(r0, a.q3, b.q3);
+
+	Fixed16::mac(r1, a.q0, b.q1);
+	Fixed16::mac(r1, a.q1, b.q0);
+	Fixed16::mac(r1, a.q2, b.q3);
+	Fixed16::msub(r1, a.q3, b.q2);
+
+	Fixed16::mac(r2, a.q0, b.q2);
+	Fixed16::msub(r2, a.q1, b.q3);
+	Fixed16::mac(r2, a.q2, b.q0);
+	Fixed16::mac(r2, a.q3, b.q1);
+
+	Fixed16::mac(r3, a.q0, b.q3);
+	Fixed16::mac(r3, a.q1, b.q2);
+	Fixed16::msub(r3, a.q2, b.q1);
+	Fixed16::mac(r3, a.q3, b.q0);
 
+	Quaternion ret(0,0,0,0);
+	ret.q0 = Fixed16::FromAccumulator(r0);
+	ret.q1 = Fixed16::FromAccumulator(r1);
+	ret.q2 = Fixed16::FromAccumulator(r2);
+	ret.q3 = Fixed16::FromAccumulator(r3);
 	return ret;
 }
 
@@ -211,7 +313,7 @@ bool Quaternion::testharness()
 {
 	Fixed16 a(1);
 	Fixed16 b(0);
-	Fixed16 tol = Fixed16::one() / 1000;
+	Fixed16 tol = div_by<1000>(Fixed16::one());
 
 	Quaternion q(1,1,0,1);
 	
@@ -221,6 +323,72 @@ bool Quaternion::testharness()
 	q = Quaternion::normalize(q);
 	test_result("normalize",q.norm(),Fixed16(1),tol);
 
+	FixedMatrix identity = Quaternion(1,0,0,0).to_rotmat();
+	test_result("to_rotmat(1) trace", identity.m11 + identity.m22 + identity.m33, Fixed16(3));
+	test_result("to_rotmat(1) off diagonal", abs(identity.m12) + abs(identity.m13) + abs(identity.m21) +
+			abs(identity.m23) + abs(identity.m31) + abs(identity.m32), Fixed16::zero());
+
+	/* rotate_many() against q * v * conjugate(q) worked out in double */
+	{
+		const int n = 64;
+		FixedVector in[n];
+		FixedVector out[n];
+		FixedVector same[n];
+		double worst = 0;
+		double worst_rotate3d = 0;
+		double worst_rotmat = 0;
+		f_int32 in_place_mismatches = 0;
+		for (int t = 0; t < 200; t++)
+		{
+			Fixed16 theta = Fixed16::rand(0) >> 13, phi = Fixed16::rand(0) >> 14, psi = Fixed16::rand(0) >> 13;
+			Quaternion r = Quaternion::from_euler(theta, phi, psi);
+			double w = r.q0.toDouble(), x = r.q1.toDouble(), y = r.q2.toDouble(), z = r.q3.toDouble();
+			double m[3][3] = {
+				{ w*w + x*x - y*y - z*z, 2*(x*y - w*z), 2*(x*z + w*y) },
+				{ 2*(x*y + w*z), w*w - x*x + y*y - z*z, 2*(y*z - w*x) },
+				{ 2*(x*z - w*y), 2*(y*z + w*x), w*w - x*x - y*y + z*z } };
+
+			FixedMatrix rm = r.to_rotmat();
+			Fixed16 rm_entry[9] = { rm.m11, rm.m12, rm.m13, rm.m21, rm.m22, rm.m23, rm.m31, rm.m32, rm.m33 };
+			for (int k = 0; k < 9; k++)
+			{
+				double e = fabs(rm_entry[k].toDouble() - m[k / 3][k % 3]) * 65536.0;
+				if (e > worst_rotmat) worst_rotmat = e;
+			}
+
+			/* Components up to 128 */
+			for (int i = 0; i < n; i++)
+			{
+				in[i] = FixedVector(Fixed16::rand(0) >> 8, Fixed16::rand(0) >> 8, Fixed16::rand(0) >> 8);
+				same[i] = in[i];
+			}
+			rotate_many(r, in, out, n);
+			rotate_many(r, same, same, n);
+
+			for (int i = 0; i < n; i++)
+			{
+				double v[3] = { in[i].x.toDouble(), in[i].y.toDouble(), in[i].z.toDouble() };
+				FixedVector r3d = in[i].Rotate3D(r);
+				Fixed16 got[3] = { out[i].x, out[i].y, out[i].z };
+				Fixed16 got_r3d[3] = { r3d.x, r3d.y, r3d.z };
+				for (int k = 0; k < 3; k++)
+				{
+					double exact = m[k][0] * v[0] + m[k][1] * v[1] + m[k][2] * v[2];
+					double e = fabs(got[k].toDouble() - exact) * 65536.0;
+					if (e > worst) worst = e;
+					e = fabs(got_r3d[k].toDouble() - exact) * 65536.0;
+					if (e > worst_rotate3d) worst_rotate3d = e;
+				}
+				if ((same[i].x != out[i].x) || (same[i].y != out[i].y) || (same[i].z != out[i].z))
+					in_place_mismatches++;
+			}
+		}
+		test_result("to_rotmat() error (LSB)", worst_rotmat, 0.0, 0.51);
+		test_result("rotate_many error (LSB)", worst, 0.0, 0.6);
+		test_result("Rotate3D error (LSB)", worst_rotate3d, 0.0, 8.0);
+		test_result("rotate_many in place mismatches", in_place_mismatches, 0);
+	}
+
 	Fixed16 measured_theta = Fixed16(0);
 	Fixed16 measured_phi = Fixed16(0);
 	Fixed16 measured_psi = Fixed16(0);
@@ -245,7 +413,7 @@ bool Quaternion::testharness()
 				Fixed16 radnumir;
 				Fixed16 radnumjr;
 				Fixed16 radnumkr;
-				Fixed16 error = Fixed16(1)/100;
+				Fixed16 error = div_by<100>(Fixed16(1));
 				
 				if ((i != 0)&(j != 0)&(k != 0))
 				{
@@ -31,8 +31,11 @@ DEALINGS IN THE SOFTWARE.
 */
 
 
+#include <stddef.h>
+
 #include "Fixed.h"
 #include "FixedVector.h"
+#include "FixedMatrix.h"
 
 
 /*!\brief A Class for handling Hamilton's quaternions composed of Fixed16 objects. These are useful for representing rotations.
@@ -109,6 +112,17 @@ public:
 
 	static Quaternion from_euler(Fixed16& theta, Fixed16& phi, Fixed16& psi);
 
+	/*!\brief The matrix r[row][column] that rotates a vector v as q * v * conjugate(q) does,
+		held in Q2.30 so that it keeps all of the precision of the quaternion.
+		Any quaternion with norm2() < 2 can be used, so rounding errors in a unit
+		quaternion do no harm. The matrix is scaled by norm2().
+	*/
+	void to_rotmat(FixedQ2_30 r[3][3]) const;
+
+	/*!\brief The same rotation matrix, rounded to Fixed16
+	*/
+	FixedMatrix to_rotmat() const;
+
 
 
 #ifdef IOSTREAMS
@@ -123,5 +137,12 @@ bool operator!=(const Quaternion& a, const Quaternion& b);
 Quaternion operator*(const Quaternion& a, const Quaternion& b);
 Quaternion operator+(const Quaternion& a, const Quaternion& b);
 
+/*!\brief Rotate the n vectors in[i] by q, into out[i], which may be the same array as in.
+	The same as in[i].Rotate3D(q), but the rotation matrix is worked out once
+	and each vector then costs nine multiply-accumulates, so the result is
+	rounded once rather than at every step of two Quaternion products.
+*/
+void rotate_many(const Quaternion& q, const FixedVector* in, FixedVector* out, size_t n);
+
 
 #endif /* __quaternion__ */
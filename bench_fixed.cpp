@@ -0,0 +1,806 @@
+/**
+ * Benchmark of the Fixed point library on the host computer.
+ *
+ * Times each function in Fixed, FixedTrig, FixedCordic, FixedNco, FixedVector,
+ * FixedVectorBatch, FixedComplex, FixedFir, FixedBiquad, FixedFFT, FixedMatrix and Quaternion, one call at a time and over whole arrays,
+ * then sweeps the single argument Fixed16 functions against a double
+ * reference and reports the error in units of Fixed16::PRECISION() (ULP).
+ *
+ *   bench_fixed [--csv | --json] [--timing | --accuracy] [--stride N]
+ *
+ * --stride N checks every Nth raw input. --stride 1 is exhaustive, which is
+ * all 2^32 inputs for the functions that accept any Fixed16. By default each
+ * function gets about 2^20 inputs spread over its domain.
+ *
+ * Build with and without NATIVE_64BIT to compare the two f_int64 backends
+ * (see the bench targets in the Makefile).
+ *
+ * Copyright (c) Tim Molteno. 2003-2019.
+ * */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Fixed.h"
+#include "FixedTrig.h"
+#include "FixedCordic.h"
+#include "FixedNco.h"
+#include "FixedMatrix.h"
+#include "FixedMatrixN.h"
+#include "FixedSolve.h"
+#include "FixedVectorBatch.h"
+#include "FixedComplexBatch.h"
+#include "FixedFir.h"
+#include "FixedBiquad.h"
+#include "FixedFFT.h"
+#include "Quaternion.h"
+
+static const int N_DATA = 1024;
+static const int N_REPEAT = 2000;
+
+static Fixed16 f16_data[N_DATA];
+static Fixed32 f32_data[N_DATA];
+static FixedVector vec_data[N_DATA];
+static FixedComplex cpx_data[N_DATA];
+static FixedMatrix mat_data[N_DATA];
+static std::vector<Quaternion> quat_data;	// Quaternion has no default constructor
+
+/* A few larger matrices, filled from the rotation matrices */
+static const int N_MATN = 16;
+static FixedMatrixN<6,6> mat6_data[N_MATN];
+static FixedMatrixN<12,12> mat12_data[N_MATN];
+static FixedMatrixN<6,6> spd6_data[N_MATN];	// symmetric positive definite
+static FixedMatrixN<6,1> rhs6_data[N_MATN];
+
+/* Outputs of the batched benchmarks */
+static Fixed16 f16_out[N_DATA];
+static FixedVector vec_out[N_DATA];
+static FixedComplex cpx_out[N_DATA];
+static Fixed16 phase_out[N_DATA];
+static FixedMatrix mat_out[N_DATA];
+static std::vector<Quaternion> quat_out(N_DATA, Quaternion(1, 0, 0, 0));
+
+/* vec_data as a FixedVectorBatch, a second batch and somewhere to put the results */
+static FixedVectorBatch batch_a(N_DATA);
+static FixedVectorBatch batch_b(N_DATA);
+static FixedVectorBatch batch_out(N_DATA);
+
+/* cpx_data as a FixedComplexBatch, and the same for the other two */
+static FixedComplexBatch cpx_batch_a(N_DATA);
+static FixedComplexBatch cpx_batch_b(N_DATA);
+static FixedComplexBatch cpx_batch_out(N_DATA);
+
+/* Prevent the compiler from throwing the results away */
+static volatile f_int32 sink;
+
+static void consume(const Fixed16& x)
+{
+	sink = sink + x.Raw();
+}
+
+static void consume(const Fixed32& x)
+{
+	sink = sink + x.Raw().GetLo();
+}
+
+static void consume(const FixedVector& v)
+{
+	sink = sink + v.x.Raw() + v.y.Raw() + v.z.Raw();
+}
+
+static void consume(const FixedComplex& z)
+{
+	sink = sink + z.re.Raw() + z.im.Raw();
+}
+
+static void consume(const FixedMatrix& m)
+{
+	sink = sink + m.m11.Raw() + m.m22.Raw() + m.m33.Raw();
+}
+
+template <int R, int C> static void consume(const FixedMatrixN<R,C>& m)
+{
+	sink = sink + m(0,0).Raw() + m(R-1,C-1).Raw();
+}
+
+static void consume(const Quaternion& q)
+{
+	sink = sink + q.q0.Raw() + q.q1.Raw() + q.q2.Raw() + q.q3.Raw();
+}
+
+static void fill_data()
+{
+	uint32_t seed = 123456789;
+	for (int i = 0; i < N_DATA; i++)
+	{
+		seed = 1103515245 * seed + 12345;
+		/* Values between -128 and 128 so products stay in range */
+		f16_data[i] = Fixed16::FromRaw(f_int32(seed) >> 8);
+		seed = 1103515245 * seed + 12345;
+		f32_data[i] = Fixed32::FromRaw(f_int64(f_int32(seed) >> 24, seed));
+	}
+
+	/* Vectors of length up to about 1, and rotations by small angles, which are invertible */
+	for (int i = 0; i < N_DATA; i++)
+	{
+		int j = (i + 1) & (N_DATA - 1);
+		int k = (i + 2) & (N_DATA - 1);
+		vec_data[i] = FixedVector(f16_data[i] >> 7, f16_data[j] >> 7, f16_data[k] >> 7);
+
+		Fixed16 a(f16_data[i] >> 5), b(f16_data[j] >> 5), c(f16_data[k] >> 5);
+		mat_data[i] = getrotmat(a, b, c);
+		quat_data.push_back(Quaternion::from_euler(a, b, c));
+	}
+
+	for (int i = 0; i < N_MATN; i++)
+	{
+		for (int j = 0; j < 36; j++)
+			mat6_data[i].data()[j] = mat_data[i*36 + j/9].toN().data()[j % 9];
+		for (int j = 0; j < 144; j++)
+			mat12_data[i].data()[j] = mat_data[(i*144 + j/9) & (N_DATA - 1)].toN().data()[j % 9];
+		spd6_data[i] = mat6_data[i] * trans(mat6_data[i]) + FixedMatrixN<6,6>::identity();
+		for (int j = 0; j < 6; j++)
+			rhs6_data[i](j, 0) = f16_data[i*6 + j] >> 7;
+	}
+
+	for (int i = 0; i < N_DATA; i++)
+	{
+		batch_a.set(i, vec_data[i]);
+		batch_b.set(i, vec_data[(i + 1) & (N_DATA - 1)]);
+
+		/* I/Q samples with parts up to 1 */
+		cpx_data[i] = FixedComplex(vec_data[i].x, vec_data[i].y);
+		cpx_batch_a.set(i, cpx_data[i]);
+		cpx_batch_b.set(i, cpx_data[(i + 1) & (N_DATA - 1)]);
+	}
+}
+
+/*!\brief The output format, and which sections to run
+*/
+enum bench_format { FORMAT_TEXT, FORMAT_CSV, FORMAT_JSON };
+
+static bench_format format = FORMAT_TEXT;
+static bool run_timing = true;
+static bool run_accuracy = true;
+static long long sweep_stride = 0;	// 0 for about 2^20 inputs per function
+
+struct timing_result
+{
+	std::string name;
+	double ns;
+};
+
+struct accuracy_result
+{
+	std::string name;
+	f_int32 from, to;	// the raw inputs swept, inclusive
+	long long inputs;	// inputs compared (those whose result fits in a Fixed16)
+	double max_ulp;
+	double mean_ulp;
+	f_int32 worst;		// the raw input with the largest error
+};
+
+static std::vector<timing_result> timings;
+static std::vector<accuracy_result> accuracies;
+
+/*!\brief Run body, which does N_DATA operations, N_REPEAT times and
+	return the cost of one operation in ns.
+*/
+template <class Body> double time_per_op(Body body)
+{
+	typedef std::chrono::high_resolution_clock clock;
+
+	clock::time_point start = clock::now();
+	for (int r = 0; r < N_REPEAT; r++)
+		body();
+	clock::time_point stop = clock::now();
+
+	double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+	return ns / (double(N_REPEAT) * double(N_DATA));
+}
+
+static void record(const std::string& name, double ns)
+{
+	timing_result t;
+	t.name = name;
+	t.ns = ns;
+	timings.push_back(t);
+}
+
+/*!\brief Time op(i), one call at a time over the data set.
+*/
+template <class Op> void bench(const char* name, Op op)
+{
+	record(name, time_per_op([&op]() {
+		for (int i = 0; i < N_DATA; i++)
+			op(i);
+	}));
+}
+
+/*!\brief Time out[i] = op(in[i]) over whole arrays, which leaves the compiler
+	free to overlap the calls.
+*/
+template <class In, class Out, class Op> void bench_batch(const char* name, const In* in, Out* out, Op op)
+{
+	record(std::string(name) + " [batch]", time_per_op([in, out, &op]() {
+		for (int i = 0; i < N_DATA; i++)
+			out[i] = op(in[i]);
+		consume(out[sink & (N_DATA - 1)]);
+	}));
+}
+
+static int next(int i)
+{
+	return (i + 1) & (N_DATA - 1);
+}
+
+/* A non-zero Fixed16 from the data, and a positive one */
+static Fixed16 nonzero(int i)
+{
+	return Fixed16::FromRaw(f16_data[i].Raw() | 1);
+}
+
+static Fixed16 positive(int i)
+{
+	return Fixed16::FromRaw(abs(f16_data[i]).Raw() | 1);
+}
+
+typedef Fixed<16,16,f_int32,fixed_wrap,fixed_round_half_even> HalfEven;
+typedef Fixed<16,16,f_int32,fixed_wrap,fixed_round_stochastic> Stochastic;
+
+static Fixed16Sat sat(int i)
+{
+	return Fixed16Sat::FromRaw(f16_data[i].Raw());
+}
+
+static f_uint64 u64(int i)
+{
+	f_int64 x = f32_data[i].Raw();
+	return f_uint64(x.GetHi(), x.GetLo());
+}
+
+/*!\brief The shift-and-add f_uint64 multiply that operator*= used to be,
+	kept here to compare against.
+*/
+static f_uint64 mult_shift_add(const f_uint64& a, const f_uint64& b)
+{
+	f_uint64 ret;
+	f_uint64 t(a);
+	f_uint64 q(b);
+
+	int32_t counter = 0;
+	do
+	{
+		if ((q.GetLo() & 1) != 0)
+			ret += t;
+		q >>= 1;
+		t <<= 1;
+		counter++;
+	}
+	while ((counter < 64) && ((q.GetHi() != 0) || (q.GetLo() != 0)));
+
+	return ret;
+}
+
+/*!\brief The reciprocal() that found its seed with a shift loop and always
+	did six Newton steps, kept here to compare against.
+*/
+static Fixed16 reciprocal_loop(const Fixed16& x)
+{
+	Fixed16 two(2);
+
+	f_int32 guess = 1;
+	f_int32 max = 1 << 30;
+	f_int32 raw = abs(x).Raw();
+
+	while ((max > 0) && ((max & raw) == 0))
+	{
+		max = max >> 1;
+		guess = guess << 1;
+	}
+
+	Fixed16 y1;
+	if (x > Fixed16::zero())
+		y1 = Fixed16::FromRaw(guess);
+	else
+		y1 = -Fixed16::FromRaw(guess);
+
+	for (int i=6;i>0;i--)
+		y1 = y1 * (two - x*y1);
+
+	return y1;
+}
+
+/*!\brief The invsqrt() that normalised with a shift loop and always did five
+	Newton steps, kept here to compare against.
+*/
+static Fixed16 invsqrt_loop(const Fixed16& x)
+{
+	Fixed16 y = x;
+	int n = 0;
+	if (y < Fixed16::one())
+	{
+		while (y < Fixed16::one())
+		{
+			y = y << 2;
+			n += 1;
+		}
+		y = Fixed16::one() << (n-1);
+	}
+	else if (y > Fixed16::one())
+	{
+		while (y > Fixed16::one())
+		{
+			y = y >> 2;
+			n += 1;
+		}
+		y = Fixed16::one() >> n;
+	}
+
+	Fixed32 three = Fixed32(int32_t(3));
+	Fixed16 half = Fixed16::one() >> 1;
+	for (int i = 5; i > 0; i--)
+		y = half*y*(three - x*y*y);
+	return y;
+}
+
+/*!\brief The normalise() that divided by maxElement() before taking
+	invsqrt(norm2()), kept here to compare against.
+*/
+static FixedVector normalise_max(const FixedVector& v)
+{
+	FixedVector ret = v / Fixed16Divider(maxElement(v));
+	return ret * invsqrt(norm2(ret));
+}
+
+/*!\brief Compare f against the double reference ref for the raw inputs
+	from..to, and record the largest and mean error in ULP. Inputs whose
+	exact result does not fit in a Fixed16 are skipped.
+*/
+template <class F, class Ref> void sweep(const char* name, F f, Ref ref, f_int32 from, f_int32 to)
+{
+	long long step = sweep_stride;
+	if (step == 0)
+		step = ((long long)(to) - from) >> 20 | 1;
+
+	accuracy_result a;
+	a.name = name;
+	a.from = from;
+	a.to = to;
+	a.inputs = 0;
+	a.max_ulp = 0;
+	a.worst = from;
+
+	double sum = 0;
+	for (long long raw = from; raw <= to; raw += step)
+	{
+		Fixed16 x = Fixed16::FromRaw(f_int32(raw));
+		double exact = ref(x.toDouble());
+		if (!(std::fabs(exact) < 32768.0))
+			continue;
+
+		double ulp = std::fabs(f(x).toDouble() - exact) * 65536.0;
+		sum += ulp;
+		a.inputs++;
+		if (ulp > a.max_ulp)
+		{
+			a.max_ulp = ulp;
+			a.worst = f_int32(raw);
+		}
+	}
+	a.mean_ulp = (a.inputs > 0) ? sum / a.inputs : 0;
+	accuracies.push_back(a);
+}
+
+static f_int32 raw(double x)
+{
+	return f_int32(x * 65536.0);
+}
+
+static const f_int32 RAW_MIN = -0x7FFFFFFF - 1;
+static const f_int32 RAW_MAX = 0x7FFFFFFF;
+
+/*!\brief Time body, which runs a FixedVectorBatch kernel over N_DATA vectors
+*/
+template <class Body> void bench_vector_batch(const char* name, Body body)
+{
+	record(std::string(name) + " [" + FixedVectorBatch::kernel() + "]", time_per_op([&body]() {
+		body();
+		consume(batch_out.get(sink & (N_DATA - 1)));
+	}));
+}
+
+/*!\brief Time body, which runs a FixedComplexBatch kernel over N_DATA samples
+*/
+template <class Body> void bench_complex_batch(const char* name, Body body)
+{
+	record(std::string(name) + " [" + FixedComplexBatch::kernel() + "]", time_per_op([&body]() {
+		body();
+		consume(cpx_batch_out.get(sink & (N_DATA - 1)));
+	}));
+}
+
+/*!\brief Time a Taps long FixedFir over N_DATA samples, so the cost is per sample
+*/
+template <int Taps> void bench_fir()
+{
+	static FixedFir<Taps> fir;
+	Fixed16 h[Taps];
+	for (int k = 0; k < Taps; k++)
+		h[k] = f16_data[k] >> 8;
+	fir.set_coefficients(h);
+
+	std::string name = "FixedFir<" + std::to_string(Taps) + ">::process(in, out, n) [" + fixed_fir_kernel() + "]";
+	record(name, time_per_op([]() {
+		fir.process(f16_data, f16_out, N_DATA);
+		consume(f16_out[sink & (N_DATA - 1)]);
+	}));
+}
+
+/*!\brief Time a cascade of Sections lowpass sections over N_DATA samples,
+	N_DATA / Channels frames of them, so the cost is per sample
+*/
+template <int Sections, int Channels> void bench_biquad(bool error_feedback)
+{
+	static FixedBiquadCascade<Sections, Channels> iir;
+	iir.set_error_feedback(error_feedback);
+	for (int s = 0; s < Sections; s++)
+		iir.set_section(s, 0.0201, 0.0402, 0.0201, -1.5610, 0.6413);
+
+	std::string name = "FixedBiquadCascade<" + std::to_string(Sections) + "," + std::to_string(Channels) + ">"
+		+ (error_feedback ? "" : " truncated") + " [" + fixed_biquad_kernel() + "]";
+	record(name, time_per_op([]() {
+		iir.process(f16_data, f16_out, N_DATA / Channels);
+		consume(f16_out[sink & (N_DATA - 1)]);
+	}));
+}
+
+/*!\brief Time forward() and real_forward() of an N point FFT, in ns per
+	transform, including copying the input in. The input is copied in each
+	time, so that the scaling does not run away. Each is run about
+	2^22 / (N log2 N) times, which keeps the big sizes from taking minutes.
+*/
+template <int N> double time_fft(bool real)
+{
+	typedef std::chrono::high_resolution_clock clock;
+	static Fixed16 data[2*N];
+	const int repeat = 1 + (1 << 22) / (N * FixedFFT<N>::log2n);
+	const int n = real ? N : 2*N;
+
+	clock::time_point start = clock::now();
+	for (int r = 0; r < repeat; r++)
+	{
+		for (int i = 0; i < n; i++)
+			data[i] = f16_data[i & (N_DATA - 1)] >> 4;
+		sink = sink + (real ? FixedFFT<N>::real_forward(data) : FixedFFT<N>::forward(data));
+	}
+	clock::time_point stop = clock::now();
+
+	return std::chrono::duration<double, std::nano>(stop - start).count() / repeat;
+}
+
+template <int N> void bench_fft()
+{
+	std::string name = "FixedFFT<" + std::to_string(N) + ">::";
+	std::string kernel = std::string(" [") + fixed_fft_kernel() + "]";
+	record(name + "forward" + kernel, time_fft<N>(false));
+	record(name + "real_forward" + kernel, time_fft<N>(true));
+}
+
+static void run_timings()
+{
+	bench("Fixed32 + Fixed32", [](int i) { consume(f32_data[i] + f32_data[next(i)]); });
+	bench("Fixed32 - Fixed32", [](int i) { consume(f32_data[i] - f32_data[next(i)]); });
+	bench("Fixed32 < Fixed32", [](int i) { sink = sink + (f32_data[i] < f32_data[next(i)]); });
+	bench("Fixed32 shiftr", [](int i) { Fixed32 x(f32_data[i]); x.shiftr(i & 31); consume(x); });
+	bench("Fixed32 * Fixed32", [](int i) { consume(Fixed32(f16_data[i]) * Fixed32(f16_data[next(i)])); });
+	bench("Fixed32 / Fixed32", [](int i) { consume(f32_data[i] / f32_data[next(i)]); });
+	bench("f_int64 / f_int64", [](int i) { consume(Fixed32::FromRaw(f32_data[i].Raw() / (f32_data[next(i)].Raw() >> (i & 31)))); });
+	bench("reciprocal(Fixed32)", [](int i) { consume(reciprocal(f32_data[i])); });
+	bench("sqrt(Fixed32)", [](int i) { consume(sqrt(abs(f32_data[i]))); });
+	bench("f_uint64 * (shift-and-add)", [](int i) { sink = sink + mult_shift_add(u64(i), u64(next(i))).GetLo(); });
+	bench("f_uint64 * f_uint64", [](int i) { sink = sink + (u64(i) * u64(next(i))).GetLo(); });
+	bench("f_uint64::mult64", [](int i) { f_uint64 hi, lo; f_uint64::mult64(u64(i), u64(next(i)), hi, lo); sink = sink + hi.GetLo(); });
+
+	bench("Fixed16 + Fixed16", [](int i) { consume(f16_data[i] + f16_data[next(i)]); });
+	bench("Fixed16 * Fixed16", [](int i) { consume(f16_data[i] * f16_data[next(i)]); });
+	bench("Fixed16::FromFixed32", [](int i) { consume(Fixed16::FromFixed32(f32_data[i])); });
+	bench("Fixed16 *= Fixed16", [](int i) { Fixed16 x(f16_data[i]); x *= f16_data[next(i)]; consume(x); });
+	bench("Fixed16Sat + Fixed16Sat", [](int i) { consume(Fixed16::FromRaw((sat(i) + sat(next(i))).Raw())); });
+	bench("Fixed16Sat *= Fixed16Sat", [](int i) { Fixed16Sat x(sat(i)); x *= sat(next(i)); consume(Fixed16::FromRaw(x.Raw())); });
+	bench("Fixed16Sat << n", [](int i) { consume(Fixed16::FromRaw((sat(i) << (i & 7)).Raw())); });
+	bench("Fixed16 << n", [](int i) { consume(f16_data[i] << (i & 7)); });
+	bench("Fixed16 *= (half even)", [](int i) { HalfEven x = HalfEven::FromRaw(f16_data[i].Raw()); x *= HalfEven::FromRaw(f16_data[next(i)].Raw()); consume(Fixed16::FromRaw(x.Raw())); });
+	bench("Fixed16 *= (stochastic)", [](int i) { Stochastic x = Stochastic::FromRaw(f16_data[i].Raw()); x *= Stochastic::FromRaw(f16_data[next(i)].Raw()); consume(Fixed16::FromRaw(x.Raw())); });
+	bench("Fixed16Trap + Fixed16Trap", [](int i) { consume(Fixed16::FromRaw((Fixed16Trap::FromRaw(f16_data[i].Raw() >> 1) + Fixed16Trap::FromRaw(f16_data[next(i)].Raw() >> 1)).Raw())); });
+	bench("Fixed16 / Fixed16", [](int i) { consume(f16_data[i] / nonzero(next(i))); });
+	bench("Fixed16 / 10", [](int i) { consume(f16_data[i] / 10); });
+	bench("div_by<10>(Fixed16)", [](int i) { consume(div_by<10>(f16_data[i])); });
+	bench("div_by<8>(Fixed16)", [](int i) { consume(div_by<8>(f16_data[i])); });
+	bench("reciprocal(Fixed16) (loop)", [](int i) { consume(reciprocal_loop(nonzero(i))); });
+	bench("reciprocal(Fixed16)", [](int i) { consume(reciprocal(nonzero(i))); });
+	bench("invsqrt(Fixed16) (loop)", [](int i) { consume(invsqrt_loop(positive(i))); });
+	bench("invsqrt(Fixed16)", [](int i) { consume(invsqrt(positive(i))); });
+	bench("sqrt(Fixed16)", [](int i) { consume(sqrt(abs(f16_data[i]))); });
+	bench("round(Fixed16)", [](int i) { consume(round(f16_data[i])); });
+	bench("sin(Fixed16)", [](int i) { consume(sin(f16_data[i] >> 5)); });
+	bench("cos(Fixed16)", [](int i) { consume(cos(f16_data[i] >> 5)); });
+	bench("tan(Fixed16)", [](int i) { consume(tan(f16_data[i] >> 8)); });
+	bench("sin_poly(Fixed16)", [](int i) { consume(sin_poly(f16_data[i] >> 5)); });
+	bench("sin_lut(Fixed16)", [](int i) { consume(sin_lut(f16_data[i] >> 5)); });
+	bench("cos_poly(Fixed16)", [](int i) { consume(cos_poly(f16_data[i] >> 5)); });
+	bench("cos_lut(Fixed16)", [](int i) { consume(cos_lut(f16_data[i] >> 5)); });
+	bench("sin_poly + cos_poly", [](int i) { consume(sin_poly(f16_data[i] >> 5)); consume(cos_poly(f16_data[i] >> 5)); });
+	bench("sincos_poly(Fixed16)", [](int i) { Fixed16 s, c; sincos_poly(f16_data[i] >> 5, s, c); consume(s); consume(c); });
+	bench("sincos_lut(Fixed16)", [](int i) { Fixed16 s, c; sincos_lut(f16_data[i] >> 5, s, c); consume(s); consume(c); });
+	bench("FixedCordic<16>::sincos", [](int i) { Fixed16 s, c; FixedCordic<16>::sincos(f16_data[i] >> 5, s, c); consume(s); consume(c); });
+	bench("sincos_turns(f_uint32)", [](int i) { Fixed16 s, c; sincos_turns(f_uint32(f16_data[i].Raw()) << 8, s, c); consume(s); consume(c); });
+
+	/* A carrier at 0.1 cycles a sample, by hand and from an NCO */
+	static Fixed16 carrier_phase;
+	static FixedNco lo(FixedNco::step_for(Fixed16::FromRaw(6554)));
+	bench("carrier by sincos_lut + phase reduction", [](int) {
+		Fixed16 s, c;
+		sincos_lut(carrier_phase, s, c);
+		carrier_phase += Fixed16::FromRaw(41177);
+		if (carrier_phase > Fixed16::PI())
+			carrier_phase -= Fixed16::PI() << 1;
+		consume(s);
+		consume(c);
+	});
+	bench("FixedNco::next", [](int) { Fixed16 s, c; lo.next(s, c); consume(s); consume(c); });
+	record(std::string("FixedNco::generate [") + FixedNco::kernel() + "]", time_per_op([]() {
+		lo.generate(f16_out, phase_out, N_DATA);
+		consume(f16_out[sink & (N_DATA - 1)]);
+	}));
+	bench("arcsin(Fixed16)", [](int i) { consume(arcsin(f16_data[i] >> 7)); });
+	bench("arccos(Fixed16)", [](int i) { consume(arccos(f16_data[i] >> 7)); });
+	bench("arctan(Fixed16)", [](int i) { consume(arctan(f16_data[i])); });
+	bench("arctan2(Fixed16)", [](int i) { consume(arctan2(f16_data[i], f16_data[next(i)])); });
+	bench("FixedCordic<16>::arctan2", [](int i) { consume(FixedCordic<16>::arctan2(f16_data[i], f16_data[next(i)])); });
+	bench("FixedCordic<16>::arctan2 + r", [](int i) { Fixed16 r; consume(FixedCordic<16>::arctan2(f16_data[i] >> 1, f16_data[next(i)] >> 1, r)); consume(r); });
+	bench("deg_to_rad(Fixed16)", [](int i) { consume(deg_to_rad(f16_data[i])); });
+	bench("rad_to_deg(Fixed16)", [](int i) { consume(rad_to_deg(f16_data[i] >> 2)); });
+
+	bench("FixedVector + FixedVector", [](int i) { consume(vec_data[i] + vec_data[next(i)]); });
+	bench("FixedVector * Fixed16", [](int i) { consume(vec_data[i] * f16_data[next(i)]); });
+	bench("FixedVector / Fixed16", [](int i) { consume(vec_data[i] / nonzero(next(i))); });
+	bench("dot(FixedVector)", [](int i) { consume(dot(vec_data[i], vec_data[next(i)])); });
+	bench("cross(FixedVector)", [](int i) { consume(cross(vec_data[i], vec_data[next(i)])); });
+	bench("norm(FixedVector)", [](int i) { consume(norm(vec_data[i])); });
+	bench("norm2(FixedVector)", [](int i) { consume(norm2(vec_data[i])); });
+	bench("normalise(FixedVector)", [](int i) { consume(normalise(vec_data[i])); });
+	bench("normalise(FixedVector) (maxElement)", [](int i) { consume(normalise_max(vec_data[i])); });
+	bench("norm2_wide(FixedVector)", [](int i) { consume(norm2_wide(vec_data[i])); });
+	bench("FixedVector::Rotate3D", [](int i) { consume(vec_data[i].Rotate3D(quat_data[next(i)])); });
+
+	bench("FixedComplex * FixedComplex", [](int i) { consume(cpx_data[i] * cpx_data[next(i)]); });
+	bench("mult3(FixedComplex)", [](int i) { consume(mult3(cpx_data[i], cpx_data[next(i)])); });
+	bench("conj_mult(FixedComplex)", [](int i) { consume(conj_mult(cpx_data[i], cpx_data[next(i)])); });
+	bench("complex product with Fixed16 * Fixed16", [](int i) {
+		const FixedComplex& a = cpx_data[i];
+		const FixedComplex& b = cpx_data[next(i)];
+		consume(a.re * b.re - a.im * b.im);
+		consume(a.re * b.im + a.im * b.re);
+	});
+	bench("abs(FixedComplex)", [](int i) { consume(abs(cpx_data[i])); });
+	bench("arg(FixedComplex)", [](int i) { consume(arg(cpx_data[i])); });
+	bench("abs + arg(FixedComplex)", [](int i) { consume(abs(cpx_data[i])); consume(arg(cpx_data[i])); });
+	bench("polar(FixedComplex)", [](int i) { Fixed16 r; consume(polar(cpx_data[i], r)); consume(r); });
+	bench("FixedComplex::from_polar", [](int i) { consume(FixedComplex::from_polar(f16_data[i] >> 7, f16_data[next(i)] >> 5)); });
+
+	bench("FixedMatrix + FixedMatrix", [](int i) { consume(mat_data[i] + mat_data[next(i)]); });
+	bench("FixedMatrix * FixedMatrix", [](int i) { consume(mat_data[i] * mat_data[next(i)]); });
+	bench("FixedMatrix * FixedVector", [](int i) { consume(mat_data[i] * vec_data[next(i)]); });
+	bench("FixedMatrix / Fixed16", [](int i) { consume(mat_data[i] / nonzero(next(i))); });
+	bench("det(FixedMatrix)", [](int i) { consume(det(mat_data[i])); });
+	bench("inv(FixedMatrix)", [](int i) { consume(inv(mat_data[i])); });
+	bench("inv(FixedMatrix, FixedMatrix&)", [](int i) { FixedMatrix r; inv(mat_data[i], r); consume(r); });
+	bench("solve(FixedMatrix, FixedVector)", [](int i) { FixedVector x; solve(mat_data[i], vec_data[next(i)], x); consume(x); });
+	bench("solve(FixedMatrixN<6,6>, 6x1)", [](int i) { FixedMatrixN<6,1> x; solve(spd6_data[i & (N_MATN - 1)], rhs6_data[next(i) & (N_MATN - 1)], x); consume(x); });
+	bench("solve_spd(FixedMatrixN<6,6>, 6x1)", [](int i) { FixedMatrixN<6,1> x; solve_spd(spd6_data[i & (N_MATN - 1)], rhs6_data[next(i) & (N_MATN - 1)], x); consume(x); });
+	bench("inv(FixedMatrixN<6,6>)", [](int i) { FixedMatrixN<6,6> r; inv(spd6_data[i & (N_MATN - 1)], r); consume(r); });
+	bench("trans(FixedMatrix)", [](int i) { consume(trans(mat_data[i])); });
+	bench("cofact(FixedMatrix)", [](int i) { consume(cofact(mat_data[i])); });
+	bench("FixedMatrixN<3,3> * FixedMatrixN<3,3>", [](int i) { consume(mat_data[i].toN() * mat_data[next(i)].toN()); });
+	bench("FixedMatrixN<6,6> * FixedMatrixN<6,6>", [](int i) { consume(mat6_data[i & (N_MATN - 1)] * mat6_data[next(i) & (N_MATN - 1)]); });
+	bench("FixedMatrixN<12,12> * FixedMatrixN<12,12>", [](int i) { consume(mat12_data[i & (N_MATN - 1)] * mat12_data[next(i) & (N_MATN - 1)]); });
+	bench("getrotmat", [](int i) { Fixed16 a(f16_data[i] >> 5), b(f16_data[next(i)] >> 5), c(f16_data[next(next(i))] >> 5); consume(getrotmat(a, b, c)); });
+	bench("get_eulers", [](int i) { consume(get_eulers(mat_data[i])); });
+
+	bench("Quaternion * Quaternion", [](int i) { consume(quat_data[i] * quat_data[next(i)]); });
+	bench("Quaternion::conjugate", [](int i) { consume(Quaternion::conjugate(quat_data[i])); });
+	bench("Quaternion::normalize", [](int i) { consume(Quaternion::normalize(quat_data[i])); });
+	bench("Quaternion::from_euler", [](int i) { Fixed16 a(f16_data[i] >> 5), b(f16_data[next(i)] >> 5), c(f16_data[next(next(i))] >> 5); consume(Quaternion::from_euler(a, b, c)); });
+	bench("Quaternion::get_euler", [](int i) { Fixed16 a, b, c; quat_data[i].get_euler(a, b, c); consume(a); consume(b); consume(c); });
+
+	bench_batch("Fixed16 * Fixed16", f16_data, f16_out, [](const Fixed16& x) { return x * x; });
+	bench_batch("reciprocal(Fixed16)", f16_data, f16_out, [](const Fixed16& x) { return reciprocal(Fixed16::FromRaw(x.Raw() | 1)); });
+	bench_batch("Fixed16 / Fixed16(1000)", f16_data, f16_out, [](const Fixed16& x) { return x / Fixed16(1000); });
+	bench_batch("Fixed16 / Fixed16Divider(1000)", f16_data, f16_out, [](const Fixed16& x) { static const Fixed16Divider by(Fixed16(1000)); return x / by; });
+	bench_batch("invsqrt(Fixed16)", f16_data, f16_out, [](const Fixed16& x) { return invsqrt(Fixed16::FromRaw(abs(x).Raw() | 1)); });
+	bench_batch("sqrt(Fixed16)", f16_data, f16_out, [](const Fixed16& x) { return sqrt(abs(x)); });
+	bench_batch("sin(Fixed16)", f16_data, f16_out, [](const Fixed16& x) { return sin(x >> 5); });
+	bench_batch("cos(Fixed16)", f16_data, f16_out, [](const Fixed16& x) { return cos(x >> 5); });
+	bench_batch("norm(FixedVector)", vec_data, f16_out, [](const FixedVector& v) { return norm(v); });
+	bench_batch("normalise(FixedVector)", vec_data, vec_out, [](const FixedVector& v) { return normalise(v); });
+	bench_batch("conj_mult(FixedComplex)", cpx_data, cpx_out, [](const FixedComplex& z) { return conj_mult(z, cpx_data[0]); });
+	bench_batch("FixedMatrix * FixedVector", vec_data, vec_out, [](const FixedVector& v) { return mat_data[0] * v; });
+	bench_batch("FixedVector::Rotate3D", vec_data, vec_out, [](const FixedVector& v) { return v.Rotate3D(quat_data[0]); });
+
+	bench_vector_batch("add(FixedVectorBatch)", []() { add(batch_a, batch_b, batch_out); });
+	bench_vector_batch("scale(FixedVectorBatch)", []() { scale(batch_a, f16_data[0], batch_out); });
+	bench_vector_batch("dot(FixedVectorBatch)", []() { dot(batch_a, batch_b, f16_out); consume(f16_out[sink & (N_DATA - 1)]); });
+	bench_vector_batch("cross(FixedVectorBatch)", []() { cross(batch_a, batch_b, batch_out); });
+	bench_vector_batch("norm2(FixedVectorBatch)", []() { norm2(batch_a, f16_out); consume(f16_out[sink & (N_DATA - 1)]); });
+	bench_vector_batch("norm(FixedVectorBatch)", []() { norm(batch_a, f16_out); consume(f16_out[sink & (N_DATA - 1)]); });
+	bench_vector_batch("normalise(FixedVectorBatch)", []() { normalise(batch_a, batch_out); });
+	bench_vector_batch("mult(FixedMatrix, FixedVectorBatch)", []() { mult(mat_data[0], batch_a, batch_out); });
+	bench_vector_batch("rotate_many(FixedVectorBatch)", []() { rotate_many(quat_data[0], batch_a, batch_out); });
+	bench_complex_batch("mult(FixedComplexBatch)", []() { mult(cpx_batch_a, cpx_batch_b, cpx_batch_out); });
+	bench_complex_batch("mult(FixedComplexBatch, FixedComplex)", []() { mult(cpx_batch_a, cpx_data[0], cpx_batch_out); });
+	bench_complex_batch("conj_mult(FixedComplexBatch)", []() { conj_mult(cpx_batch_a, cpx_batch_b, cpx_batch_out); });
+	bench_complex_batch("polar(FixedComplexBatch)", []() { polar(cpx_batch_a, f16_out, phase_out); consume(phase_out[sink & (N_DATA - 1)]); });
+	bench("rotate_many(FixedVector*)", [](int i) {
+		if (i == 0)
+			rotate_many(quat_data[0], vec_data, vec_out, N_DATA);
+		consume(vec_out[i].x);
+	});
+
+	bench_fir<8>();
+	bench_fir<16>();
+	bench_fir<32>();
+	bench_fir<64>();
+	bench("FIR<16> with Fixed16 * Fixed16", [](int i) {
+		Fixed16 y;
+		for (int k = 0; k < 16; k++)
+			y += f16_data[(i - k) & (N_DATA - 1)] * (f16_data[k] >> 8);
+		consume(y);
+	});
+
+	bench_biquad<4,1>(true);
+	bench_biquad<4,1>(false);
+	bench_biquad<4,2>(true);
+	bench_biquad<4,8>(true);
+
+	bench_fft<64>();
+	bench_fft<256>();
+	bench_fft<1024>();
+	bench_fft<4096>();
+	bench_fft<16384>();
+	bench_fft<65536>();
+
+	bench_batch("FixedMatrix * FixedMatrix", mat_data, mat_out, [](const FixedMatrix& m) { return m * mat_data[0]; });
+	bench_batch("Quaternion * Quaternion", quat_data.data(), quat_out.data(), [](const Quaternion& q) { return q * quat_data[0]; });
+}
+
+static void run_accuracy_sweeps()
+{
+	const double pi = 3.14159265358979323846;
+
+	sweep("sqrt(Fixed16)", [](const Fixed16& x) { return sqrt(x); }, [](double x) { return std::sqrt(x); }, 0, RAW_MAX);
+	sweep("invsqrt(Fixed16)", [](const Fixed16& x) { return invsqrt(x); }, [](double x) { return 1.0 / std::sqrt(x); }, 1, RAW_MAX);
+	sweep("reciprocal(Fixed16)", [](const Fixed16& x) { return reciprocal(x); }, [](double x) { return (x == 0) ? 0.0 : 1.0 / x; }, RAW_MIN, RAW_MAX);
+	sweep("round(Fixed16)", [](const Fixed16& x) { return round(x); }, [](double x) { return std::round(x); }, RAW_MIN, RAW_MAX);
+	sweep("sin(Fixed16)", [](const Fixed16& x) { return sin(x); }, [](double x) { return std::sin(x); }, raw(-2 * pi), raw(2 * pi));
+	sweep("cos(Fixed16)", [](const Fixed16& x) { return cos(x); }, [](double x) { return std::cos(x); }, raw(-2 * pi), raw(2 * pi));
+	sweep("tan(Fixed16)", [](const Fixed16& x) { return tan(x); }, [](double x) { return std::tan(x); }, raw(-pi / 4), raw(pi / 4));
+	sweep("sin_poly(Fixed16)", [](const Fixed16& x) { return sin_poly(x); }, [](double x) { return std::sin(x); }, raw(-6.28), raw(6.28));
+	sweep("cos_poly(Fixed16)", [](const Fixed16& x) { return cos_poly(x); }, [](double x) { return std::cos(x); }, raw(-2 * pi), raw(2 * pi));
+	sweep("tan_poly(Fixed16)", [](const Fixed16& x) { return tan_poly(x); }, [](double x) { return std::tan(x); }, raw(0), raw(pi / 4));
+	sweep("sin_lut(Fixed16)", [](const Fixed16& x) { return sin_lut(x); }, [](double x) { return std::sin(x); }, RAW_MIN, RAW_MAX);
+	sweep("cos_lut(Fixed16)", [](const Fixed16& x) { return cos_lut(x); }, [](double x) { return std::cos(x); }, RAW_MIN, RAW_MAX);
+	sweep("tan_lut(Fixed16)", [](const Fixed16& x) { return tan_lut(x); }, [](double x) { return std::tan(x); }, raw(-pi / 4), raw(pi / 4));
+	sweep("FixedCordic<16> sin", [](const Fixed16& x) { Fixed16 s, c; FixedCordic<16>::sincos(x, s, c); return s; }, [](double x) { return std::sin(x); }, raw(-2 * pi), raw(2 * pi));
+	sweep("FixedCordic<16> cos", [](const Fixed16& x) { Fixed16 s, c; FixedCordic<16>::sincos(x, s, c); return c; }, [](double x) { return std::cos(x); }, raw(-2 * pi), raw(2 * pi));
+	sweep("arcsin(Fixed16)", [](const Fixed16& x) { return arcsin(x); }, [](double x) { return std::asin(x); }, raw(-1), raw(1));
+	sweep("arccos(Fixed16)", [](const Fixed16& x) { return arccos(x); }, [](double x) { return std::acos(x); }, raw(-1), raw(1));
+	sweep("arctan(Fixed16)", [](const Fixed16& x) { return arctan(x); }, [](double x) { return std::atan(x); }, RAW_MIN, RAW_MAX);
+	sweep("deg_to_rad(Fixed16)", [](const Fixed16& x) { return deg_to_rad(x); }, [&pi](double x) { return x * pi / 180; }, RAW_MIN, RAW_MAX);
+	sweep("rad_to_deg(Fixed16)", [](const Fixed16& x) { return rad_to_deg(x); }, [&pi](double x) { return x * 180 / pi; }, raw(-571), raw(571));
+}
+
+static const char* backend()
+{
+#ifdef NATIVE_64BIT
+	return "native";
+#else
+	return "two-word";
+#endif
+}
+
+static void print_text()
+{
+#ifdef NATIVE_64BIT
+	printf("f_int64 backend: native int64_t\n");
+#else
+	printf("f_int64 backend: two 32-bit words\n");
+#endif
+
+	for (size_t i = 0; i < timings.size(); i++)
+		printf("%-36s %8.2f ns/op %12.0f ops/s\n", timings[i].name.c_str(), timings[i].ns, 1e9 / timings[i].ns);
+
+	if (!accuracies.empty())
+		printf("\n%-36s %10s %10s %10s %12s\n", "error against double (ULP)", "inputs", "max", "mean", "worst at");
+	for (size_t i = 0; i < accuracies.size(); i++)
+	{
+		const accuracy_result& a = accuracies[i];
+		printf("%-36s %10lld %10.3f %10.4f %12.6f\n", a.name.c_str(), a.inputs, a.max_ulp, a.mean_ulp,
+			Fixed16::FromRaw(a.worst).toDouble());
+	}
+}
+
+static void print_csv()
+{
+	printf("backend,kind,name,ns_per_op,ops_per_s,from,to,inputs,max_ulp,mean_ulp,worst_raw\n");
+	for (size_t i = 0; i < timings.size(); i++)
+		printf("%s,timing,\"%s\",%.3f,%.0f,,,,,,\n", backend(), timings[i].name.c_str(), timings[i].ns, 1e9 / timings[i].ns);
+	for (size_t i = 0; i < accuracies.size(); i++)
+	{
+		const accuracy_result& a = accuracies[i];
+		printf("%s,accuracy,\"%s\",,,%d,%d,%lld,%.4f,%.6f,%d\n", backend(), a.name.c_str(),
+			a.from, a.to, a.inputs, a.max_ulp, a.mean_ulp, a.worst);
+	}
+}
+
+static void print_json()
+{
+	printf("{\n  \"backend\": \"%s\",\n  \"timing\": [", backend());
+	for (size_t i = 0; i < timings.size(); i++)
+		printf("%s\n    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ops_per_s\": %.0f}", i ? "," : "",
+			timings[i].name.c_str(), timings[i].ns, 1e9 / timings[i].ns);
+	printf("\n  ],\n  \"accuracy\": [");
+	for (size_t i = 0; i < accuracies.size(); i++)
+	{
+		const accuracy_result& a = accuracies[i];
+		printf("%s\n    {\"name\": \"%s\", \"from\": %d, \"to\": %d, \"inputs\": %lld, \"max_ulp\": %.4f, \"mean_ulp\": %.6f, \"worst_raw\": %d}",
+			i ? "," : "", a.name.c_str(), a.from, a.to, a.inputs, a.max_ulp, a.mean_ulp, a.worst);
+	}
+	printf("\n  ]\n}\n");
+}
+
+static int usage(const char* program)
+{
+	fprintf(stderr, "usage: %s [--csv | --json] [--timing | --accuracy] [--stride N]\n", program);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--csv") == 0)
+			format = FORMAT_CSV;
+		else if (strcmp(argv[i], "--json") == 0)
+			format = FORMAT_JSON;
+		else if (strcmp(argv[i], "--timing") == 0)
+			run_accuracy = false;
+		else if (strcmp(argv[i], "--accuracy") == 0)
+			run_timing = false;
+		else if ((strcmp(argv[i], "--stride") == 0) && (i + 1 < argc) && (atoll(argv[i + 1]) > 0))
+			sweep_stride = atoll(argv[++i]);
+		else
+			return usage(argv[0]);
+	}
+
+	fill_data();
+
+	if (run_timing)
+		run_timings();
+	if (run_accuracy)
+		run_accuracy_sweeps();
+
+	if (format == FORMAT_CSV)
+		print_csv();
+	else if (format == FORMAT_JSON)
+		print_json();
+	else
+		print_text();
+
+	return 0;
+}
@@ -15,19 +15,37 @@ using namespace std;
 #include <cstdlib>
 #include <climits>
 
+#ifdef NATIVE_64BIT
+
+f_int64& f_int64::FromDouble(double d)
+{
+    m_v = (int64_t)d;
+    return *this;
+}
+
+double f_int64::ToDouble() const
+{
+    return (double)m_v;
+}
+
+#else /* NATIVE_64BIT */
+
+/* 2^32. Not ULONG_MAX + 1, which is 2^64 on LP64 hosts. */
+static const double TWO_POW_32 = 4294967296.0;
+
 f_int64& f_int64::FromDouble(double d)
 {
     bool positive = d >= 0;
     d = fabs(d);
-    if ( d <= LONG_MAX )    // fixed from ULONG_MAX
+    if ( d < TWO_POW_32 )
     {
         m_hi = 0;
-        m_lo = (f_int32)d;
+        m_lo = (f_uint32)d;
     }
     else
     {
-        m_hi = (f_uint32)(d / (1.0 + (double)ULONG_MAX));
-        m_lo = (f_uint32)(d - ((double)m_hi * (1.0 + (double)ULONG_MAX)));
+        m_hi = (f_uint32)(d / TWO_POW_32);
+        m_lo = (f_uint32)(d - ((double)m_hi * TWO_POW_32));
     }
 
     if ( !positive )
@@ -39,11 +57,13 @@ f_int64& f_int64::FromDouble(double d)
 double f_int64::ToDouble() const
 {
     double d = m_hi;
-    d *= 1.0 + (double)ULONG_MAX;
+    d *= TWO_POW_32;
     d += m_lo;
     return d;
 }
 
+#endif /* NATIVE_64BIT */
+
 
 template <class Type> void test_result(const char* message, const Type& x, const Type& y)
 {
@@ -99,12 +119,52 @@ void f_int64::testharness()
         test_result("x|y",(x|y), f_int64(123,456));
         test_result("x/8",(x/f_int64(8)), f_int64(0xf, 0x60000000));
     }
+    {
+        f_int64 x(0x12345678,0x9abcdef0);
+        f_int64 y(0x1234,0x56789abc);
+        f_int64 z(-7);
+
+        test_result("x/y",(x/y), f_int64(0x10000));
+        test_result("x%y",(x%y), f_int64(0xdef0));
+        test_result("-x/y",(-x/y), f_int64(-0x10000));
+        test_result("-x%y",(-x%y), f_int64(-0xdef0));
+        test_result("abs(-x)",(-x).abs(), x);
+        test_result("abs(-7)",f_int64(z).abs(), f_int64(7));
+        test_result("abs(y)",f_int64(y).abs(), y);
+        test_result("x/-7",(x/z), f_int64(0xfd663cca,0x33099703));
+        test_result("x%-7",(x%z), f_int64(5));
+        test_result("y/x",(y/x), f_int64(0));
+        test_result("x/x",(x/x), f_int64(1));
+
+        /* Both backends wrap at the ends of the range */
+        const f_int64 max(0x7fffffff, 0xffffffff);
+        const f_int64 min(f_int32(0x80000000), 0);
+        test_result("max+1",(max + f_int64(1)), min);
+        test_result("min-1",(min - f_int64(1)), max);
+        test_result("-min",(-min), min);
+        test_result("min/-1",(min/f_int64(-1)), min);
+        test_result("min%-1",(min%f_int64(-1)), f_int64(0));
+
+        f_uint64 u(0xfedcba98,0x76543210);
+        f_uint64 v(0x80000001,0x00000001);
+        test_result("u/v",(u/v), f_uint64(1));
+        test_result("u%v",(u%v), f_uint64(0x7edcba97,0x7654320f));
+        test_result("u/3",(u/f_uint64(3)), f_uint64(0x54f43e32,0xd21c10b0));
+
+        f_uint64 hi, lo;
+        f_uint64::mult64(u, v, hi, lo);
+        test_result("u*u",(u*u), f_uint64(0xdeec6cd7,0xa44a4100));
+        test_result("hi(u*v)",hi, f_uint64(0x7f6e5d4d,0x3a06d3a1));
+        test_result("lo(u*v)",lo, f_uint64(0x7530eca8,0x76543210));
+    }
 
     cout << "f_int64 testharness complete." << endl << endl;
 }
 
 #endif
 
+#ifndef NATIVE_64BIT
+
  // force the use of the 64-bit multiply
 inline int64_t smull(int32_t a, int32_t b)
 {
@@ -600,14 +660,17 @@ x            B.hi        B.lo
             A.hi B.lo    A.lo B.lo
              B.hi A.lo
     A.hi B.hi
+
+    Only the low 64 bits are kept, so A.hi B.hi drops out and only the
+    low words of the cross terms are needed. In two's complement the low
+    64 bits of the product do not depend on the signs of A and B.
  */
 f_int64& f_int64::operator*=(const f_int64& ll)
 {
-    bool negative = false;
-    
+#ifdef DEBUGGING
     f_int64 A(*this);
     f_int64 B(ll);
-    
+    bool negative = false;
     if (A < 0)
     {
         A.Negate();
@@ -618,73 +681,193 @@ f_int64& f_int64::operator*=(const f_int64& ll)
         B.Negate();
         negative = !negative;
     }
-    
-    f_int64 t1 = mult32(A.m_lo, B.m_lo);
-    f_int64 t2 = mult32(A.m_hi, B.m_lo) + mult32(B.m_hi, A.m_lo);
-    
-#ifdef DEBUGGING
-    f_int64 t3 = mult32(A.m_hi, B.m_hi);
-    if (t3.abs() > 0)
+    f_uint64 hi, lo;
+    f_uint64::mult64(f_uint64(A.m_hi, A.m_lo), f_uint64(B.m_hi, B.m_lo), hi, lo);
+    f_uint64 limit = negative ? f_uint64(0x80000000, 0) : f_uint64(0x7FFFFFFF, 0xFFFFFFFF);
+    if ((hi != 0) || (lo > limit))
     {
         cout << "Error. Overflow in 64-bit multiplication." << endl;
         cout << "A=" << (*this) << " B=" << ll << endl;
         throw -1;
     }
 #endif
-    f_int64 prod = t1 + (t2 << 32);
-    if (negative)
-        prod.Negate();
-    
-    m_hi = prod.m_hi;
-    m_lo = prod.m_lo;
-    return *this;
-#if 0
-    f_int64 t(m_hi, m_lo);
-    f_int64 q(ll.m_hi, ll.m_lo);
+    f_uint64 prod = f_uint64::umult32(m_lo, ll.m_lo);
 
-    m_hi = m_lo = 0;
+    m_hi = prod.GetHi() + (f_uint32)m_hi * ll.m_lo + m_lo * (f_uint32)ll.m_hi;
+    m_lo = prod.GetLo();
+    return *this;
+}
 
-    int32_t counter = 0;
-    do
-    {
-        if ((q.m_lo & 1) != 0)
-            *this += t;
-        q >>= 1;
-        t <<= 1;
-        counter++;
-    }
-    while ((counter < 64) && ((q.m_hi != 0) || (q.m_lo != 0)));
+/*!\brief Long multiplication, as for f_int64.
+ */
+f_uint64& f_uint64::operator*=(const f_uint64& ll)
+{
+    f_uint64 prod = umult32(m_lo, ll.m_lo);
 
+    m_hi = prod.m_hi + m_hi * ll.m_lo + m_lo * ll.m_hi;
+    m_lo = prod.m_lo;
     return *this;
-#endif
 }
 
-/*!\brief Long multiplication
+/*!\brief Full 64x64 -> 128 bit product from four 32x32 partial products.
  */
-f_uint64& f_uint64::operator*=(const f_uint64& ll)
+void f_uint64::mult64(const f_uint64& u, const f_uint64& v, f_uint64& hi, f_uint64& lo)
+{
+    f_uint64 ll = umult32(u.m_lo, v.m_lo);
+    f_uint64 lh = umult32(u.m_lo, v.m_hi);
+    f_uint64 hl = umult32(u.m_hi, v.m_lo);
+    f_uint64 hh = umult32(u.m_hi, v.m_hi);
+
+    // The middle column is less than 3*2^32, its carry goes into hh
+    f_uint64 mid = f_uint64(ll.m_hi) + lh.m_lo + hl.m_lo;
+
+    lo = f_uint64(mid.m_lo, ll.m_lo);
+    hi = hh + lh.m_hi + hl.m_hi + mid.m_hi;
+}
+
+#ifdef NO_64BIT_MULTIPLY
+/*!\brief Calculate the 64-bit product of two unsigned 32 bit words.
+    Knuth's Algorithm M from [Knu2] section 4.3.1 on 16-bit digits.
+*/
+f_uint64 f_uint64::umult32(f_uint32 u, f_uint32 v)
 {
-    f_uint64 t(m_hi, m_lo);
-    f_uint64 q(ll.m_hi, ll.m_lo);
+    f_uint32 u0 = u >> 16;
+    f_uint32 u1 = u & 0xFFFF;
+    f_uint32 v0 = v >> 16;
+    f_uint32 v1 = v & 0xFFFF;
 
-    m_hi = m_lo = 0;
+    f_uint32 t = u1*v1;
+    f_uint32 w3 = t & 0xFFFF;
+    f_uint32 k = t >> 16;
 
-    int32_t counter = 0;
-    do
+    t = u0*v1 + k;
+    f_uint32 w2 = t & 0xFFFF;
+    f_uint32 w1 = t >> 16;
+
+    t = u1*v0 + w2;
+    k = t >> 16;
+
+    return f_uint64(u0*v0 + w1 + k, (t << 16) + w3);
+}
+#endif
+
+// division
+
+/*!\brief Divide the two word number (u1:u0) by v, where u1 < v.
+    Returns the 32-bit quotient and sets r to the remainder.
+
+    x86 has a 64/32 divide instruction and AArch64 a 64/64 one, which
+    we use directly. Elsewhere this is Knuth's Algorithm D ([Knu2] 4.3.1)
+    on 16-bit digits, as given in Hacker's Delight (divlu2), which only
+    needs 32/32 divisions.
+*/
+static inline f_uint32 divlu(f_uint32 u1, f_uint32 u0, f_uint32 v, f_uint32& r)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    f_uint32 q;
+    __asm__("divl %4" : "=a"(q), "=d"(r) : "a"(u0), "d"(u1), "rm"(v));
+    return q;
+#elif defined(__aarch64__)
+    uint64_t u = ((uint64_t) u1 << 32) | u0;
+    f_uint32 q = (f_uint32)(u / v);
+    r = (f_uint32)(u - (uint64_t) q * v);
+    return q;
+#else
+    const f_uint32 b = 65536;
+
+    // Normalize so the top bit of the divisor is set.
+    int s = f_clz32(v);
+    v <<= s;
+    f_uint32 vn1 = v >> 16;
+    f_uint32 vn0 = v & 0xFFFF;
+
+    f_uint32 un32 = (u1 << s) | (s ? (u0 >> (32 - s)) : 0);
+    f_uint32 un10 = u0 << s;
+    f_uint32 un1 = un10 >> 16;
+    f_uint32 un0 = un10 & 0xFFFF;
+
+    // First quotient digit, corrected at most twice.
+    f_uint32 q1 = un32 / vn1;
+    f_uint32 rhat = un32 - q1*vn1;
+    while ((q1 >= b) || (q1*vn0 > b*rhat + un1))
     {
-        if ((q.m_lo & 1) != 0)
-            *this += t;
-        q >>= 1;
-        t <<= 1;
-        counter++;
+        q1 -= 1;
+        rhat += vn1;
+        if (rhat >= b)
+            break;
     }
-    while ((counter < 64) && ((q.m_hi != 0) || (q.m_lo != 0)));
 
-    return *this;
+    f_uint32 un21 = un32*b + un1 - q1*v;
+
+    // Second quotient digit.
+    f_uint32 q0 = un21 / vn1;
+    rhat = un21 - q0*vn1;
+    while ((q0 >= b) || (q0*vn0 > b*rhat + un0))
+    {
+        q0 -= 1;
+        rhat += vn1;
+        if (rhat >= b)
+            break;
+    }
+
+    r = (un21*b + un0 - q0*v) >> s;
+    return q1*b + q0;
+#endif
 }
 
-// division
+/*!\brief Unsigned 64/64 bit division on 32-bit words.
 
-#define IS_MSB_SET(ll)  ((ll.GetHi()) & (1 << (8*sizeof(f_int32) - 1)))
+    Rather than one bit per iteration, the divisor is normalized with a
+    count of leading zeros and the quotient is found with at most two
+    word divisions (divlu) and one correction step (Hacker's Delight,
+    divDU). The divisor must be non-zero.
+*/
+static void udivmod64(f_uint32 nh, f_uint32 nl, f_uint32 dh, f_uint32 dl,
+                      f_uint32& qh, f_uint32& ql, f_uint32& rh, f_uint32& rl)
+{
+    if (dh == 0)
+    {
+        rh = 0;
+        if (nh < dl)
+        {
+            qh = 0;
+            ql = divlu(nh, nl, dl, rl);
+        }
+        else
+        {
+            qh = nh / dl;
+            ql = divlu(nh - qh*dl, nl, dl, rl);
+        }
+        return;
+    }
+
+    // The quotient fits in 32 bits. Estimate it from the normalized
+    // top word of the divisor; the estimate is at most one too large.
+    int n = f_clz32(dh);
+    f_uint32 v1 = (dh << n) | (n ? (dl >> (32 - n)) : 0);
+    f_uint32 r;
+    f_uint32 q = divlu(nh >> 1, (nl >> 1) | (nh << 31), v1, r);
+    q >>= (31 - n);
+    if (q != 0)
+        q--;
+
+    // remainder = n - q*d, which cannot underflow
+    f_uint64 p = f_uint64::umult32(q, dl);
+    f_uint32 pl = p.GetLo();
+    f_uint32 ph = p.GetHi() + q*dh;
+
+    rl = nl - pl;
+    rh = nh - ph - ((nl < pl) ? 1 : 0);
+
+    if ((rh > dh) || ((rh == dh) && (rl >= dl)))
+    {
+        q++;
+        rh = rh - dh - ((rl < dl) ? 1 : 0);
+        rl -= dl;
+    }
+    qh = 0;
+    ql = q;
+}
 
 void f_int64::Divide(const f_int64& divisorIn,
                           f_int64& quotient,
@@ -698,25 +881,6 @@ void f_int64::Divide(const f_int64& divisorIn,
         return;
     }
 
-    // VZ: I'm writing this in a hurry and it's surely not the fastest way to
-    //     do this - any improvements are more than welcome
-    //
-    //     code inspired by the snippet at
-    //          http://www.bearcave.com/software/divide.htm
-    //
-    //     Copyright notice:
-    //
-    //     Use of this program, for any purpose, is granted the author, Ian
-    //     Kaplan, as f_int32 as this copyright notice is included in the source
-    //     code or any source code derived from this program. The user assumes
-    //     all responsibility for using this code.
-
-    // init everything
-    f_uint64 dividend, divisor, remainder;
-
-    quotient = 0l;
-    remainder = 0l;
-
     // always do unsigned division and adjust the signs later: in C integer
     // division, the sign of the remainder is the same as the sign of the
     // dividend, while the sign of the quotient is the product of the signs of
@@ -725,91 +889,32 @@ void f_int64::Divide(const f_int64& divisorIn,
     //      dividend = quotient*divisor + remainder
     //
     // with 0 <= abs(remainder) < abs(divisor)
-    bool negRemainder = GetHi() < 0;
-    bool negQuotient = false;   // assume positive
-    if ( GetHi() < 0 )
-    {
-        negQuotient = !negQuotient;
-        dividend = f_uint64(-*this);
-    } else {
-        dividend = f_uint64(*this);
-    }
-    if ( divisorIn.GetHi() < 0 )
-    {
-        negQuotient = !negQuotient;
-        divisor = f_uint64(-divisorIn);
-    } else {
-        divisor = f_uint64(divisorIn);
-    }
+    bool negRemainder = m_hi < 0;
+    bool negQuotient = negRemainder;
 
-    // check for some particular cases
-    if ( divisor > dividend )
-    {
-        remainder = dividend;
-    }
-    else if ( divisor == dividend )
+    f_int64 dividend(*this);
+    if (negRemainder)
+        dividend.Negate();
+
+    f_int64 divisor(divisorIn);
+    if (divisor.m_hi < 0)
     {
-        quotient = 1l;
+        negQuotient = !negQuotient;
+        divisor.Negate();
     }
-    else
-    {
-        // here: dividend > divisor and both are positive: do unsigned division
-        f_uint32 nBits = 64u;
-        f_uint64 d;
-        f_uint64 oneULL(1);
-        f_int64 oneLL(1);
-
-        while ( remainder < divisor )
-        {
-            remainder <<= 1;
-            if ( IS_MSB_SET(dividend) )
-            {
-                remainder |= oneULL;
-            }
-
-            d = dividend;
-            dividend <<= 1;
 
-            nBits--;
-        }
-
-        // undo the last loop iteration
-        dividend = d;
-        remainder >>= 1;
-        nBits++;
+    f_uint32 qh, ql, rh, rl;
+    udivmod64(dividend.m_hi, dividend.m_lo, divisor.m_hi, divisor.m_lo, qh, ql, rh, rl);
 
-        for ( f_uint32 i = 0; i < nBits; i++ )
-        {
-            remainder <<= 1;
-            if ( IS_MSB_SET(dividend) )
-            {
-                remainder |= oneULL;
-            }
-
-            f_int64 t = remainder - divisor;
-            dividend <<= 1;
-            quotient <<= 1;
-            if ( !IS_MSB_SET(t) )
-            {
-                quotient |= oneLL;
-
-                remainder = f_uint64(t);
-            }
-        }
-    }
-
-    remainderIO = remainder.toLongLong();
+    quotient = f_int64(qh, ql);
+    remainderIO = f_int64(rh, rl);
 
     // adjust signs
     if ( negRemainder )
-    {
-        remainderIO = -(remainder.toLongLong());
-    }
+        remainderIO.Negate();
 
     if ( negQuotient )
-    {
-        quotient = -quotient;
-    }
+        quotient.Negate();
 }
 
 void f_uint64::Divide(const f_uint64& divisorIn,
@@ -824,81 +929,8 @@ void f_uint64::Divide(const f_uint64& divisorIn,
         return;
     }
 
-    // VZ: I'm writing this in a hurry and it's surely not the fastest way to
-    //     do this - any improvements are more than welcome
-    //
-    //     code inspired by the snippet at
-    //          http://www.bearcave.com/software/divide.htm
-    //
-    //     Copyright notice:
-    //
-    //     Use of this program, for any purpose, is granted the author, Ian
-    //     Kaplan, as f_int32 as this copyright notice is included in the source
-    //     code or any source code derived from this program. The user assumes
-    //     all responsibility for using this code.
-
-    // init everything
-    f_uint64 dividend = *this,
-                divisor = divisorIn;
-
-    quotient = 0l;
-    remainder = 0l;
-
-    // check for some particular cases
-    if ( divisor > dividend )
-    {
-        remainder = dividend;
-    }
-    else if ( divisor == dividend )
-    {
-        quotient = 1l;
-    }
-    else
-    {
-        // here: dividend > divisor
-        f_uint32 nBits = 64u;
-        f_uint64 d;
-        f_uint64 oneULL(1);
-        f_int64 oneLL(1);
-
-        while ( remainder < divisor )
-        {
-            remainder <<= 1;
-            if ( IS_MSB_SET(dividend) )
-            {
-                remainder |= oneULL;
-            }
-
-            d = dividend;
-            dividend <<= 1;
-
-            nBits--;
-        }
-
-        // undo the last loop iteration
-        dividend = d;
-        remainder >>= 1;
-        nBits++;
-
-        for ( f_uint32 i = 0; i < nBits; i++ )
-        {
-            remainder <<= 1;
-            if ( IS_MSB_SET(dividend) )
-            {
-                remainder |= oneULL;
-            }
-
-            f_int64 t = remainder - divisor;
-            dividend <<= 1;
-            quotient <<= 1;
-            if ( !IS_MSB_SET(t) )
-            {
-                quotient |= oneULL;
-
-                remainder = f_uint64(t);
-            }
-        }
-    }
+    udivmod64(m_hi, m_lo, divisorIn.m_hi, divisorIn.m_lo,
+              quotient.m_hi, quotient.m_lo, remainder.m_hi, remainder.m_lo);
 }
 
 f_int64 f_int64::operator/(const f_int64& ll) const
@@ -959,12 +991,18 @@ f_uint64 f_uint64::operator%(const f_uint64& ll) const
     return remainder;
 }
 
+#endif /* NATIVE_64BIT */
+
 #ifdef IOSTREAMS
 
 ostream& operator<< ( ostream& o, const f_int64& x)
 {
     if (x < 0)
-        return o << "-" << f_uint64(-x);
+    {
+        /* From the words, as -x is still negative for the most negative value */
+        f_int64 m = -x;
+        return o << "-" << f_uint64(f_uint32(m.GetHi()), m.GetLo());
+    }
     return o << f_uint64(x);
 }
 
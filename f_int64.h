@@ -38,12 +38,459 @@ typedef int32_t f_int32;
 typedef uint32_t f_uint32;
 typedef int16_t f_int16;
 
+/*!\brief Count the leading zero bits in a 32-bit word (32 for zero).
+*/
+inline int f_clz32(f_uint32 x)
+{
+    if (x == 0)
+        return 32;
+#if defined(__GNUC__)
+    return __builtin_clz(x);
+#else
+    int n = 0;
+    if ((x & 0xFFFF0000) == 0) { n += 16; x <<= 16; }
+    if ((x & 0xFF000000) == 0) { n += 8; x <<= 8; }
+    if ((x & 0xF0000000) == 0) { n += 4; x <<= 4; }
+    if ((x & 0xC0000000) == 0) { n += 2; x <<= 2; }
+    if ((x & 0x80000000) == 0) { n += 1; }
+    return n;
+#endif
+}
+
 #ifdef IOSTREAMS
     #include <iostream>
     #define DEBUG_ASSERT_MESS(a__,mess__) { if (!(a__)) { std::cout << __FILE__ << ":" << __LINE__ << ": Assert " << mess__ << std::endl; throw -1; } }
 #endif
+
+/*
+    Backend selection.
+
+    By default f_int64 and f_uint64 are built from two 32-bit words, which
+    is what the ARM7 targets this library was written for need. Define
+    NATIVE_64BIT on hosts with 64-bit registers (x86-64, AArch64) to make
+    both classes thin inline wrappers around int64_t/uint64_t instead.
+    The public interface (including GetHi()/GetLo()) is identical, and
+    NO_64BIT_MULTIPLY only has an effect on the two-word backend.
+
+    With the native backend, f_int128/f_uint128 are available for wide
+    intermediates on compilers that support __int128.
+*/
+#if defined(NATIVE_64BIT) && defined(__SIZEOF_INT128__)
+    #define F_HAS_INT128 1
+    typedef __int128 f_int128;
+    typedef unsigned __int128 f_uint128;
+#endif
+
 class f_uint64;
 
+#ifdef NATIVE_64BIT
+
+/*!\brief    Class for a 64-bit signed integer (native backend).
+
+    This is needed to handle the product of two Fixed16 objects.
+*/
+class f_int64
+{
+public:
+    constexpr f_int64()
+        :    m_v(0)
+    { }
+
+    constexpr explicit f_int64(const f_int32& l)
+        :    m_v(l)
+    { }
+
+    constexpr explicit f_int64(const f_int32& hi, const f_uint32& lo)
+        :    m_v((int64_t)(((uint64_t)(f_uint32)hi << 32) | lo))
+    { }
+
+    f_int64& operator=(const f_int32& l)
+    {
+        m_v = l;
+        return *this;
+    }
+
+#ifdef IOSTREAMS
+    f_int64& FromDouble(double d);
+    double ToDouble() const;
+#endif
+
+    constexpr f_int32 GetHi() const { return (f_int32)(m_v >> 32); }
+    constexpr f_uint32 GetLo() const { return (f_uint32)m_v; }
+
+    /*!\brief Get the absolute value */
+    f_int64 abs() const { return f_int64(*this).abs(); }
+    f_int64& abs()
+    {
+        if ( m_v < 0 )
+            m_v = (int64_t)(0 - (uint64_t)m_v);
+        return *this;
+    }
+
+    /*!\brief Convert to a signed 32-bit integer.
+    \throw int32_t exception if the conversion will overflow.
+    */
+    constexpr f_int32 toInt32() const
+    {
+#ifdef IOSTREAMS
+        if ( !((GetHi() == 0l) || (GetHi() == -1l)))
+        {
+            std::cout << "f_int64 (" << *this << ") f_int32 conversion: loss of precision hi=" << GetHi() << std::endl;
+            throw -1;
+        }
+#endif
+        return (f_int32)m_v;
+    }
+
+    /*!\brief Multiply two 32-bit integers. */
+    constexpr static f_int64 mult32(f_int32 u, f_int32 v)
+    {
+        return FromNative((int64_t) u * (int64_t) v);
+    }
+
+    /* Sums and differences are taken in uint64_t so that they wrap, as the two-word backend does */
+    f_int64 operator+(const f_int64& ll) const { return FromNative((int64_t)((uint64_t)m_v + (uint64_t)ll.m_v)); }
+    f_int64& operator+=(const f_int64& ll) { m_v = (int64_t)((uint64_t)m_v + (uint64_t)ll.m_v); return *this; }
+    f_int64 operator+(f_int32 l) const { return FromNative((int64_t)((uint64_t)m_v + (uint64_t)(int64_t)l)); }
+    f_int64& operator+=(f_int32 l) { m_v = (int64_t)((uint64_t)m_v + (uint64_t)(int64_t)l); return *this; }
+
+    f_int64& operator++() { m_v = (int64_t)((uint64_t)m_v + 1); return *this; }
+    f_int64& operator++(int32_t) { return ++(*this); }
+
+        // negation operator
+    f_int64 operator-() const { return FromNative((int64_t)(0 - (uint64_t)m_v)); }
+    f_int64& Negate() { m_v = (int64_t)(0 - (uint64_t)m_v); return *this; }
+
+    f_int64 operator-(const f_int64& ll) const { return FromNative((int64_t)((uint64_t)m_v - (uint64_t)ll.m_v)); }
+    f_int64& operator-=(const f_int64& ll) { m_v = (int64_t)((uint64_t)m_v - (uint64_t)ll.m_v); return *this; }
+
+        // pre decrement operator
+    f_int64& operator--() { m_v = (int64_t)((uint64_t)m_v - 1); return *this; }
+
+        // post decrement operator
+    f_int64& operator--(int32_t) { return --(*this); }
+
+    /*!\brief Shift left */
+    constexpr f_int64 operator<<(int32_t shift) const { return FromNative((int64_t)((uint64_t)m_v << shift)); }
+    f_int64& operator<<=(int32_t shift) { m_v = (int64_t)((uint64_t)m_v << shift); return *this; }
+
+    /*!\brief Shift right */
+    constexpr f_int64 operator>>(int32_t shift) const { return FromNative(m_v >> shift); }
+    f_int64& operator>>=(int32_t shift) { m_v >>= shift; return *this; }
+
+    /*!\brief Bitwise AND. */
+    f_int64 operator&(const f_int64& ll) const { return FromNative(m_v & ll.m_v); }
+    f_int64& operator&=(const f_int64& ll) { m_v &= ll.m_v; return *this; }
+
+    /*!\brief Bitwise OR. */
+    f_int64 operator|(const f_int64& ll) const { return FromNative(m_v | ll.m_v); }
+    f_int64& operator|=(const f_int64& ll) { m_v |= ll.m_v; return *this; }
+
+    /*!\brief Bitwise XOR. */
+    f_int64 operator^(const f_int64& ll) const { return FromNative(m_v ^ ll.m_v); }
+    f_int64& operator^=(const f_int64& ll) { m_v ^= ll.m_v; return *this; }
+
+    /*!\brief Bitwise NOT. */
+    f_int64 operator~() const { return FromNative(~m_v); }
+
+    constexpr bool operator==(const f_int64& ll) const { return m_v == ll.m_v; }
+    constexpr bool operator!=(const f_int64& ll) const { return m_v != ll.m_v; }
+    constexpr bool operator<(const f_int64& ll) const { return m_v < ll.m_v; }
+    constexpr bool operator>(const f_int64& ll) const { return m_v > ll.m_v; }
+    constexpr bool operator<=(const f_int64& ll) const { return m_v <= ll.m_v; }
+    constexpr bool operator>=(const f_int64& ll) const { return m_v >= ll.m_v; }
+
+    bool operator<(f_int32 l) const { return m_v < l; }
+    bool operator>(f_int32 l) const { return m_v > l; }
+    bool operator==(f_int32 l) const { return m_v == l; }
+    bool operator<=(f_int32 l) const { return m_v <= l; }
+    bool operator>=(f_int32 l) const { return m_v >= l; }
+
+    // multiplication
+    f_int64 operator*(const f_int64& ll) const
+    {
+        f_int64 res(*this);
+        res *= ll;
+        return res;
+    }
+    f_int64& operator*=(const f_int64& ll)
+    {
+#if defined(DEBUGGING) && defined(F_HAS_INT128)
+        f_int128 wide = (f_int128)m_v * (f_int128)ll.m_v;
+        if ((wide > INT64_MAX) || (wide < INT64_MIN))
+        {
+            std::cout << "Error. Overflow in 64-bit multiplication." << std::endl;
+            std::cout << "A=" << (*this) << " B=" << ll << std::endl;
+            throw -1;
+        }
+#endif
+        m_v = (int64_t)((uint64_t)m_v * (uint64_t)ll.m_v);
+        return *this;
+    }
+
+    // division
+    f_int64 operator/(const f_int64& ll) const
+    {
+        f_int64 quotient, remainder;
+        Divide(ll, quotient, remainder);
+        return quotient;
+    }
+    f_int64& operator/=(const f_int64& ll)
+    {
+        f_int64 remainder;
+        Divide(ll, *this, remainder);
+        return *this;
+    }
+
+    f_int64 operator%(const f_int64& ll) const
+    {
+        f_int64 quotient, remainder;
+        Divide(ll, quotient, remainder);
+        return remainder;
+    }
+
+    void Divide(const f_int64& divisor,
+                f_int64& quotient,
+                f_int64& remainder) const
+    {
+        if (divisor.m_v == 0)
+        {
+#ifdef DEBUGGING
+            throw -1;
+#endif
+            return;
+        }
+        if (divisor.m_v == -1)
+        {
+            /* INT64_MIN / -1 wraps back to INT64_MIN, as in the two-word backend */
+            quotient = -(*this);
+            remainder.m_v = 0;
+            return;
+        }
+        int64_t q = m_v / divisor.m_v;
+        remainder.m_v = m_v - q * divisor.m_v;
+        quotient.m_v = q;
+    }
+
+    /*!\brief The underlying native integer. */
+    constexpr int64_t toNative() const { return m_v; }
+    constexpr static f_int64 FromNative(int64_t v)
+    {
+        f_int64 ret;
+        ret.m_v = v;
+        return ret;
+    }
+
+#ifdef IOSTREAMS
+    static void testharness();
+    friend std::ostream& operator<<(std::ostream&, const f_int64&);
+#endif
+
+private:
+    int64_t m_v;
+};
+
+
+/*!\brief    Class for a 64-bit unsigned integer (native backend).
+*/
+class f_uint64
+{
+public:
+    f_uint64()
+        :    m_v(0)
+    { }
+
+    explicit f_uint64(const f_uint32& l)
+        :    m_v(l)
+    { }
+
+    explicit f_uint64(const f_uint32& hi, const f_uint32& lo)
+        :    m_v(((uint64_t)hi << 32) | lo)
+    { }
+
+    explicit f_uint64(const f_int64& ll)
+        :    m_v((uint64_t)ll.toNative())
+    {
+#ifdef IOSTREAMS
+        if (ll.GetHi() < 0)
+        {
+            std::cout << "f_uint64 constructed from negative number " << ll.GetHi() << std::endl;
+            throw -1;
+        }
+#endif
+    }
+
+    f_uint64& operator=(const f_uint32& l)
+    {
+        m_v = l;
+        return *this;
+    }
+
+    f_uint32 GetHi() const { return (f_uint32)(m_v >> 32); }
+    f_uint32 GetLo() const { return (f_uint32)m_v; }
+
+        // convert to f_int32 with range checking in the debug mode (only!)
+    f_uint32 ToULong() const
+    {
+#ifdef IOSTREAMS
+        DEBUG_ASSERT_MESS( GetHi() == 0ul,
+                    "f_uint64 to f_int32 conversion loss of precision" );
+#endif
+
+        return (f_uint32)m_v;
+    }
+
+    f_uint64 operator+(const f_uint64& ll) const { return FromNative(m_v + ll.m_v); }
+    f_uint64& operator+=(const f_uint64& ll) { m_v += ll.m_v; return *this; }
+    f_uint64 operator+(f_uint32 l) const { return FromNative(m_v + l); }
+    f_uint64& operator+=(f_uint32 l) { m_v += l; return *this; }
+
+        // pre increment operator
+    f_uint64& operator++() { ++m_v; return *this; }
+
+        // post increment operator
+    f_uint64& operator++(int32_t) { return ++(*this); }
+
+        // subtraction
+    f_int64 operator-(const f_uint64& ll) const
+    {
+        return f_int64::FromNative((int64_t)(m_v - ll.m_v));
+    }
+    f_uint64& operator-=(const f_uint64& ll) { m_v -= ll.m_v; return *this; }
+
+        // pre decrement operator
+    f_uint64& operator--() { --m_v; return *this; }
+
+        // post decrement operator
+    f_uint64& operator--(int32_t) { return --(*this); }
+
+    // shifts
+        // left shift
+    f_uint64 operator<<(int32_t shift) const { return FromNative(m_v << shift); }
+    f_uint64& operator<<=(int32_t shift) { m_v <<= shift; return *this; }
+
+        // right shift
+    f_uint64 operator>>(int32_t shift) const { return FromNative(m_v >> shift); }
+    f_uint64& operator>>=(int32_t shift) { m_v >>= shift; return *this; }
+
+    // bitwise operators
+    f_uint64 operator&(const f_uint64& ll) const { return FromNative(m_v & ll.m_v); }
+    f_uint64& operator&=(const f_uint64& ll) { m_v &= ll.m_v; return *this; }
+    f_uint64 operator|(const f_uint64& ll) const { return FromNative(m_v | ll.m_v); }
+    f_uint64& operator|=(const f_uint64& ll) { m_v |= ll.m_v; return *this; }
+    f_uint64 operator^(const f_uint64& ll) const { return FromNative(m_v ^ ll.m_v); }
+    f_uint64& operator^=(const f_uint64& ll) { m_v ^= ll.m_v; return *this; }
+    f_uint64 operator~() const { return FromNative(~m_v); }
+
+    // comparison
+    bool operator==(const f_uint64& ll) const { return m_v == ll.m_v; }
+    bool operator!=(const f_uint64& ll) const { return m_v != ll.m_v; }
+    bool operator<(const f_uint64& ll) const { return m_v < ll.m_v; }
+    bool operator>(const f_uint64& ll) const { return m_v > ll.m_v; }
+    bool operator<=(const f_uint64& ll) const { return m_v <= ll.m_v; }
+    bool operator>=(const f_uint64& ll) const { return m_v >= ll.m_v; }
+
+    bool operator<(f_uint32 l) const { return m_v < l; }
+    bool operator>(f_uint32 l) const { return m_v > l; }
+    bool operator==(f_uint32 l) const { return m_v == l; }
+    bool operator<=(f_uint32 l) const { return m_v <= l; }
+    bool operator>=(f_uint32 l) const { return m_v >= l; }
+
+    // multiplication
+    f_uint64 operator*(const f_uint64& ll) const { return FromNative(m_v * ll.m_v); }
+    f_uint64& operator*=(const f_uint64& ll) { m_v *= ll.m_v; return *this; }
+
+    /*!\brief Multiply two unsigned 32-bit integers. */
+    inline static f_uint64 umult32(f_uint32 u, f_uint32 v)
+    {
+        return FromNative((uint64_t) u * (uint64_t) v);
+    }
+
+    /*!\brief Full 64x64 -> 128 bit product.
+        The upper 64 bits of u*v are returned in hi and the lower 64 bits in lo.
+    */
+    static void mult64(const f_uint64& u, const f_uint64& v, f_uint64& hi, f_uint64& lo)
+    {
+#ifdef F_HAS_INT128
+        f_uint128 p = (f_uint128)u.m_v * (f_uint128)v.m_v;
+        f_uint64 h = FromNative((uint64_t)(p >> 64));
+        lo = FromNative((uint64_t)p);
+        hi = h;
+#else
+        uint64_t ll = (uint64_t)(f_uint32)u.m_v * (f_uint32)v.m_v;
+        uint64_t lh = (uint64_t)(f_uint32)u.m_v * (v.m_v >> 32);
+        uint64_t hl = (u.m_v >> 32) * (uint64_t)(f_uint32)v.m_v;
+        uint64_t hh = (u.m_v >> 32) * (v.m_v >> 32);
+
+        // The middle column is less than 3*2^32, its carry goes into hh
+        uint64_t mid = (ll >> 32) + (f_uint32)lh + (f_uint32)hl;
+
+        lo = FromNative((mid << 32) | (f_uint32)ll);
+        hi = FromNative(hh + (lh >> 32) + (hl >> 32) + (mid >> 32));
+#endif
+    }
+
+    // division
+    f_uint64 operator/(const f_uint64& ll) const
+    {
+        f_uint64 quotient, remainder;
+        Divide(ll, quotient, remainder);
+        return quotient;
+    }
+    f_uint64& operator/=(const f_uint64& ll)
+    {
+        f_uint64 remainder;
+        Divide(ll, *this, remainder);
+        return *this;
+    }
+
+    f_uint64 operator%(const f_uint64& ll) const
+    {
+        f_uint64 quotient, remainder;
+        Divide(ll, quotient, remainder);
+        return remainder;
+    }
+
+    void Divide(const f_uint64& divisor,
+                f_uint64& quotient,
+                f_uint64& remainder) const
+    {
+        if (divisor.m_v == 0)
+        {
+#ifdef DEBUGGING
+            throw -1;
+#endif
+            return;
+        }
+        uint64_t q = m_v / divisor.m_v;
+        remainder.m_v = m_v - q * divisor.m_v;
+        quotient.m_v = q;
+    }
+
+    f_int64 toLongLong() const
+    {
+        return f_int64::FromNative((int64_t)m_v);
+    }
+
+    /*!\brief The underlying native integer. */
+    uint64_t toNative() const { return m_v; }
+    static f_uint64 FromNative(uint64_t v)
+    {
+        f_uint64 ret;
+        ret.m_v = v;
+        return ret;
+    }
+
+#ifdef IOSTREAMS
+    friend std::ostream& operator<<(std::ostream&, const f_uint64&);
+#endif // IOSTREAMS
+
+private:
+    uint64_t m_v;
+};
+
+#else /* NATIVE_64BIT */
+
 /*!\brief    Class for a 64-bit signed integer.
 
     This is needed to handle the product of two Fixed16 objects.
@@ -51,13 +498,15 @@ class f_uint64;
 class f_int64
 {
 public:
-    f_int64()
+    constexpr f_int64()
         :    m_hi(0), m_lo(0)
     { }
 
-    explicit f_int64(const f_int32& l) { *this = l; }
+    constexpr explicit f_int64(const f_int32& l)
+        :    m_hi(l < 0 ? -1L : 0L), m_lo(l)
+    { }
 
-    explicit f_int64(const f_int32& hi, const f_uint32& lo)
+    constexpr explicit f_int64(const f_int32& hi, const f_uint32& lo)
         :    m_hi(hi), m_lo(lo)
     { }
 
@@ -76,22 +525,22 @@ public:
     double ToDouble() const;
 #endif
 
-    f_int32 GetHi() const { return m_hi; }
-    f_uint32 GetLo() const { return m_lo; }
+    constexpr f_int32 GetHi() const { return m_hi; }
+    constexpr f_uint32 GetLo() const { return m_lo; }
 
     /*!\brief Get the absolute value */
     f_int64 abs() const { return f_int64(*this).abs(); }
     f_int64& abs()
     {
         if ( m_hi < 0 )
-            m_hi = -m_hi;
+            Negate();
         return *this;
     }
 
     /*!\brief Convert to a signed 32-bit integer.
     \throw int32_t exception if the conversion will overflow.
     */
-    f_int32 toInt32() const
+    constexpr f_int32 toInt32() const
     {
 #ifdef IOSTREAMS
         if ( !((m_hi == 0l) || (m_hi == -1l)))
@@ -108,7 +557,7 @@ public:
 #ifdef NO_64BIT_MULTIPLY
     static f_int64 mult32(f_int32 u, f_int32 v);
 #else
-    inline static f_int64 mult32(f_int32 u, f_int32 v)
+    constexpr static f_int64 mult32(f_int32 u, f_int32 v)
     {
         int64_t ret = (int64_t) u * (int64_t) v;
         return f_int64(long(ret >> 32 & 0xFFFFFFFF), ret & 0xFFFFFFFF);
@@ -160,10 +609,10 @@ public:
     /*!\brief Bitwise NOT. */
     f_int64 operator~() const;
 
-    inline bool operator==(const f_int64& ll) const
+    constexpr bool operator==(const f_int64& ll) const
         { return m_lo == ll.m_lo && m_hi == ll.m_hi; }
 
-    inline bool operator!=(const f_int64& ll) const
+    constexpr bool operator!=(const f_int64& ll) const
         { return !(*this == ll); }
 
     bool operator<(const f_int64& ll) const;
@@ -326,6 +775,22 @@ public:
     f_uint64 operator*(const f_uint64& ll) const;
     f_uint64& operator*=(const f_uint64& ll);
 
+    /*!\brief Multiply two unsigned 32-bit integers. */
+#ifdef NO_64BIT_MULTIPLY
+    static f_uint64 umult32(f_uint32 u, f_uint32 v);
+#else
+    inline static f_uint64 umult32(f_uint32 u, f_uint32 v)
+    {
+        uint64_t ret = (uint64_t) u * (uint64_t) v;
+        return f_uint64((f_uint32)(ret >> 32), (f_uint32)ret);
+    }
+#endif
+
+    /*!\brief Full 64x64 -> 128 bit product.
+        The upper 64 bits of u*v are returned in hi and the lower 64 bits in lo.
+    */
+    static void mult64(const f_uint64& u, const f_uint64& v, f_uint64& hi, f_uint64& lo);
+
     // division
     f_uint64 operator/(const f_uint64& ll) const;
     f_uint64& operator/=(const f_uint64& ll);
@@ -351,6 +816,8 @@ private:
     f_uint32 m_lo;
 };
 
+#endif /* NATIVE_64BIT */
+
 
 // ----------------------------------------------------------------------------
 // binary operators
@@ -19,7 +19,7 @@ int main(int argc, char **argv)
 	c = sqrt(b);
 	c = sin(a/b);
 	
-	c = arctan(tan(Fixed16::PI()/4));
+	c = arctan(tan(div_by<4>(Fixed16::PI())));
 
 	long j = 12;
 	long k = j / 17;
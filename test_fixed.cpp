@@ -9,25 +9,92 @@
 
 
 #include "Fixed.h"
+#include "FixedTrig.h"
+#include "FixedCordic.h"
+#include "FixedNco.h"
 #include "FixedVector.h"
+#include "FixedVectorBatch.h"
+#include "FixedComplex.h"
+#include "FixedComplexBatch.h"
+#include "FixedFir.h"
+#include "FixedBiquad.h"
+#include "FixedFFT.h"
 #include "FixedMatrix.h"
+#include "FixedMatrixN.h"
+#include "FixedSolve.h"
 #include "Quaternion.h"
 
 using namespace std;
 
+/* Run one testharness, so that a failure does not hide the results of the others. */
+template <class Harness> int run_harness(const char* name, Harness harness)
+{
+	try
+	{
+		harness();
+	}
+	catch (int)
+	{
+		cout << name << " testharness FAILED" << endl;
+		return 1;
+	}
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
 	cout << " "  << endl;
 	cout << " "  << endl;
 	
-// 	f_int64::testharness();
-	Fixed16::testharness();
-	Fixed32::testharness();
- 	FixedVector::testharness();
- 	Quaternion::testharness();
-	FixedMatrix::testharness();
+	int failed = 0;
+	failed += run_harness("f_int64", f_int64::testharness);
+	failed += run_harness("Fixed16", Fixed16::testharness);
+	failed += run_harness("Fixed32", Fixed32::testharness);
+	failed += run_harness("FixedTrig", FixedTrig::testharness);
+	failed += run_harness("FixedCordic<16>", FixedCordic<16>::testharness);
+	failed += run_harness("FixedCordic<24>", FixedCordic<24>::testharness);
+	failed += run_harness("FixedNco", FixedNco::testharness);
+	failed += run_harness("FixedQ1_15", FixedQ1_15::testharness);
+	failed += run_harness("FixedQ8_24", FixedQ8_24::testharness);
+	failed += run_harness("FixedQ2_30", FixedQ2_30::testharness);
+	failed += run_harness("Fixed16Sat", Fixed16Sat::testharness);
+	failed += run_harness("Fixed16Trap", Fixed16Trap::testharness);
+	failed += run_harness("FixedVector", FixedVector::testharness);
+	failed += run_harness("FixedVectorBatch", FixedVectorBatch::testharness);
+	failed += run_harness("FixedComplex", FixedComplex::testharness);
+	failed += run_harness("FixedComplexBatch", FixedComplexBatch::testharness);
+	failed += run_harness("FixedFir<1>", FixedFir<1>::testharness);
+	failed += run_harness("FixedFir<7>", FixedFir<7>::testharness);
+	failed += run_harness("FixedFir<16>", FixedFir<16>::testharness);
+	failed += run_harness("FixedFir<33>", FixedFir<33>::testharness);
+	failed += run_harness("FixedFir<16,FixedQ1_15>", FixedFir<16,FixedQ1_15>::testharness);
+	failed += run_harness("FixedFir<8,FixedQ8_24>", FixedFir<8,FixedQ8_24>::testharness);
+	failed += run_harness("FixedBiquadCascade<1,1>", FixedBiquadCascade<1,1>::testharness);
+	failed += run_harness("FixedBiquadCascade<4,1>", FixedBiquadCascade<4,1>::testharness);
+	failed += run_harness("FixedBiquadCascade<2,2>", FixedBiquadCascade<2,2>::testharness);
+	failed += run_harness("FixedBiquadCascade<3,5>", FixedBiquadCascade<3,5>::testharness);
+	failed += run_harness("FixedBiquadCascade<4,8>", FixedBiquadCascade<4,8>::testharness);
+	failed += run_harness("FixedFFT<8>", FixedFFT<8>::testharness);
+	failed += run_harness("FixedFFT<64>", FixedFFT<64>::testharness);
+	failed += run_harness("FixedFFT<1024>", FixedFFT<1024>::testharness);
+	failed += run_harness("FixedFFT<65536>", FixedFFT<65536>::testharness);
+	failed += run_harness("FixedFFT<16,FixedQ1_15>", FixedFFT<16,FixedQ1_15>::testharness);
+	failed += run_harness("FixedFFT<256,FixedQ1_15>", FixedFFT<256,FixedQ1_15>::testharness);
+	failed += run_harness("Quaternion", Quaternion::testharness);
+	failed += run_harness("FixedMatrix", FixedMatrix::testharness);
+	failed += run_harness("FixedMatrixN<3,3>", FixedMatrixN<3,3>::testharness);
+	failed += run_harness("FixedMatrixN<6,6>", FixedMatrixN<6,6>::testharness);
+	failed += run_harness("FixedMatrixN<9,9>", FixedMatrixN<9,9>::testharness);
+	failed += run_harness("FixedMatrixN<12,12>", FixedMatrixN<12,12>::testharness);
+	failed += run_harness("FixedMatrixN<5,7>", FixedMatrixN<5,7>::testharness);
+	failed += run_harness("FixedMatrixN<6,6,FixedQ8_24>", FixedMatrixN<6,6,FixedQ8_24>::testharness);
+	failed += run_harness("FixedLU<3>", FixedLU<3>::testharness);
+	failed += run_harness("FixedLU<6>", FixedLU<6>::testharness);
+	failed += run_harness("FixedLU<12>", FixedLU<12>::testharness);
+	failed += run_harness("FixedLU<6,FixedQ8_24>", FixedLU<6,FixedQ8_24>::testharness);
 
-	return 0;
+	cout << failed << " testharness(es) failed" << endl;
+	return (failed == 0) ? 0 : 1;
 }
 
 